@@ -9,13 +9,67 @@ TEMPLATE = app
 # 源文件
 SOURCES += \
     src/main.cpp \
+    src/startupprofiler.cpp \
+    src/spanprofiler.cpp \
+    src/curlruntime.cpp \
     src/mainwindow.cpp \
     src/proxyclient.cpp \
+    src/proxyoptions.cpp \
+    src/publickeypin.cpp \
+    src/bufferpool.cpp \
+    src/connectionpool.cpp \
+    src/transfercontext.cpp \
+    src/transfereventqueue.cpp \
+    src/tokenbucket.cpp \
+    src/transferscheduler.cpp \
+    src/transfertracer.cpp \
+    src/responsedata.cpp \
+    src/responseview.cpp \
+    src/hexdump.cpp \
+    src/throughputtester.cpp \
+    src/websocketconnection.cpp \
+    src/websocketbenchmark.cpp \
+    src/tlsbenchmark.cpp \
+    src/rangedownloader.cpp \
+    src/downloadjournal.cpp \
+    src/memorycache.cpp \
+    src/responsecache.cpp \
+    src/tunnelrttmonitor.cpp \
+    src/rttchartwidget.cpp \
+    src/rttmonitordialog.cpp \
+    src/appsettings.cpp \
     src/configmanager.cpp
 
 HEADERS += \
+    src/startupprofiler.h \
+    src/spanprofiler.h \
+    src/curlruntime.h \
     src/mainwindow.h \
     src/proxyclient.h \
+    src/proxyoptions.h \
+    src/publickeypin.h \
+    src/bufferpool.h \
+    src/connectionpool.h \
+    src/transfercontext.h \
+    src/transfereventqueue.h \
+    src/tokenbucket.h \
+    src/transferscheduler.h \
+    src/transfertracer.h \
+    src/responsedata.h \
+    src/responseview.h \
+    src/hexdump.h \
+    src/throughputtester.h \
+    src/websocketconnection.h \
+    src/websocketbenchmark.h \
+    src/tlsbenchmark.h \
+    src/rangedownloader.h \
+    src/downloadjournal.h \
+    src/memorycache.h \
+    src/responsecache.h \
+    src/tunnelrttmonitor.h \
+    src/rttchartwidget.h \
+    src/rttmonitordialog.h \
+    src/appsettings.h \
     src/configmanager.h
 
 # 输出目录设置
@@ -48,6 +102,11 @@ win32-msvc* {
     LIBS += -L$$PWD/depend/libcurl/lib -llibcurl
 }
 
+# setsockopt等socket调优需要Winsock
+win32 {
+    LIBS += -lws2_32
+}
+
 # 其他平台配置
 !win32-msvc* {
     LIBS += -L$$PWD/depend/libcurl/lib -llibcurl
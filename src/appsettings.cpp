@@ -0,0 +1,76 @@
+#include "appsettings.h"
+
+const ProxyProfile &AppSettings::active() const
+{
+    // ConfigManager保证至少有一个档案，且activeProfile总是有效
+    const ProxyProfile *p = profile(activeProfile);
+    return p ? *p : profiles.first();
+}
+
+const ProxyProfile *AppSettings::profile(const QString &name) const
+{
+    for (const ProxyProfile &p : profiles) {
+        if (p.name == name) {
+            return &p;
+        }
+    }
+    return nullptr;
+}
+
+QStringList AppSettings::profileNames() const
+{
+    QStringList names;
+    for (const ProxyProfile &p : profiles) {
+        names << p.name;
+    }
+    return names;
+}
+
+ProxyOptions AppSettings::proxyOptions() const
+{
+    return proxyOptions(active());
+}
+
+ProxyOptions AppSettings::proxyOptions(const ProxyProfile &profile) const
+{
+    ProxyOptions options;
+    options.host = profile.proxyHost;
+    options.port = profile.proxyPort;
+    options.username = profile.proxyUsername;
+    options.password = profile.proxyPassword;
+    options.caPath = profile.certificatePath;
+    options.pinnedPublicKey = profile.pinnedPublicKey;
+    options.compression = compressionEnabled;
+    return options;
+}
+
+bool ConfigChanges::isEmpty() const
+{
+    return addedProfiles.isEmpty() && removedProfiles.isEmpty()
+        && endpointChangedProfiles.isEmpty() && caChangedProfiles.isEmpty()
+        && !activeProfileChanged && !otherChanged;
+}
+
+QString ConfigChanges::describe() const
+{
+    QStringList parts;
+    if (!addedProfiles.isEmpty()) {
+        parts << "新增档案 " + addedProfiles.join(", ");
+    }
+    if (!removedProfiles.isEmpty()) {
+        parts << "删除档案 " + removedProfiles.join(", ");
+    }
+    if (!endpointChangedProfiles.isEmpty()) {
+        parts << "代理端点变化 " + endpointChangedProfiles.join(", ");
+    }
+    if (!caChangedProfiles.isEmpty()) {
+        parts << "CA证书变化 " + caChangedProfiles.join(", ");
+    }
+    if (activeProfileChanged) {
+        parts << "当前档案变化";
+    }
+    if (otherChanged) {
+        parts << "其他设置变化";
+    }
+    return parts.isEmpty() ? QString("无变化") : parts.join("; ");
+}
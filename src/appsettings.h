@@ -0,0 +1,77 @@
+#ifndef APPSETTINGS_H
+#define APPSETTINGS_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include "proxyoptions.h"
+
+// 一组命名的代理连接参数，例如测试环境和生产环境各一个
+struct ProxyProfile
+{
+    QString name;
+    QString proxyHost;
+    int     proxyPort { 0 };
+    QString proxyUsername;
+    QString proxyPassword;
+    QString certificatePath;
+    // 首次用CA验证成功后记下的代理公钥（"sha256//<base64>"），之后据此直接核对，空表示尚未固定
+    QString pinnedPublicKey;
+};
+
+// 启动时从config.ini读取一次的类型化配置，以不可变快照的形式共享给其他模块
+struct AppSettings
+{
+    // 代理配置档案，activeProfile指向当前使用的档案
+    QList<ProxyProfile> profiles;
+    QString activeProfile;
+
+    // 网络设置
+    bool    compressionEnabled { true };
+    // POST/PUT上传缓冲区字节数，libcurl接受16 KiB到2 MiB
+    int     uploadBufferSize { 64 * 1024 };
+
+    // 磁盘响应缓存（按RFC 9111判断新鲜度），上限按MiB计
+    bool    cacheEnabled { false };
+    int     cacheMaxSizeMb { 256 };
+    // 磁盘缓存之前的内存LRU，0表示不用；条目最多保留memoryCacheTtlSeconds秒（响应剩余的新鲜时间更短时以其为准）
+    int     memoryCacheMb { 32 };
+    int     memoryCacheTtlSeconds { 30 };
+    // 同一URL的并发GET只访问一次网络
+    bool    coalesceRequests { true };
+
+    // 批量请求调度：每个目标主机/每个代理的最大并发和每秒请求数（0表示不限速）
+    int     hostConcurrency { 4 };
+    int     proxyConcurrency { 16 };
+    double  hostRequestRate { 0 };
+    double  proxyRequestRate { 0 };
+    // 每个代理为交互请求（界面上点击连接）保留的连接数
+    int     interactiveReserved { 2 };
+
+    // 界面设置
+    QString lastUrl;
+    int     windowWidth { 0 };
+    int     windowHeight { 0 };
+
+    const ProxyProfile &active() const;
+    const ProxyProfile *profile(const QString &name) const;
+    QStringList profileNames() const;
+    ProxyOptions proxyOptions() const;
+    ProxyOptions proxyOptions(const ProxyProfile &profile) const;
+};
+
+// 配置文件重新加载前后的差异，网络层据此只重建受影响的部分
+struct ConfigChanges
+{
+    QStringList addedProfiles;
+    QStringList removedProfiles;
+    QStringList endpointChangedProfiles;  // 主机、端口或认证变化
+    QStringList caChangedProfiles;
+    bool activeProfileChanged { false };
+    bool otherChanged { false };
+
+    bool isEmpty() const;
+    QString describe() const;
+};
+
+#endif // APPSETTINGS_H
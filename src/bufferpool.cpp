@@ -0,0 +1,267 @@
+#include "bufferpool.h"
+#include <QDir>
+#include <QMutexLocker>
+#include <cstring>
+
+const qsizetype BufferPool::kSegmentSize = 256 * 1024;
+
+namespace {
+// 缓冲池最多保留的空闲字节数，超出部分直接释放
+const qint64 kMaxPooledBytes = 64LL * 1024 * 1024;
+// 按Content-Length预留的上限，更大的响应退回分段模式
+const qint64 kMaxContiguousReserve = 64LL * 1024 * 1024;
+}
+
+BufferPool &BufferPool::instance()
+{
+    static BufferPool pool;
+    return pool;
+}
+
+QByteArray BufferPool::acquire(qsizetype capacity)
+{
+    {
+        QMutexLocker locker(&mutex_);
+        QList<QByteArray> &list = capacity <= kSegmentSize ? segments_ : large_;
+        // 选取能满足需求的最小缓冲区
+        qsizetype bestIndex = -1;
+        for (qsizetype i = 0; i < list.size(); ++i) {
+            const qsizetype c = list.at(i).capacity();
+            if (c >= capacity && (bestIndex < 0 || c < list.at(bestIndex).capacity())) {
+                bestIndex = i;
+            }
+        }
+        if (bestIndex >= 0) {
+            QByteArray buffer = list.takeAt(bestIndex);
+            stats_.pooledBytes -= buffer.capacity();
+            ++stats_.reuses;
+            return buffer;
+        }
+        ++stats_.allocations;
+    }
+
+    QByteArray buffer;
+    buffer.reserve(qMax(capacity, kSegmentSize));
+    return buffer;
+}
+
+void BufferPool::release(QByteArray &&buffer)
+{
+    // resize(0)保留容量；被共享的缓冲区无法复用，交给QByteArray自己释放
+    if (!buffer.isDetached() || buffer.capacity() < kSegmentSize) {
+        return;
+    }
+    buffer.resize(0);
+
+    QMutexLocker locker(&mutex_);
+    if (stats_.pooledBytes + buffer.capacity() > kMaxPooledBytes) {
+        return;
+    }
+    stats_.pooledBytes += buffer.capacity();
+    if (buffer.capacity() <= kSegmentSize) {
+        segments_.append(std::move(buffer));
+    } else {
+        large_.append(std::move(buffer));
+    }
+}
+
+BufferPool::Stats BufferPool::stats() const
+{
+    QMutexLocker locker(&mutex_);
+    return stats_;
+}
+
+BodyBuffer::~BodyBuffer()
+{
+    release();
+}
+
+BodyBuffer::BodyBuffer(BodyBuffer &&other) noexcept
+    : segments_(std::move(other.segments_)),
+      size_(other.size_),
+      spillThreshold_(other.spillThreshold_),
+      spill_(std::move(other.spill_))
+{
+    other.segments_.clear();
+    other.size_ = 0;
+}
+
+BodyBuffer &BodyBuffer::operator=(BodyBuffer &&other) noexcept
+{
+    if (this != &other) {
+        release();
+        segments_ = std::move(other.segments_);
+        size_ = other.size_;
+        spillThreshold_ = other.spillThreshold_;
+        spill_ = std::move(other.spill_);
+        other.segments_.clear();
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+void BodyBuffer::reserve(qint64 expectedSize)
+{
+    if (spillThreshold_ > 0 && expectedSize > spillThreshold_ && size_ == 0) {
+        // 注定要转存的响应直接写文件，不经过内存分段
+        startSpill();
+        return;
+    }
+    if (!segments_.isEmpty() || spill_ || expectedSize <= 0 || expectedSize > kMaxContiguousReserve) {
+        return;
+    }
+    segments_.append(BufferPool::instance().acquire(static_cast<qsizetype>(expectedSize)));
+}
+
+bool BodyBuffer::startSpill()
+{
+    std::unique_ptr<QTemporaryFile> file(new QTemporaryFile(QDir::tempPath() + "/EasyProxyClient-body-XXXXXX"));
+    if (!file->open()) {
+        return false;
+    }
+    for (const QByteArray &segment : segments_) {
+        if (file->write(segment) != segment.size()) {
+            return false;
+        }
+    }
+    for (QByteArray &segment : segments_) {
+        BufferPool::instance().release(std::move(segment));
+    }
+    segments_.clear();
+    spill_ = std::move(file);
+    return true;
+}
+
+bool BodyBuffer::append(const char *data, qsizetype size)
+{
+    if (!spill_ && spillThreshold_ > 0 && size_ + size > spillThreshold_) {
+        if (!startSpill()) {
+            return false;
+        }
+    }
+    if (spill_) {
+        if (spill_->write(data, size) != size) {
+            return false;
+        }
+        size_ += size;
+        return true;
+    }
+
+    while (size > 0) {
+        if (segments_.isEmpty() || segments_.last().size() == segments_.last().capacity()) {
+            segments_.append(BufferPool::instance().acquire(BufferPool::kSegmentSize));
+        }
+        QByteArray &segment = segments_.last();
+        const qsizetype chunk = qMin(size, segment.capacity() - segment.size());
+        segment.append(data, chunk);
+        data += chunk;
+        size -= chunk;
+        size_ += chunk;
+    }
+    return true;
+}
+
+void BodyBuffer::release()
+{
+    for (QByteArray &segment : segments_) {
+        BufferPool::instance().release(std::move(segment));
+    }
+    segments_.clear();
+    spill_.reset();
+    size_ = 0;
+}
+
+void BodyBuffer::adopt(const QByteArray &bytes)
+{
+    release();
+    if (!bytes.isEmpty()) {
+        segments_.append(bytes);
+        size_ = bytes.size();
+    }
+}
+
+std::unique_ptr<QTemporaryFile> BodyBuffer::takeSpillFile()
+{
+    std::unique_ptr<QTemporaryFile> file = std::move(spill_);
+    release();
+    return file;
+}
+
+bool BodyBuffer::forEachChunk(const std::function<bool(const char *, qsizetype)> &visit) const
+{
+    if (spill_) {
+        // 读完后回到末尾，保证之后的append仍然追加
+        const qint64 end = spill_->pos();
+        spill_->seek(0);
+        QByteArray block(BufferPool::kSegmentSize, Qt::Uninitialized);
+        bool ok = true;
+        for (;;) {
+            const qint64 read = spill_->read(block.data(), block.size());
+            if (read <= 0) {
+                ok = read == 0;
+                break;
+            }
+            if (!visit(block.constData(), static_cast<qsizetype>(read))) {
+                ok = false;
+                break;
+            }
+        }
+        spill_->seek(end);
+        return ok;
+    }
+
+    for (const QByteArray &segment : segments_) {
+        if (!visit(segment.constData(), segment.size())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BodyBuffer::startsWith(const char *prefix) const
+{
+    const qsizetype length = static_cast<qsizetype>(std::strlen(prefix));
+    return left(length) == QByteArray(prefix, length);
+}
+
+QByteArray BodyBuffer::left(qsizetype n) const
+{
+    if (spill_) {
+        const qint64 end = spill_->pos();
+        spill_->seek(0);
+        const QByteArray out = spill_->read(n);
+        spill_->seek(end);
+        return out;
+    }
+
+    QByteArray out;
+    out.reserve(qMin<qint64>(n, size_));
+    for (const QByteArray &segment : segments_) {
+        if (out.size() >= n) {
+            break;
+        }
+        out.append(segment.constData(), qMin(segment.size(), n - out.size()));
+    }
+    return out;
+}
+
+QByteArray BodyBuffer::toByteArray() const
+{
+    if (segments_.size() == 1) {
+        return segments_.first();
+    }
+    return left(static_cast<qsizetype>(size_));
+}
+
+QByteArray BodyBuffer::takeByteArray()
+{
+    QByteArray out;
+    if (segments_.size() == 1) {
+        out = std::move(segments_.first());
+        segments_.clear();
+    } else {
+        out = left(static_cast<qsizetype>(size_));
+    }
+    release();
+    return out;
+}
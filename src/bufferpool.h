@@ -0,0 +1,89 @@
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <QTemporaryFile>
+#include <functional>
+#include <memory>
+
+// 接收缓冲池：缓存已释放的缓冲区，供后续请求复用，避免接收路径上的反复分配
+class BufferPool
+{
+public:
+    // 长度未知时使用的分段大小
+    static const qsizetype kSegmentSize;
+
+    struct Stats
+    {
+        qint64 allocations { 0 };
+        qint64 reuses { 0 };
+        qint64 pooledBytes { 0 };
+    };
+
+    static BufferPool &instance();
+
+    // 取出一个容量不小于capacity、长度为0的缓冲区
+    QByteArray acquire(qsizetype capacity);
+    void release(QByteArray &&buffer);
+    Stats stats() const;
+
+private:
+    BufferPool() = default;
+
+    mutable QMutex mutex_;
+    QList<QByteArray> segments_;  // 标准分段
+    QList<QByteArray> large_;     // 按Content-Length预留的大缓冲区
+    Stats stats_;
+};
+
+// 由池化分段组成的响应体，析构或release()时把分段归还缓冲池
+// 设置了溢出阈值时，超过阈值的响应体整体转存到临时文件，内存占用不随响应大小增长
+class BodyBuffer
+{
+public:
+    BodyBuffer() = default;
+    ~BodyBuffer();
+    BodyBuffer(BodyBuffer &&other) noexcept;
+    BodyBuffer &operator=(BodyBuffer &&other) noexcept;
+    BodyBuffer(const BodyBuffer &) = delete;
+    BodyBuffer &operator=(const BodyBuffer &) = delete;
+
+    // 超过bytes后转存到临时文件，0表示始终保留在内存中
+    void setSpillThreshold(qint64 bytes) { spillThreshold_ = bytes; }
+    // 已知响应长度时一次性预留，后续append不再分配
+    void reserve(qint64 expectedSize);
+    // 写临时文件失败时返回false
+    bool append(const char *data, qsizetype size);
+    void release();
+    // 以bytes作为唯一分段替换当前内容，只增加引用计数，不复制
+    void adopt(const QByteArray &bytes);
+
+    bool isSpilled() const { return spill_ != nullptr; }
+    // 取走溢出文件（读写位置不定），之后本对象为空
+    std::unique_ptr<QTemporaryFile> takeSpillFile();
+
+    qint64 size() const { return size_; }
+    bool isEmpty() const { return size_ == 0; }
+    const QList<QByteArray> &segments() const { return segments_; }
+
+    bool startsWith(const char *prefix) const;
+    QByteArray left(qsizetype n) const;
+    QByteArray toByteArray() const;
+    // 取走全部内容，之后本对象为空。只有一个分段时直接移交该分段，
+    // 接收方用完后应交还BufferPool；多个分段时合并成新数组并归还原分段
+    QByteArray takeByteArray();
+    // 按顺序把全部内容分块交给visit，不合并成一整块；visit返回false时提前停止并返回false
+    bool forEachChunk(const std::function<bool(const char *, qsizetype)> &visit) const;
+
+private:
+    bool startSpill();
+
+    QList<QByteArray> segments_;
+    qint64 size_ { 0 };
+    qint64 spillThreshold_ { 0 };
+    std::unique_ptr<QTemporaryFile> spill_;
+};
+
+#endif // BUFFERPOOL_H
@@ -1,31 +1,57 @@
 #include "configmanager.h"
+#include "spanprofiler.h"
+#include "startupprofiler.h"
 #include <QApplication>
+#include <QCryptographicHash>
 #include <QDir>
 #include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
 #include <QStandardPaths>
 
 // 默认值定义
+const QString ConfigManager::DEFAULT_PROFILE_NAME = "default";
 const QString ConfigManager::DEFAULT_PROXY_HOST = "127.0.0.1";
 const int ConfigManager::DEFAULT_PROXY_PORT = 8080;
 const QString ConfigManager::DEFAULT_PROXY_USERNAME = "";
 const QString ConfigManager::DEFAULT_PROXY_PASSWORD = "";
 const QString ConfigManager::DEFAULT_CERTIFICATE_PATH = "";
+const bool ConfigManager::DEFAULT_COMPRESSION_ENABLED = true;
+const int ConfigManager::DEFAULT_UPLOAD_BUFFER_SIZE = 64 * 1024;
+const bool ConfigManager::DEFAULT_CACHE_ENABLED = false;
+const int ConfigManager::DEFAULT_CACHE_MAX_SIZE_MB = 256;
+const int ConfigManager::DEFAULT_MEMORY_CACHE_MB = 32;
+const int ConfigManager::DEFAULT_MEMORY_CACHE_TTL_SECONDS = 30;
+const bool ConfigManager::DEFAULT_COALESCE_REQUESTS = true;
+const int ConfigManager::DEFAULT_HOST_CONCURRENCY = 4;
+const int ConfigManager::DEFAULT_PROXY_CONCURRENCY = 16;
+const double ConfigManager::DEFAULT_HOST_REQUEST_RATE = 0;
+const double ConfigManager::DEFAULT_PROXY_REQUEST_RATE = 0;
+const int ConfigManager::DEFAULT_INTERACTIVE_RESERVED = 2;
 const QString ConfigManager::DEFAULT_LAST_URL = "https://example.com";
 const int ConfigManager::DEFAULT_WINDOW_WIDTH = 800;
 const int ConfigManager::DEFAULT_WINDOW_HEIGHT = 600;
 
 ConfigManager::ConfigManager(QObject *parent)
     : QObject(parent)
-    , settings(nullptr)
 {
-    // 获取exe所在目录
+    // 获取exe所在目录，配置保存到exe同级目录
     QString exePath = QApplication::applicationDirPath();
-    QString configPath = exePath + "/config.ini";
-    
-    // 创建QSettings对象，保存到exe同级目录
-    settings = new QSettings(configPath, QSettings::IniFormat, this);
+    configPath_ = exePath + "/config.ini";
     
     loadConfig();
+    StartupProfiler::mark("配置已加载");
+    
+    // 监视配置文件，外部推送新的config.ini时自动重新加载
+    watcher_ = new QFileSystemWatcher(this);
+    reloadTimer_ = new QTimer(this);
+    reloadTimer_->setSingleShot(true);
+    reloadTimer_->setInterval(200); // 合并编辑器保存时的多次通知
+    connect(watcher_, &QFileSystemWatcher::fileChanged, reloadTimer_, [this]() { reloadTimer_->start(); });
+    connect(watcher_, &QFileSystemWatcher::directoryChanged, reloadTimer_, [this]() { reloadTimer_->start(); });
+    connect(reloadTimer_, &QTimer::timeout, this, &ConfigManager::reloadFromDisk);
+    watchConfigFile();
 }
 
 ConfigManager::~ConfigManager()
@@ -33,110 +59,551 @@ ConfigManager::~ConfigManager()
     saveConfig();
 }
 
+AppSettings ConfigManager::defaults()
+{
+    ProxyProfile profile;
+    profile.name = DEFAULT_PROFILE_NAME;
+    profile.proxyHost = DEFAULT_PROXY_HOST;
+    profile.proxyPort = DEFAULT_PROXY_PORT;
+    profile.proxyUsername = DEFAULT_PROXY_USERNAME;
+    profile.proxyPassword = DEFAULT_PROXY_PASSWORD;
+    profile.certificatePath = DEFAULT_CERTIFICATE_PATH;
+
+    AppSettings s;
+    s.profiles << profile;
+    s.activeProfile = profile.name;
+    s.compressionEnabled = DEFAULT_COMPRESSION_ENABLED;
+    s.uploadBufferSize = DEFAULT_UPLOAD_BUFFER_SIZE;
+    s.cacheEnabled = DEFAULT_CACHE_ENABLED;
+    s.cacheMaxSizeMb = DEFAULT_CACHE_MAX_SIZE_MB;
+    s.memoryCacheMb = DEFAULT_MEMORY_CACHE_MB;
+    s.memoryCacheTtlSeconds = DEFAULT_MEMORY_CACHE_TTL_SECONDS;
+    s.coalesceRequests = DEFAULT_COALESCE_REQUESTS;
+    s.hostConcurrency = DEFAULT_HOST_CONCURRENCY;
+    s.proxyConcurrency = DEFAULT_PROXY_CONCURRENCY;
+    s.hostRequestRate = DEFAULT_HOST_REQUEST_RATE;
+    s.proxyRequestRate = DEFAULT_PROXY_REQUEST_RATE;
+    s.interactiveReserved = DEFAULT_INTERACTIVE_RESERVED;
+    s.lastUrl = DEFAULT_LAST_URL;
+    s.windowWidth = DEFAULT_WINDOW_WIDTH;
+    s.windowHeight = DEFAULT_WINDOW_HEIGHT;
+    return s;
+}
+
+template <typename T>
+void ConfigManager::updateField(const QString &key, T AppSettings::*field, const T &value)
+{
+    if ((*current_).*field == value) {
+        return;
+    }
+    // 写时复制：旧快照仍被网络层持有时保持不变
+    QSharedPointer<AppSettings> next(new AppSettings(*current_));
+    (*next).*field = value;
+    current_ = next;
+    dirty_.insert(key, QVariant(value));
+}
+
+template <typename T>
+void ConfigManager::updateProfileField(const QString &key, T ProxyProfile::*field, const T &value)
+{
+    const ProxyProfile &active = current_->active();
+    if (active.*field == value) {
+        return;
+    }
+    QSharedPointer<AppSettings> next(new AppSettings(*current_));
+    for (ProxyProfile &profile : next->profiles) {
+        if (profile.name == active.name) {
+            profile.*field = value;
+        }
+    }
+    dirty_.insert(profileKey(active.name, key), QVariant(value));
+    current_ = next;
+}
+
+QString ConfigManager::profileKey(const QString &name, const QString &key)
+{
+    return QString("profiles/%1/%2").arg(name, key);
+}
+
+void ConfigManager::markProfileDirty(const ProxyProfile &profile)
+{
+    dirty_.insert(profileKey(profile.name, "host"), profile.proxyHost);
+    dirty_.insert(profileKey(profile.name, "port"), profile.proxyPort);
+    dirty_.insert(profileKey(profile.name, "username"), profile.proxyUsername);
+    dirty_.insert(profileKey(profile.name, "password"), profile.proxyPassword);
+    dirty_.insert(profileKey(profile.name, "certificate_path"), profile.certificatePath);
+    dirty_.insert(profileKey(profile.name, "pinned_pubkey"), profile.pinnedPublicKey);
+}
+
+// 代理配置档案
+QStringList ConfigManager::profileNames() const
+{
+    return current_->profileNames();
+}
+
+QString ConfigManager::activeProfile() const
+{
+    return current_->activeProfile;
+}
+
+bool ConfigManager::isValidProfileName(const QString &name)
+{
+    // 档案名会作为INI分组名和列表元素，排除分隔符
+    return !name.trimmed().isEmpty() && name == name.trimmed()
+        && !name.contains('/') && !name.contains('\\') && !name.contains(',');
+}
+
+bool ConfigManager::setActiveProfile(const QString &name)
+{
+    if (!current_->profile(name)) {
+        return false;
+    }
+    updateField("profile/active", &AppSettings::activeProfile, name);
+    return true;
+}
+
+bool ConfigManager::addProfile(const QString &name)
+{
+    if (!isValidProfileName(name) || current_->profile(name)) {
+        return false;
+    }
+    QSharedPointer<AppSettings> next(new AppSettings(*current_));
+    ProxyProfile profile = current_->active();
+    profile.name = name;
+    next->profiles << profile;
+    next->activeProfile = name;
+    current_ = next;
+
+    removed_.remove(QString("profiles/%1").arg(name));
+    markProfileDirty(profile);
+    dirty_.insert("profile/names", current_->profileNames());
+    dirty_.insert("profile/active", name);
+    return true;
+}
+
+bool ConfigManager::removeProfile(const QString &name)
+{
+    if (current_->profiles.size() <= 1 || !current_->profile(name)) {
+        return false;
+    }
+    QSharedPointer<AppSettings> next(new AppSettings(*current_));
+    for (qsizetype i = 0; i < next->profiles.size(); ++i) {
+        if (next->profiles.at(i).name == name) {
+            next->profiles.removeAt(i);
+            break;
+        }
+    }
+    if (next->activeProfile == name) {
+        next->activeProfile = next->profiles.first().name;
+    }
+    current_ = next;
+
+    // 丢弃该档案尚未保存的修改，保存时删除整个分组
+    const QString prefix = QString("profiles/%1/").arg(name);
+    for (const QString &key : dirty_.keys()) {
+        if (key.startsWith(prefix)) {
+            dirty_.remove(key);
+        }
+    }
+    removed_.insert(QString("profiles/%1").arg(name));
+    dirty_.insert("profile/names", current_->profileNames());
+    dirty_.insert("profile/active", current_->activeProfile);
+    return true;
+}
+
 // 代理设置
 void ConfigManager::setProxyHost(const QString &host)
 {
-    settings->setValue("proxy/host", host);
+    updateProfileField("host", &ProxyProfile::proxyHost, host);
 }
 
 void ConfigManager::setProxyPort(int port)
 {
-    settings->setValue("proxy/port", port);
+    updateProfileField("port", &ProxyProfile::proxyPort, port);
 }
 
 void ConfigManager::setProxyUsername(const QString &username)
 {
-    settings->setValue("proxy/username", username);
+    updateProfileField("username", &ProxyProfile::proxyUsername, username);
 }
 
 void ConfigManager::setProxyPassword(const QString &password)
 {
-    settings->setValue("proxy/password", password);
+    updateProfileField("password", &ProxyProfile::proxyPassword, password);
 }
 
 
 QString ConfigManager::getProxyHost() const
 {
-    return settings->value("proxy/host", DEFAULT_PROXY_HOST).toString();
+    return current_->active().proxyHost;
 }
 
 int ConfigManager::getProxyPort() const
 {
-    return settings->value("proxy/port", DEFAULT_PROXY_PORT).toInt();
+    return current_->active().proxyPort;
 }
 
 QString ConfigManager::getProxyUsername() const
 {
-    return settings->value("proxy/username", DEFAULT_PROXY_USERNAME).toString();
+    return current_->active().proxyUsername;
 }
 
 QString ConfigManager::getProxyPassword() const
 {
-    return settings->value("proxy/password", DEFAULT_PROXY_PASSWORD).toString();
+    return current_->active().proxyPassword;
 }
 
 
 // SSL证书设置
 void ConfigManager::setCertificatePath(const QString &path)
 {
-    settings->setValue("ssl/certificate_path", path);
+    // 换了CA说明代理证书也换了，原来固定的公钥随之作废，下次连接成功后重新捕获
+    if (path != current_->active().certificatePath) {
+        updateProfileField("pinned_pubkey", &ProxyProfile::pinnedPublicKey, QString());
+    }
+    updateProfileField("certificate_path", &ProxyProfile::certificatePath, path);
 }
 
 QString ConfigManager::getCertificatePath() const
 {
-    return settings->value("ssl/certificate_path", DEFAULT_CERTIFICATE_PATH).toString();
+    return current_->active().certificatePath;
+}
+
+void ConfigManager::setPinnedPublicKey(const QString &profile, const QString &pin)
+{
+    const ProxyProfile *existing = current_->profile(profile);
+    if (!existing || existing->pinnedPublicKey == pin) {
+        return;
+    }
+    QSharedPointer<AppSettings> next(new AppSettings(*current_));
+    for (ProxyProfile &p : next->profiles) {
+        if (p.name == profile) {
+            p.pinnedPublicKey = pin;
+        }
+    }
+    dirty_.insert(profileKey(profile, "pinned_pubkey"), pin);
+    current_ = next;
+}
+
+void ConfigManager::setProfilePin(const QString &profile, const QString &pin)
+{
+    const ProxyProfile *existing = current_->profile(profile);
+    if (!existing || existing->pinnedPublicKey == pin) {
+        return;
+    }
+    setPinnedPublicKey(profile, pin);
+    // 等待重置时文件整体重写，只能留给saveConfig一起写
+    if (resetPending_) {
+        return;
+    }
+
+    const QString key = profileKey(profile, "pinned_pubkey");
+    {
+        QSettings settings(configPath_, QSettings::IniFormat);
+        // 档案本身还没保存过时单写这一个键只会留下孤立的分组，同样留给saveConfig
+        if (!settings.value("profile/names").toStringList().contains(profile)) {
+            return;
+        }
+        settings.setValue(key, pin);
+        settings.sync();
+        if (settings.status() != QSettings::NoError) {
+            qWarning() << "保存代理公钥失败:" << configPath_;
+            return;
+        }
+    }
+    lastContentHash_ = fileHash();
+    dirty_.remove(key);
+}
+
+QString ConfigManager::getPinnedPublicKey() const
+{
+    return current_->active().pinnedPublicKey;
+}
+
+// 网络设置
+void ConfigManager::setCompressionEnabled(bool enabled)
+{
+    updateField("network/accept_encoding", &AppSettings::compressionEnabled, enabled);
+}
+
+bool ConfigManager::getCompressionEnabled() const
+{
+    return current_->compressionEnabled;
+}
+
+void ConfigManager::setCacheEnabled(bool enabled)
+{
+    updateField("cache/enabled", &AppSettings::cacheEnabled, enabled);
+}
+
+bool ConfigManager::getCacheEnabled() const
+{
+    return current_->cacheEnabled;
 }
 
 // 目标URL设置
 void ConfigManager::setLastUrl(const QString &url)
 {
-    settings->setValue("ui/last_url", url);
+    updateField("ui/last_url", &AppSettings::lastUrl, url);
 }
 
 QString ConfigManager::getLastUrl() const
 {
-    return settings->value("ui/last_url", DEFAULT_LAST_URL).toString();
+    return current_->lastUrl;
 }
 
 // 窗口设置
 void ConfigManager::setWindowSize(int width, int height)
 {
-    settings->setValue("ui/window_width", width);
-    settings->setValue("ui/window_height", height);
+    updateField("ui/window_width", &AppSettings::windowWidth, width);
+    updateField("ui/window_height", &AppSettings::windowHeight, height);
 }
 
 void ConfigManager::getWindowSize(int &width, int &height) const
 {
-    width = settings->value("ui/window_width", DEFAULT_WINDOW_WIDTH).toInt();
-    height = settings->value("ui/window_height", DEFAULT_WINDOW_HEIGHT).toInt();
+    width = current_->windowWidth;
+    height = current_->windowHeight;
 }
 
 // 保存和加载配置
 void ConfigManager::saveConfig()
 {
-    settings->sync();
-    qDebug() << "配置已保存到:" << settings->fileName();
+    ScopedSpan span("ConfigManager::saveConfig");
+    if (!isDirty()) {
+        return;
+    }
+
+    // 直接在配置文件上只改动变化的键，sync()一次写回。QSettings写INI时本身经QSaveFile原子替换，
+    // 中途失败不会留下半个配置文件，不必再复制、回读一份临时副本
+    {
+        QSettings settings(configPath_, QSettings::IniFormat);
+        if (resetPending_) {
+            settings.clear();
+        }
+        for (const QString &key : removed_) {
+            settings.remove(key);
+        }
+        for (auto it = dirty_.constBegin(); it != dirty_.constEnd(); ++it) {
+            settings.setValue(it.key(), it.value());
+        }
+        settings.sync();
+        if (settings.status() != QSettings::NoError) {
+            qWarning() << "保存配置失败:" << configPath_;
+            return;
+        }
+    }
+
+    // 记下写入后的内容，文件监视器收到自己写入的通知时据此忽略
+    lastContentHash_ = fileHash();
+    dirty_.clear();
+    removed_.clear();
+    resetPending_ = false;
+    qDebug() << "配置已保存到:" << configPath_;
+}
+
+bool ConfigManager::readSettings(AppSettings &out) const
+{
+    ScopedSpan span("ConfigManager::readSettings");
+    if (!QFile::exists(configPath_)) {
+        return false;
+    }
+
+    bool migrated = false;
+    QSettings settings(configPath_, QSettings::IniFormat);
+    const QStringList names = settings.value("profile/names").toStringList();
+    if (!names.isEmpty()) {
+        const QList<ProxyProfile> fallback = out.profiles;
+        out.profiles.clear();
+        for (const QString &name : names) {
+            if (!isValidProfileName(name) || out.profile(name)) {
+                continue;
+            }
+            ProxyProfile profile;
+            profile.name = name;
+            profile.proxyHost = settings.value(profileKey(name, "host"), DEFAULT_PROXY_HOST).toString();
+            profile.proxyPort = settings.value(profileKey(name, "port"), DEFAULT_PROXY_PORT).toInt();
+            profile.proxyUsername = settings.value(profileKey(name, "username"), DEFAULT_PROXY_USERNAME).toString();
+            profile.proxyPassword = settings.value(profileKey(name, "password"), DEFAULT_PROXY_PASSWORD).toString();
+            profile.certificatePath = settings.value(profileKey(name, "certificate_path"), DEFAULT_CERTIFICATE_PATH).toString();
+            profile.pinnedPublicKey = settings.value(profileKey(name, "pinned_pubkey")).toString();
+            out.profiles << profile;
+        }
+        if (out.profiles.isEmpty()) {
+            out.profiles = fallback;
+        }
+        out.activeProfile = settings.value("profile/active").toString();
+        if (!out.profile(out.activeProfile)) {
+            out.activeProfile = out.profiles.first().name;
+        }
+    } else if (settings.contains("proxy/host")) {
+        // 旧版配置只有一组proxy/*和ssl/*，迁移为default档案
+        ProxyProfile &profile = out.profiles.first();
+        profile.proxyHost = settings.value("proxy/host", DEFAULT_PROXY_HOST).toString();
+        profile.proxyPort = settings.value("proxy/port", DEFAULT_PROXY_PORT).toInt();
+        profile.proxyUsername = settings.value("proxy/username", DEFAULT_PROXY_USERNAME).toString();
+        profile.proxyPassword = settings.value("proxy/password", DEFAULT_PROXY_PASSWORD).toString();
+        profile.certificatePath = settings.value("ssl/certificate_path", DEFAULT_CERTIFICATE_PATH).toString();
+        migrated = true;
+    }
+    out.compressionEnabled = settings.value("network/accept_encoding", out.compressionEnabled).toBool();
+    out.uploadBufferSize = qBound(16 * 1024, settings.value("network/upload_buffer_size", out.uploadBufferSize).toInt(),
+                                  2 * 1024 * 1024);
+    out.cacheEnabled = settings.value("cache/enabled", out.cacheEnabled).toBool();
+    out.cacheMaxSizeMb = qMax(1, settings.value("cache/max_size_mb", out.cacheMaxSizeMb).toInt());
+    out.memoryCacheMb = qMax(0, settings.value("cache/memory_size_mb", out.memoryCacheMb).toInt());
+    out.memoryCacheTtlSeconds = qMax(1, settings.value("cache/memory_ttl_seconds", out.memoryCacheTtlSeconds).toInt());
+    out.coalesceRequests = settings.value("cache/coalesce", out.coalesceRequests).toBool();
+    out.hostConcurrency = qMax(1, settings.value("scheduler/host_concurrency", out.hostConcurrency).toInt());
+    out.proxyConcurrency = qMax(1, settings.value("scheduler/proxy_concurrency", out.proxyConcurrency).toInt());
+    out.hostRequestRate = qMax(0.0, settings.value("scheduler/host_rate", out.hostRequestRate).toDouble());
+    out.proxyRequestRate = qMax(0.0, settings.value("scheduler/proxy_rate", out.proxyRequestRate).toDouble());
+    out.interactiveReserved = qMax(0, settings.value("scheduler/interactive_reserved", out.interactiveReserved).toInt());
+    out.lastUrl = settings.value("ui/last_url", out.lastUrl).toString();
+    out.windowWidth = settings.value("ui/window_width", out.windowWidth).toInt();
+    out.windowHeight = settings.value("ui/window_height", out.windowHeight).toInt();
+    return migrated;
+}
+
+QByteArray ConfigManager::fileHash() const
+{
+    QFile file(configPath_);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return QCryptographicHash::hash(file.readAll(), QCryptographicHash::Sha1);
 }
 
 void ConfigManager::loadConfig()
 {
-    qDebug() << "配置已从以下位置加载:" << settings->fileName();
+    ScopedSpan span("ConfigManager::loadConfig");
+    QSharedPointer<AppSettings> loaded(new AppSettings(defaults()));
+    dirty_.clear();
+    removed_.clear();
+    resetPending_ = false;
+
+    if (readSettings(*loaded)) {
+        const ProxyProfile &profile = loaded->profiles.first();
+        markProfileDirty(profile);
+        dirty_.insert("profile/names", loaded->profileNames());
+        dirty_.insert("profile/active", profile.name);
+        removed_.insert("proxy");
+        removed_.insert("ssl");
+    }
+    current_ = loaded;
+    lastContentHash_ = fileHash();
+    qDebug() << "配置已从以下位置加载:" << configPath_;
+}
+
+void ConfigManager::watchConfigFile()
+{
+    // 原子替换（重命名）后原文件的监视会失效，需要重新添加
+    const QString dir = QFileInfo(configPath_).absolutePath();
+    if (!watcher_->directories().contains(dir)) {
+        watcher_->addPath(dir);
+    }
+    if (QFile::exists(configPath_) && !watcher_->files().contains(configPath_)) {
+        watcher_->addPath(configPath_);
+    }
+}
+
+void ConfigManager::reloadFromDisk()
+{
+    ScopedSpan span("ConfigManager::reloadFromDisk");
+    watchConfigFile();
+
+    // 内容与最近一次加载或保存的一致（包括自己写入触发的通知）时不处理
+    const QByteArray hash = fileHash();
+    if (hash.isEmpty() || hash == lastContentHash_) {
+        return;
+    }
+    lastContentHash_ = hash;
+
+    QSharedPointer<AppSettings> loaded(new AppSettings(defaults()));
+    readSettings(*loaded);
+    // 窗口大小由界面维护，不随文件变化
+    loaded->windowWidth = current_->windowWidth;
+    loaded->windowHeight = current_->windowHeight;
+
+    const ConfigChanges changes = diff(*current_, *loaded);
+    // 以文件内容为准，尚未保存的修改被丢弃
+    current_ = loaded;
+    dirty_.clear();
+    removed_.clear();
+    resetPending_ = false;
+
+    qDebug() << "配置文件已变化:" << changes.describe();
+    if (!changes.isEmpty()) {
+        emit settingsReloaded(changes);
+    }
+}
+
+ConfigChanges ConfigManager::diff(const AppSettings &before, const AppSettings &after)
+{
+    ConfigChanges changes;
+    for (const ProxyProfile &p : after.profiles) {
+        const ProxyProfile *old = before.profile(p.name);
+        if (!old) {
+            changes.addedProfiles << p.name;
+            continue;
+        }
+        if (old->proxyHost != p.proxyHost || old->proxyPort != p.proxyPort
+            || old->proxyUsername != p.proxyUsername || old->proxyPassword != p.proxyPassword) {
+            changes.endpointChangedProfiles << p.name;
+        }
+        if (old->certificatePath != p.certificatePath || old->pinnedPublicKey != p.pinnedPublicKey) {
+            changes.caChangedProfiles << p.name;
+        }
+    }
+    for (const ProxyProfile &p : before.profiles) {
+        if (!after.profile(p.name)) {
+            changes.removedProfiles << p.name;
+        }
+    }
+    changes.activeProfileChanged = before.activeProfile != after.activeProfile;
+    changes.otherChanged = before.compressionEnabled != after.compressionEnabled
+        || before.uploadBufferSize != after.uploadBufferSize
+        || before.cacheEnabled != after.cacheEnabled
+        || before.cacheMaxSizeMb != after.cacheMaxSizeMb
+        || before.memoryCacheMb != after.memoryCacheMb
+        || before.memoryCacheTtlSeconds != after.memoryCacheTtlSeconds
+        || before.coalesceRequests != after.coalesceRequests
+        || before.lastUrl != after.lastUrl
+        || before.hostConcurrency != after.hostConcurrency
+        || before.proxyConcurrency != after.proxyConcurrency
+        || before.hostRequestRate != after.hostRequestRate
+        || before.proxyRequestRate != after.proxyRequestRate
+        || before.interactiveReserved != after.interactiveReserved;
+    return changes;
 }
 
 // 重置为默认值
 void ConfigManager::resetToDefaults()
 {
-    settings->clear();
+    current_ = QSharedPointer<const AppSettings>(new AppSettings(defaults()));
     
-    // 设置默认值
-    setProxyHost(DEFAULT_PROXY_HOST);
-    setProxyPort(DEFAULT_PROXY_PORT);
-    setProxyUsername(DEFAULT_PROXY_USERNAME);
-    setProxyPassword(DEFAULT_PROXY_PASSWORD);
-    setCertificatePath(DEFAULT_CERTIFICATE_PATH);
-    setLastUrl(DEFAULT_LAST_URL);
-    setWindowSize(DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
+    // 重写整个文件，所有键都写入默认值
+    resetPending_ = true;
+    dirty_.clear();
+    removed_.clear();
+    markProfileDirty(current_->active());
+    dirty_.insert("profile/names", current_->profileNames());
+    dirty_.insert("profile/active", current_->activeProfile);
+    dirty_.insert("network/accept_encoding", DEFAULT_COMPRESSION_ENABLED);
+    dirty_.insert("network/upload_buffer_size", DEFAULT_UPLOAD_BUFFER_SIZE);
+    dirty_.insert("cache/enabled", DEFAULT_CACHE_ENABLED);
+    dirty_.insert("cache/max_size_mb", DEFAULT_CACHE_MAX_SIZE_MB);
+    dirty_.insert("cache/memory_size_mb", DEFAULT_MEMORY_CACHE_MB);
+    dirty_.insert("cache/memory_ttl_seconds", DEFAULT_MEMORY_CACHE_TTL_SECONDS);
+    dirty_.insert("cache/coalesce", DEFAULT_COALESCE_REQUESTS);
+    dirty_.insert("scheduler/host_concurrency", DEFAULT_HOST_CONCURRENCY);
+    dirty_.insert("scheduler/proxy_concurrency", DEFAULT_PROXY_CONCURRENCY);
+    dirty_.insert("scheduler/host_rate", DEFAULT_HOST_REQUEST_RATE);
+    dirty_.insert("scheduler/proxy_rate", DEFAULT_PROXY_REQUEST_RATE);
+    dirty_.insert("scheduler/interactive_reserved", DEFAULT_INTERACTIVE_RESERVED);
+    dirty_.insert("ui/last_url", DEFAULT_LAST_URL);
+    dirty_.insert("ui/window_width", DEFAULT_WINDOW_WIDTH);
+    dirty_.insert("ui/window_height", DEFAULT_WINDOW_HEIGHT);
     
     saveConfig();
     qDebug() << "配置已重置为默认值";
-} 
\ No newline at end of file
+}
@@ -3,7 +3,13 @@
 
 #include <QObject>
 #include <QString>
-#include <QSettings>
+#include <QHash>
+#include <QSet>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QVariant>
+#include <QSharedPointer>
+#include "appsettings.h"
 
 class ConfigManager : public QObject
 {
@@ -13,7 +19,19 @@ public:
     explicit ConfigManager(QObject *parent = nullptr);
     ~ConfigManager();
 
-    // 代理设置
+    // 当前配置的不可变快照，修改配置时整体替换，已取得的快照不受影响
+    QSharedPointer<const AppSettings> snapshot() const { return current_; }
+
+    // 代理配置档案
+    QStringList profileNames() const;
+    QString activeProfile() const;
+    bool setActiveProfile(const QString &name);
+    // 以当前档案为模板新建档案并切换过去
+    bool addProfile(const QString &name);
+    bool removeProfile(const QString &name);
+    static bool isValidProfileName(const QString &name);
+    
+    // 代理设置（作用于当前档案）
     void setProxyHost(const QString &host);
     void setProxyPort(int port);
     void setProxyUsername(const QString &username);
@@ -27,6 +45,17 @@ public:
     // SSL证书设置
     void setCertificatePath(const QString &path);
     QString getCertificatePath() const;
+    // 代理公钥固定，按档案名设置（捕获完成时当前档案可能已经切换）；空字符串表示清除
+    void setPinnedPublicKey(const QString &profile, const QString &pin);
+    // 同上，但立即把这一个键写入配置文件，界面上其他未保存的修改保持原样
+    void setProfilePin(const QString &profile, const QString &pin);
+    QString getPinnedPublicKey() const;
+    
+    // 网络设置
+    void setCompressionEnabled(bool enabled);
+    bool getCompressionEnabled() const;
+    void setCacheEnabled(bool enabled);
+    bool getCacheEnabled() const;
     
     // 目标URL设置
     void setLastUrl(const QString &url);
@@ -39,22 +68,66 @@ public:
     // 保存和加载配置
     void saveConfig();
     void loadConfig();
+    bool isDirty() const { return !dirty_.isEmpty() || !removed_.isEmpty() || resetPending_; }
+    QString configPath() const { return configPath_; }
     
     // 重置为默认值
     void resetToDefaults();
 
+signals:
+    // config.ini被外部修改并已重新加载
+    void settingsReloaded(const ConfigChanges &changes);
+
 private:
-    QSettings *settings;
+    bool readSettings(AppSettings &out) const;
+    QByteArray fileHash() const;
+    void watchConfigFile();
+    void reloadFromDisk();
+    static ConfigChanges diff(const AppSettings &before, const AppSettings &after);
+
+    template <typename T>
+    void updateField(const QString &key, T AppSettings::*field, const T &value);
+    template <typename T>
+    void updateProfileField(const QString &key, T ProxyProfile::*field, const T &value);
+    void markProfileDirty(const ProxyProfile &profile);
+    static QString profileKey(const QString &name, const QString &key);
+    static AppSettings defaults();
+
+    QString configPath_;
+    QSharedPointer<const AppSettings> current_;
+    // 尚未写回磁盘的键值
+    QHash<QString, QVariant> dirty_;
+    // 需要从文件中删除的键或分组
+    QSet<QString> removed_;
+    bool resetPending_ { false };
+    
+    // 文件监视与自写入识别
+    QFileSystemWatcher *watcher_ { nullptr };
+    QTimer *reloadTimer_ { nullptr };
+    QByteArray lastContentHash_;
     
     // 默认值
+    static const QString DEFAULT_PROFILE_NAME;
     static const QString DEFAULT_PROXY_HOST;
     static const int DEFAULT_PROXY_PORT;
     static const QString DEFAULT_PROXY_USERNAME;
     static const QString DEFAULT_PROXY_PASSWORD;
     static const QString DEFAULT_CERTIFICATE_PATH;
+    static const bool DEFAULT_COMPRESSION_ENABLED;
+    static const int DEFAULT_UPLOAD_BUFFER_SIZE;
+    static const bool DEFAULT_CACHE_ENABLED;
+    static const int DEFAULT_CACHE_MAX_SIZE_MB;
+    static const int DEFAULT_MEMORY_CACHE_MB;
+    static const int DEFAULT_MEMORY_CACHE_TTL_SECONDS;
+    static const bool DEFAULT_COALESCE_REQUESTS;
+    static const int DEFAULT_HOST_CONCURRENCY;
+    static const int DEFAULT_PROXY_CONCURRENCY;
+    static const double DEFAULT_HOST_REQUEST_RATE;
+    static const double DEFAULT_PROXY_REQUEST_RATE;
+    static const int DEFAULT_INTERACTIVE_RESERVED;
     static const QString DEFAULT_LAST_URL;
     static const int DEFAULT_WINDOW_WIDTH;
     static const int DEFAULT_WINDOW_HEIGHT;
 };
 
-#endif // CONFIGMANAGER_H 
\ No newline at end of file
+#endif // CONFIGMANAGER_H 
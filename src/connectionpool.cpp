@@ -0,0 +1,108 @@
+#include "connectionpool.h"
+#include "curlruntime.h"
+#include <QFileInfo>
+#include <QMutexLocker>
+
+namespace {
+// 池中最多保留的空闲easy句柄数
+const int kMaxIdleHandles = 8;
+}
+
+ConnectionPool::ConnectionPool(const ProxyOptions &options)
+    : options_(options),
+      caModified_(options.caPath.isEmpty() ? QDateTime() : QFileInfo(options.caPath).lastModified())
+{
+    CurlRuntime::ensureInitialized();
+    share_ = curl_share_init();
+    if (share_) {
+        curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, &ConnectionPool::lockCallback);
+        curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, &ConnectionPool::unlockCallback);
+        curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    }
+}
+
+ConnectionPool::~ConnectionPool()
+{
+    // 先清理所有挂在共享句柄上的easy句柄，共享句柄才能释放
+    for (CURL *curl : idle_) {
+        curl_easy_cleanup(curl);
+    }
+    idle_.clear();
+    if (share_) {
+        curl_share_cleanup(share_);
+    }
+}
+
+bool ConnectionPool::matches(const ProxyOptions &options) const
+{
+    return options.host == options_.host
+        && options.port == options_.port
+        && options.username == options_.username
+        && options.password == options_.password
+        && options.caPath == options_.caPath
+        && options.pinnedPublicKey == options_.pinnedPublicKey
+        && (options.caPath.isEmpty() || QFileInfo(options.caPath).lastModified() == caModified_);
+}
+
+bool ConnectionPool::isWarm() const
+{
+    QMutexLocker locker(&mutex_);
+    return warm_;
+}
+
+CURL *ConnectionPool::acquire()
+{
+    CURL *curl = nullptr;
+    {
+        QMutexLocker locker(&mutex_);
+        if (!idle_.isEmpty()) {
+            curl = idle_.takeLast();
+        }
+    }
+
+    if (curl) {
+        // reset保留句柄内的连接、会话与CA缓存，只清除选项
+        curl_easy_reset(curl);
+    } else {
+        curl = curl_easy_init();
+        if (!curl) {
+            return nullptr;
+        }
+    }
+
+    if (share_) {
+        curl_easy_setopt(curl, CURLOPT_SHARE, share_);
+    }
+    // 空闲隧道保持存活，切换回来时不必重新握手
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_CA_CACHE_TIMEOUT, 3600L);
+    return curl;
+}
+
+void ConnectionPool::release(CURL *curl, bool succeeded)
+{
+    if (!curl) {
+        return;
+    }
+
+    QMutexLocker locker(&mutex_);
+    warm_ = warm_ || succeeded;
+    if (idle_.size() < kMaxIdleHandles) {
+        idle_.append(curl);
+        return;
+    }
+    locker.unlock();
+    curl_easy_cleanup(curl);
+}
+
+void ConnectionPool::lockCallback(CURL *, curl_lock_data data, curl_lock_access, void *userptr)
+{
+    static_cast<ConnectionPool *>(userptr)->shareLocks_[data].lock();
+}
+
+void ConnectionPool::unlockCallback(CURL *, curl_lock_data data, void *userptr)
+{
+    static_cast<ConnectionPool *>(userptr)->shareLocks_[data].unlock();
+}
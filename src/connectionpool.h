@@ -0,0 +1,47 @@
+#ifndef CONNECTIONPOOL_H
+#define CONNECTIONPOOL_H
+
+#include <QDateTime>
+#include <QList>
+#include <QMutex>
+#include <curl/curl.h>
+#include "proxyoptions.h"
+
+// 一个代理端点的连接池：共享TLS会话和DNS缓存，并复用easy句柄。
+// 连接缓存不共享（libcurl不支持不同线程上同时运行的句柄共享连接缓存），
+// 已建立的隧道留在各自句柄内，随句柄一起复用；
+// 复用的句柄还保留其内部缓存的CA证书库（CURLOPT_CA_CACHE_TIMEOUT），不必每次重新解析CA文件
+class ConnectionPool
+{
+public:
+    explicit ConnectionPool(const ProxyOptions &options);
+    ~ConnectionPool();
+    ConnectionPool(const ConnectionPool &) = delete;
+    ConnectionPool &operator=(const ConnectionPool &) = delete;
+
+    // 端点、认证或CA（路径或文件内容）变化时需要新的连接池，压缩等请求级选项不影响
+    bool matches(const ProxyOptions &options) const;
+    // 是否有句柄成功完成过传输（空闲句柄中可能有可复用的隧道）
+    bool isWarm() const;
+
+    // 取出一个已挂上共享句柄的easy句柄，最近归还的先取出；用完后必须release
+    CURL *acquire();
+    // succeeded表示句柄刚成功完成一次传输，失败的传输不会让连接池变热
+    void release(CURL *curl, bool succeeded = false);
+
+private:
+    static void lockCallback(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr);
+    static void unlockCallback(CURL *handle, curl_lock_data data, void *userptr);
+
+    const ProxyOptions options_;
+    // CA文件在路径不变的情况下被替换时也需要新的连接池
+    const QDateTime caModified_;
+    CURLSH *share_ { nullptr };
+    QMutex shareLocks_[CURL_LOCK_DATA_LAST];
+
+    mutable QMutex mutex_;
+    QList<CURL *> idle_;
+    bool warm_ { false };
+};
+
+#endif // CONNECTIONPOOL_H
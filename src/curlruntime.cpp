@@ -0,0 +1,41 @@
+#include "curlruntime.h"
+#include "startupprofiler.h"
+#include <QtConcurrent>
+#include <curl/curl.h>
+#include <atomic>
+#include <mutex>
+
+namespace {
+std::once_flag g_initFlag;
+// 在执行初始化的线程（后台或工作线程）写入，在界面线程清理时读取
+std::atomic<bool> g_initialized { false };
+
+void globalInit()
+{
+    g_initialized = curl_global_init(CURL_GLOBAL_DEFAULT) == CURLE_OK;
+    // 查询版本信息会触发TLS后端加载，提前完成以免首次请求时才付出这部分开销。
+    // CA证书库要到句柄第一次握手时才解析，这一步由启动时的连接池预热在工作线程上完成
+    const curl_version_info_data *info = curl_version_info(CURLVERSION_NOW);
+    StartupProfiler::mark(QString("curl/TLS库已加载 (%1, %2)")
+                              .arg(QString::fromLatin1(info->version),
+                                   QString::fromLatin1(info->ssl_version ? info->ssl_version : "no TLS")));
+}
+}
+
+QFuture<void> CurlRuntime::initAsync()
+{
+    return QtConcurrent::run([]() { std::call_once(g_initFlag, globalInit); });
+}
+
+void CurlRuntime::ensureInitialized()
+{
+    // 后台初始化进行中时call_once会阻塞到它完成
+    std::call_once(g_initFlag, globalInit);
+}
+
+void CurlRuntime::cleanup()
+{
+    if (g_initialized.exchange(false)) {
+        curl_global_cleanup();
+    }
+}
@@ -0,0 +1,18 @@
+#ifndef CURLRUNTIME_H
+#define CURLRUNTIME_H
+
+#include <QFuture>
+
+// libcurl全局初始化。curl_global_init不是线程安全的，必须在任何easy/share句柄创建前完成一次
+class CurlRuntime
+{
+public:
+    // 在后台线程执行全局初始化（包括加载TLS库，但不解析CA证书），不阻塞界面启动
+    static QFuture<void> initAsync();
+    // 创建curl句柄前调用，初始化尚未完成时等待它完成，尚未开始时就地执行
+    static void ensureInitialized();
+    // 程序退出前调用
+    static void cleanup();
+};
+
+#endif // CURLRUNTIME_H
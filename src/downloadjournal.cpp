@@ -0,0 +1,96 @@
+#include "downloadjournal.h"
+#include <QFile>
+#include <QSaveFile>
+
+namespace {
+const QByteArray kMagic = "EPJOURNAL 1";
+}
+
+QString DownloadJournal::pathFor(const QString &outputPath)
+{
+    return outputPath + ".epjournal";
+}
+
+bool DownloadJournal::load(const QString &outputPath)
+{
+    QFile file(pathFor(outputPath));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    // 每行“键 值”，值可能含空格（Last-Modified），只按第一个空格切分
+    const QList<QByteArray> lines = file.readAll().split('\n');
+    if (lines.isEmpty() || lines.first().trimmed() != kMagic) {
+        return false;
+    }
+    *this = DownloadJournal();
+    for (const QByteArray &raw : lines.mid(1)) {
+        const QByteArray line = raw.trimmed();
+        const qsizetype space = line.indexOf(' ');
+        if (space <= 0) {
+            continue;
+        }
+        const QByteArray key = line.left(space);
+        const QByteArray value = line.mid(space + 1);
+        if (key == "url") {
+            url = QString::fromUtf8(value);
+        } else if (key == "validator") {
+            validator = QString::fromLatin1(value);
+        } else if (key == "size") {
+            size = value.toLongLong();
+        } else if (key == "range") {
+            const QList<QByteArray> fields = value.split(' ');
+            if (fields.size() != 3) {
+                return false;
+            }
+            Range range;
+            range.offset = fields.at(0).toLongLong();
+            range.length = fields.at(1).toLongLong();
+            range.written = fields.at(2).toLongLong();
+            if (range.offset < 0 || range.length <= 0 || range.written < 0 || range.written > range.length) {
+                return false;
+            }
+            ranges << range;
+        }
+    }
+    return !url.isEmpty() && size > 0 && !ranges.isEmpty();
+}
+
+bool DownloadJournal::save(const QString &outputPath) const
+{
+    QByteArray data = kMagic + "\n";
+    data += "url " + url.toUtf8() + "\n";
+    data += "validator " + validator.toLatin1() + "\n";
+    data += "size " + QByteArray::number(size) + "\n";
+    for (const Range &range : ranges) {
+        data += "range " + QByteArray::number(range.offset) + " " + QByteArray::number(range.length) + " "
+            + QByteArray::number(range.written) + "\n";
+    }
+
+    QSaveFile file(pathFor(outputPath));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(data);
+    return file.commit();
+}
+
+void DownloadJournal::remove(const QString &outputPath)
+{
+    QFile::remove(pathFor(outputPath));
+}
+
+bool DownloadJournal::matches(const QString &url, qint64 size, const QString &validator) const
+{
+    // 没有验证器就无法确认服务器上的文件没变，宁可重新下载
+    return !validator.isEmpty() && this->url == url && this->size == size && this->validator == validator;
+}
+
+qint64 DownloadJournal::completedBytes() const
+{
+    qint64 bytes = 0;
+    for (const Range &range : ranges) {
+        bytes += range.written;
+    }
+    return bytes;
+}
@@ -0,0 +1,37 @@
+#ifndef DOWNLOADJOURNAL_H
+#define DOWNLOADJOURNAL_H
+
+#include <QList>
+#include <QString>
+
+// 分段下载的进度日志，保存在输出文件旁的<输出文件>.epjournal中。
+// 只记录已经落盘的字节，下载中断或程序重启后据此用Range请求续传
+struct DownloadJournal
+{
+    struct Range
+    {
+        qint64 offset { 0 };
+        qint64 length { 0 };
+        qint64 written { 0 };
+    };
+
+    QString url;
+    // 下载开始时服务器返回的强ETag或Last-Modified，续传时作为If-Range发送
+    QString validator;
+    qint64  size { 0 };
+    QList<Range> ranges;
+
+    static QString pathFor(const QString &outputPath);
+
+    // 日志不存在或格式不对时返回false
+    bool load(const QString &outputPath);
+    // 原子替换日志文件，写到一半崩溃也不会留下损坏的日志
+    bool save(const QString &outputPath) const;
+    static void remove(const QString &outputPath);
+
+    // 只有URL、长度和验证器都与本次探测结果一致时才能续传
+    bool matches(const QString &url, qint64 size, const QString &validator) const;
+    qint64 completedBytes() const;
+};
+
+#endif // DOWNLOADJOURNAL_H
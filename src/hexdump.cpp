@@ -0,0 +1,360 @@
+#include "hexdump.h"
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define HEXDUMP_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC不需要为单个函数开启指令集，直接使用内建函数即可
+#define HEXDUMP_TARGET_SSE2
+#define HEXDUMP_TARGET_AVX2
+#else
+#define HEXDUMP_TARGET_SSE2 __attribute__((target("sse2")))
+#define HEXDUMP_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+const char kHexDigits[] = "0123456789abcdef";
+constexpr int kOffsetDigits = 12;
+constexpr int kHexColumn = kOffsetDigits + 2;
+constexpr int kAsciiColumn = kHexColumn + 50;
+constexpr int kRowStride = HexDump::kRowLength + 1;
+static_assert(kAsciiColumn + HexDump::kBytesPerRow == HexDump::kRowLength, "ASCII列必须在行尾");
+
+int hexColumn(int byte)
+{
+    // 前8字节和后8字节之间多一个空格
+    return kHexColumn + 3 * byte + (byte >= 8 ? 1 : 0);
+}
+
+void writeOffset(char *out, quint64 offset)
+{
+    for (int i = kOffsetDigits - 1; i >= 0; --i) {
+        out[i] = kHexDigits[offset & 0xF];
+        offset >>= 4;
+    }
+}
+
+void scalarRow(const uchar *src, int count, quint64 offset, char *out)
+{
+    std::memset(out, ' ', HexDump::kRowLength);
+    writeOffset(out, offset);
+    for (int i = 0; i < count; ++i) {
+        char *hex = out + hexColumn(i);
+        hex[0] = kHexDigits[src[i] >> 4];
+        hex[1] = kHexDigits[src[i] & 0xF];
+        out[kAsciiColumn + i] = (src[i] >= 0x20 && src[i] < 0x7F) ? static_cast<char>(src[i]) : '.';
+    }
+}
+
+#ifdef HEXDUMP_X86
+// 一行的十六进制区域（偏移量之后的64列）由4个16字节块组成。
+// 每块的字符来自两组交错的十六进制字符（前8字节/后8字节各16个字符），
+// 用pshufb按下表搬运，下标为负的位置填空格
+struct ShuffleTables
+{
+    alignas(32) signed char first[4][32];
+    alignas(32) signed char second[4][32];
+    alignas(32) char spaces[4][32];
+};
+
+const ShuffleTables &shuffleTables()
+{
+    static const ShuffleTables tables = []() {
+        ShuffleTables t;
+        for (int block = 0; block < 4; ++block) {
+            for (int j = 0; j < 16; ++j) {
+                const int column = kOffsetDigits + block * 16 + j;
+                int source = -1;
+                for (int byte = 0; byte < HexDump::kBytesPerRow; ++byte) {
+                    if (column == hexColumn(byte) || column == hexColumn(byte) + 1) {
+                        source = 2 * byte + (column - hexColumn(byte));
+                    }
+                }
+                // AVX2的pshufb在两个128位通道内独立工作，两个通道用同一张表
+                for (int lane = 0; lane < 2; ++lane) {
+                    const int k = lane * 16 + j;
+                    t.first[block][k] = (source >= 0 && source < 16) ? static_cast<signed char>(source) : -128;
+                    t.second[block][k] = source >= 16 ? static_cast<signed char>(source - 16) : -128;
+                    t.spaces[block][k] = source < 0 ? ' ' : 0;
+                }
+            }
+        }
+        return t;
+    }();
+    return tables;
+}
+
+HEXDUMP_TARGET_SSE2 inline __m128i nibblesToHex(__m128i nibbles)
+{
+    const __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)),
+                                          _mm_set1_epi8('a' - '0' - 10));
+    return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+}
+
+HEXDUMP_TARGET_SSE2 inline __m128i printableAscii(__m128i bytes)
+{
+    // 有符号比较：0x80以上的字节为负数，自然落在可打印范围之外
+    const __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8(0x1F)),
+                                            _mm_cmplt_epi8(bytes, _mm_set1_epi8(0x7F)));
+    return _mm_or_si128(_mm_and_si128(printable, bytes), _mm_andnot_si128(printable, _mm_set1_epi8('.')));
+}
+
+// SSE2没有pshufb，十六进制字符向量化生成后逐对写入
+HEXDUMP_TARGET_SSE2 void sse2Row(const uchar *src, quint64 offset, char *out)
+{
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+    const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+    const __m128i high = nibblesToHex(_mm_and_si128(_mm_srli_epi16(bytes, 4), nibbleMask));
+    const __m128i low = nibblesToHex(_mm_and_si128(bytes, nibbleMask));
+
+    alignas(16) char hex[32];
+    _mm_store_si128(reinterpret_cast<__m128i *>(hex), _mm_unpacklo_epi8(high, low));
+    _mm_store_si128(reinterpret_cast<__m128i *>(hex + 16), _mm_unpackhi_epi8(high, low));
+
+    std::memset(out + kOffsetDigits, ' ', kAsciiColumn - kOffsetDigits);
+    writeOffset(out, offset);
+    for (int i = 0; i < HexDump::kBytesPerRow; ++i) {
+        std::memcpy(out + hexColumn(i), hex + 2 * i, 2);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + kAsciiColumn), printableAscii(bytes));
+}
+
+// 一次处理两行：每行占一个128位通道，pshufb在通道内把字符直接搬到最终列
+HEXDUMP_TARGET_AVX2 void avx2TwoRows(const uchar *src, quint64 offset, char *out)
+{
+    const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+    const __m256i nibbleMask = _mm256_set1_epi8(0x0F);
+    const __m256i nine = _mm256_set1_epi8(9);
+    const __m256i letterGap = _mm256_set1_epi8('a' - '0' - 10);
+    const __m256i zero = _mm256_set1_epi8('0');
+
+    const __m256i highNibbles = _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibbleMask);
+    const __m256i lowNibbles = _mm256_and_si256(bytes, nibbleMask);
+    const __m256i high = _mm256_add_epi8(_mm256_add_epi8(highNibbles, zero),
+                                         _mm256_and_si256(_mm256_cmpgt_epi8(highNibbles, nine), letterGap));
+    const __m256i low = _mm256_add_epi8(_mm256_add_epi8(lowNibbles, zero),
+                                        _mm256_and_si256(_mm256_cmpgt_epi8(lowNibbles, nine), letterGap));
+    const __m256i first = _mm256_unpacklo_epi8(high, low);
+    const __m256i second = _mm256_unpackhi_epi8(high, low);
+
+    char *row0 = out;
+    char *row1 = out + kRowStride;
+    const ShuffleTables &tables = shuffleTables();
+    for (int block = 0; block < 4; ++block) {
+        const __m256i firstMask = _mm256_load_si256(reinterpret_cast<const __m256i *>(tables.first[block]));
+        const __m256i secondMask = _mm256_load_si256(reinterpret_cast<const __m256i *>(tables.second[block]));
+        const __m256i spaces = _mm256_load_si256(reinterpret_cast<const __m256i *>(tables.spaces[block]));
+        const __m256i chars = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(first, firstMask),
+                                                              _mm256_shuffle_epi8(second, secondMask)),
+                                              spaces);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(row0 + kOffsetDigits + block * 16),
+                         _mm256_castsi256_si128(chars));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(row1 + kOffsetDigits + block * 16),
+                         _mm256_extracti128_si256(chars, 1));
+    }
+
+    // ASCII列覆盖十六进制区域最后一块多写的部分
+    const __m256i printable = _mm256_and_si256(_mm256_cmpgt_epi8(bytes, _mm256_set1_epi8(0x1F)),
+                                               _mm256_cmpgt_epi8(_mm256_set1_epi8(0x7F), bytes));
+    const __m256i ascii = _mm256_blendv_epi8(_mm256_set1_epi8('.'), bytes, printable);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(row0 + kAsciiColumn), _mm256_castsi256_si128(ascii));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(row1 + kAsciiColumn), _mm256_extracti128_si256(ascii, 1));
+
+    writeOffset(row0, offset);
+    writeOffset(row1, offset + HexDump::kBytesPerRow);
+}
+
+bool cpuHasAvx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+bool cpuHasSse2()
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    return true;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+#endif // HEXDUMP_X86
+} // namespace
+
+bool HexDump::isSupported(Implementation implementation)
+{
+#ifdef HEXDUMP_X86
+    static const bool sse2 = cpuHasSse2();
+    static const bool avx2 = sse2 && cpuHasAvx2();
+    switch (implementation) {
+    case Scalar:
+        return true;
+    case Sse2:
+        return sse2;
+    case Avx2:
+        return avx2;
+    }
+    return false;
+#else
+    return implementation == Scalar;
+#endif
+}
+
+HexDump::Implementation HexDump::bestImplementation()
+{
+    static const Implementation best = isSupported(Avx2) ? Avx2 : (isSupported(Sse2) ? Sse2 : Scalar);
+    return best;
+}
+
+const char *HexDump::implementationName(Implementation implementation)
+{
+    switch (implementation) {
+    case Scalar:
+        return "scalar";
+    case Sse2:
+        return "SSE2";
+    case Avx2:
+        return "AVX2";
+    }
+    return "unknown";
+}
+
+qint64 HexDump::formatRows(const uchar *data, qint64 size, qint64 firstRow, int rows, char *out)
+{
+    return formatRows(data, size, firstRow, rows, out, bestImplementation());
+}
+
+qint64 HexDump::formatRows(const uchar *data, qint64 size, qint64 firstRow, int rows, char *out,
+                           Implementation implementation)
+{
+    if (!isSupported(implementation)) {
+        implementation = Scalar;
+    }
+    const qint64 totalRows = (size + kBytesPerRow - 1) / kBytesPerRow;
+    const qint64 endRow = qMin(firstRow + rows, totalRows);
+    const qint64 fullRowsEnd = qMin(endRow, size / kBytesPerRow);
+    qint64 row = firstRow;
+    char *cursor = out;
+
+#ifdef HEXDUMP_X86
+    if (implementation == Avx2) {
+        for (; row + 1 < fullRowsEnd; row += 2, cursor += 2 * kRowStride) {
+            avx2TwoRows(data + row * kBytesPerRow, static_cast<quint64>(row * kBytesPerRow), cursor);
+            cursor[kRowLength] = '\n';
+            cursor[kRowStride + kRowLength] = '\n';
+        }
+    }
+    if (implementation != Scalar) {
+        for (; row < fullRowsEnd; ++row, cursor += kRowStride) {
+            sse2Row(data + row * kBytesPerRow, static_cast<quint64>(row * kBytesPerRow), cursor);
+            cursor[kRowLength] = '\n';
+        }
+    }
+#endif
+
+    for (; row < endRow; ++row, cursor += kRowStride) {
+        const int count = static_cast<int>(qMin<qint64>(kBytesPerRow, size - row * kBytesPerRow));
+        scalarRow(data + row * kBytesPerRow, count, static_cast<quint64>(row * kBytesPerRow), cursor);
+        cursor[kRowLength] = '\n';
+    }
+    return cursor - out;
+}
+
+QString HexDump::formatRow(const uchar *data, qint64 size, qint64 row)
+{
+    char line[kRowStride];
+    if (formatRows(data, size, row, 1, line) == 0) {
+        return QString();
+    }
+    return QString::fromLatin1(line, kRowLength);
+}
+
+QString HexDump::benchmark()
+{
+    constexpr qint64 kInputSize = 64 * 1024 * 1024;
+    constexpr int kPageRows = 4096;
+    constexpr qint64 kMinDurationMs = 500;
+
+    // 伪随机输入，保证可打印/不可打印字符混合出现
+    QByteArray input(kInputSize, Qt::Uninitialized);
+    quint32 state = 2463534242u;
+    for (qint64 i = 0; i < kInputSize; ++i) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        input[i] = static_cast<char>(state);
+    }
+    // 末尾不足一行，顺带覆盖标量收尾路径
+    const qint64 size = kInputSize - 5;
+    const uchar *data = reinterpret_cast<const uchar *>(input.constData());
+    const qint64 totalRows = (size + kBytesPerRow - 1) / kBytesPerRow;
+
+    QByteArray page(kPageRows * kRowStride, Qt::Uninitialized);
+    QByteArray reference(kPageRows * kRowStride, Qt::Uninitialized);
+    const qint64 checkRow = totalRows - kPageRows / 2;
+
+    QString report = QString("十六进制转储基准: 输入 %1 MiB, 每页 %2 行, 当前使用 %3\n")
+                         .arg(kInputSize / (1024 * 1024))
+                         .arg(kPageRows)
+                         .arg(implementationName(bestImplementation()));
+
+    const Implementation implementations[] = { Scalar, Sse2, Avx2 };
+    for (Implementation implementation : implementations) {
+        const QString name = QString::fromLatin1(implementationName(implementation));
+        if (!isSupported(implementation)) {
+            report += QString("  %1: 当前CPU不支持\n").arg(name, -6);
+            continue;
+        }
+
+        // 与标量实现逐字节比对开头和结尾两页
+        bool identical = true;
+        for (qint64 first : { qint64(0), checkRow }) {
+            const qint64 written = formatRows(data, size, first, kPageRows, page.data(), implementation);
+            formatRows(data, size, first, kPageRows, reference.data(), Scalar);
+            identical = identical && std::memcmp(page.constData(), reference.constData(), written) == 0;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        qint64 processed = 0;
+        do {
+            for (qint64 row = 0; row < totalRows; row += kPageRows) {
+                formatRows(data, size, row, kPageRows, page.data(), implementation);
+            }
+            processed += size;
+        } while (timer.elapsed() < kMinDurationMs);
+        const double seconds = timer.nsecsElapsed() / 1e9;
+        const double inputRate = processed / seconds / 1e9;
+
+        report += QString("  %1: %2 GB/s 输入, %3 GB/s 输出%4\n")
+                      .arg(name, -6)
+                      .arg(inputRate, 0, 'f', 2)
+                      .arg(inputRate * kRowStride / kBytesPerRow, 0, 'f', 2)
+                      .arg(identical ? QString() : QString(" (与标量结果不一致!)"));
+    }
+    return report;
+}
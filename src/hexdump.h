@@ -0,0 +1,36 @@
+#ifndef HEXDUMP_H
+#define HEXDUMP_H
+
+#include <QString>
+#include <QtGlobal>
+
+// 十六进制+ASCII转储格式化。每行16字节，固定80个字符：
+// "00000000abcd  00 11 22 33 44 55 66 77  88 99 aa bb cc dd ee ff  ................"
+// 偏移量12位十六进制，超过4 GiB的溢出文件也不会回绕
+// 完整的行用SIMD（SSE2/AVX2，运行时选择）格式化，末尾不足16字节的行走标量路径
+class HexDump
+{
+public:
+    enum Implementation { Scalar, Sse2, Avx2 };
+
+    static constexpr int kBytesPerRow = 16;
+    static constexpr int kRowLength = 80;
+
+    // 当前CPU支持的最快实现
+    static Implementation bestImplementation();
+    static const char *implementationName(Implementation implementation);
+    static bool isSupported(Implementation implementation);
+
+    // 从firstRow开始格式化最多rows行，每行kRowLength个字符后跟'\n'
+    // out至少需要 rows * (kRowLength + 1) 字节，返回实际写入的字节数
+    static qint64 formatRows(const uchar *data, qint64 size, qint64 firstRow, int rows, char *out);
+    static qint64 formatRows(const uchar *data, qint64 size, qint64 firstRow, int rows, char *out,
+                             Implementation implementation);
+    // 单行，供查看器逐行绘制
+    static QString formatRow(const uchar *data, qint64 size, qint64 row);
+
+    // --bench-hexdump：各实现的格式化速度（按输入字节计GB/s）
+    static QString benchmark();
+};
+
+#endif // HEXDUMP_H
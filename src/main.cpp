@@ -1,22 +1,90 @@
 #include <QApplication>
+#include <QFutureWatcher>
 #include <QStyleFactory>
+#include <QTextStream>
+#include <QTimer>
+#include "curlruntime.h"
+#include "hexdump.h"
 #include "mainwindow.h"
+#include "spanprofiler.h"
+#include "startupprofiler.h"
+#include "transfertracer.h"
 
 int main(int argc, char *argv[])
 {
+    // 十六进制转储微基准，不需要创建界面
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--bench-hexdump") == 0) {
+            QTextStream(stdout) << HexDump::benchmark();
+            return 0;
+        }
+    }
+    
+    StartupProfiler::start();
     QApplication app(argc, argv);
+    StartupProfiler::mark("QApplication已创建");
+    
+    // libcurl全局初始化和TLS库加载放到后台线程，与界面构建并行；
+    // CA证书的解析由主窗口创建后的连接池预热在工作线程上完成
+    const QFuture<void> curlReady = CurlRuntime::initAsync();
     
     // 设置应用程序信息
     app.setApplicationName("EasyProxyClient");
     app.setApplicationVersion("1.0.0");
     app.setOrganizationName("EasyProxyClient");
+    const bool startupProfile = app.arguments().contains("--startup-profile");
+    // --profile-spans[=文件]：从启动开始记录耗时剖析和传输时间线，退出时写入文件
+    QString spanProfilePath;
+    for (const QString &arg : app.arguments()) {
+        if (arg == "--profile-spans") {
+            spanProfilePath = "spans.json";
+        } else if (arg.startsWith("--profile-spans=")) {
+            spanProfilePath = arg.mid(16);
+        }
+    }
+    if (!spanProfilePath.isEmpty()) {
+        SpanProfiler::setEnabled(true);
+        TransferTracer::setEnabled(true);
+    }
     
     // 设置应用程序样式
     app.setStyle(QStyleFactory::create("Fusion"));
+    StartupProfiler::mark("样式已设置");
+    
+    int ret = 0;
+    {
+        // 创建并显示主窗口
+        MainWindow window;
+        StartupProfiler::mark("主窗口已创建");
+        window.show();
+        
+        // 事件循环开始后窗口才真正显示出来；curl就绪后结束记录
+        QTimer::singleShot(0, &window, [&window, curlReady, startupProfile]() {
+            StartupProfiler::mark("主窗口已显示");
+            QFutureWatcher<void> *watcher = new QFutureWatcher<void>(&window);
+            QObject::connect(watcher, &QFutureWatcher<void>::finished, &window, [watcher, startupProfile]() {
+                const QString report = StartupProfiler::report();
+                if (startupProfile) {
+                    QTextStream(stdout) << report;
+                }
+                watcher->deleteLater();
+            });
+            watcher->setFuture(curlReady);
+        });
+        
+        ret = app.exec();
+    }
     
-    // 创建并显示主窗口
-    MainWindow window;
-    window.show();
+    if (!spanProfilePath.isEmpty()) {
+        QString error;
+        if (SpanProfiler::exportChromeTrace(spanProfilePath, &error)) {
+            QTextStream(stdout) << "耗时剖析已写入 " << spanProfilePath << "\n";
+        } else {
+            QTextStream(stderr) << "写入耗时剖析失败: " << error << "\n";
+        }
+    }
     
-    return app.exec();
-} 
\ No newline at end of file
+    // 所有curl句柄随窗口释放后再做全局清理
+    CurlRuntime::cleanup();
+    return ret;
+}
@@ -1,16 +1,30 @@
 #include "mainwindow.h"
+#include "spanprofiler.h"
+#include "transfertracer.h"
 #include <QApplication>
 #include <QCloseEvent>
+#include <QFile>
+#include <QInputDialog>
+#include <QLocale>
+#include <QUrl>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , proxyClient(new ProxyClient(this))
+    , throughputTester(new ThroughputTester(this))
+    , webSocketBenchmark(new WebSocketBenchmark(this))
+    , tlsBenchmark(new TlsHandshakeBenchmark(this))
+    , rangeDownloader(new RangeDownloader(this))
+    , rttMonitorDialog(nullptr)
     , configManager(new ConfigManager(this))
 {
     setupUI();
     setupMenuBar();
     setupConnections();
     loadConfigToUI();
+    // 网络层拿到启动时的配置，并提前为当前档案建立隧道，第一次请求不用等连接
+    proxyClient->setSettings(configManager->snapshot());
+    proxyClient->prewarm(urlEdit->text());
     
     // 设置窗口属性
     setWindowTitle("EasyProxyClient");
@@ -24,7 +38,6 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
-    saveConfigFromUI();
 }
 
 void MainWindow::closeEvent(QCloseEvent *event)
@@ -43,35 +56,65 @@ void MainWindow::setupUI()
     // 目标网址组
     targetGroup = new QGroupBox("目标网址", centralWidget);
     QVBoxLayout *targetLayout = new QVBoxLayout(targetGroup);
+    QHBoxLayout *urlLayout = new QHBoxLayout();
+    methodCombo = new QComboBox(targetGroup);
+    methodCombo->addItems({ "GET", "POST", "PUT" });
+    urlLayout->addWidget(methodCombo);
     urlEdit = new QLineEdit(targetGroup);
     urlEdit->setPlaceholderText("请输入要访问的网址 (例如: https://example.com)");
-    targetLayout->addWidget(urlEdit);
+    urlLayout->addWidget(urlEdit, 1);
+    targetLayout->addLayout(urlLayout);
+    
+    QHBoxLayout *uploadLayout = new QHBoxLayout();
+    uploadLayout->addWidget(new QLabel("请求体:"));
+    uploadPathEdit = new QLineEdit(targetGroup);
+    uploadPathEdit->setPlaceholderText("POST/PUT上传的文件，输入 - 表示从标准输入读取");
+    uploadLayout->addWidget(uploadPathEdit, 1);
+    uploadBrowseButton = new QPushButton("浏览...", targetGroup);
+    uploadLayout->addWidget(uploadBrowseButton);
+    targetLayout->addLayout(uploadLayout);
+    onMethodChanged(methodCombo->currentIndex());
     mainLayout->addWidget(targetGroup);
     
     // 代理设置组
     proxyGroup = new QGroupBox("代理设置", centralWidget);
     QGridLayout *proxyLayout = new QGridLayout(proxyGroup);
     
-    proxyLayout->addWidget(new QLabel("代理主机:"), 0, 0);
+    proxyLayout->addWidget(new QLabel("配置档案:"), 0, 0);
+    profileCombo = new QComboBox(proxyGroup);
+    proxyLayout->addWidget(profileCombo, 0, 1);
+    QHBoxLayout *profileButtons = new QHBoxLayout();
+    addProfileButton = new QPushButton("新建档案", proxyGroup);
+    removeProfileButton = new QPushButton("删除档案", proxyGroup);
+    profileButtons->addWidget(addProfileButton);
+    profileButtons->addWidget(removeProfileButton);
+    proxyLayout->addLayout(profileButtons, 0, 2, 1, 2);
+    
+    proxyLayout->addWidget(new QLabel("代理主机:"), 1, 0);
     proxyHostEdit = new QLineEdit(proxyGroup);
     proxyHostEdit->setPlaceholderText("代理服务器IP或域名");
-    proxyLayout->addWidget(proxyHostEdit, 0, 1);
+    proxyLayout->addWidget(proxyHostEdit, 1, 1);
     
-    proxyLayout->addWidget(new QLabel("代理端口:"), 0, 2);
+    proxyLayout->addWidget(new QLabel("代理端口:"), 1, 2);
     proxyPortEdit = new QLineEdit(proxyGroup);
     proxyPortEdit->setPlaceholderText("端口");
-    proxyLayout->addWidget(proxyPortEdit, 0, 3);
+    proxyLayout->addWidget(proxyPortEdit, 1, 3);
     
-    proxyLayout->addWidget(new QLabel("用户名:"), 1, 0);
+    proxyLayout->addWidget(new QLabel("用户名:"), 2, 0);
     usernameEdit = new QLineEdit(proxyGroup);
     usernameEdit->setPlaceholderText("代理用户名");
-    proxyLayout->addWidget(usernameEdit, 1, 1);
+    proxyLayout->addWidget(usernameEdit, 2, 1);
     
-    proxyLayout->addWidget(new QLabel("密码:"), 1, 2);
+    proxyLayout->addWidget(new QLabel("密码:"), 2, 2);
     passwordEdit = new QLineEdit(proxyGroup);
     passwordEdit->setPlaceholderText("代理密码");
     passwordEdit->setEchoMode(QLineEdit::Password);
-    proxyLayout->addWidget(passwordEdit, 1, 3);
+    proxyLayout->addWidget(passwordEdit, 2, 3);
+    
+    compressionCheck = new QCheckBox("启用压缩传输 (gzip/deflate/br/zstd)", proxyGroup);
+    proxyLayout->addWidget(compressionCheck, 3, 0, 1, 2);
+    cacheCheck = new QCheckBox("启用响应缓存 (仅GET)", proxyGroup);
+    proxyLayout->addWidget(cacheCheck, 3, 2, 1, 2);
 
     
     mainLayout->addWidget(proxyGroup);
@@ -103,6 +146,13 @@ void MainWindow::setupUI()
     progressBar->setVisible(false);
     controlLayout->addWidget(progressBar);
     
+    speedLabel = new QLabel(centralWidget);
+    speedLabel->setVisible(false);
+    controlLayout->addWidget(speedLabel);
+    
+    progressTimer = new QTimer(this);
+    progressTimer->setInterval(33); // 约30Hz
+    
     mainLayout->addLayout(controlLayout);
     
     // 调试信息显示
@@ -112,7 +162,27 @@ void MainWindow::setupUI()
     debugText->setReadOnly(true);
     debugText->setFont(QFont("Consolas", 9));
     debugLayout->addWidget(debugText);
-    mainLayout->addWidget(debugGroup);
+    
+    // 响应内容显示，只绘制可见行，大响应直接从转存文件的内存映射读取
+    QGroupBox *responseGroup = new QGroupBox("响应内容", centralWidget);
+    QVBoxLayout *responseLayout = new QVBoxLayout(responseGroup);
+    QHBoxLayout *responseHeader = new QHBoxLayout();
+    responseModeCombo = new QComboBox(responseGroup);
+    responseModeCombo->addItem("文本", ResponseView::TextMode);
+    responseModeCombo->addItem("十六进制", ResponseView::HexMode);
+    responseSizeLabel = new QLabel(responseGroup);
+    responseHeader->addWidget(new QLabel("显示方式:", responseGroup));
+    responseHeader->addWidget(responseModeCombo);
+    responseHeader->addStretch();
+    responseHeader->addWidget(responseSizeLabel);
+    responseLayout->addLayout(responseHeader);
+    responseView = new ResponseView(responseGroup);
+    responseLayout->addWidget(responseView);
+    
+    QSplitter *outputSplitter = new QSplitter(Qt::Vertical, centralWidget);
+    outputSplitter->addWidget(debugGroup);
+    outputSplitter->addWidget(responseGroup);
+    mainLayout->addWidget(outputSplitter);
 }
 
 void MainWindow::setupMenuBar()
@@ -130,6 +200,39 @@ void MainWindow::setupMenuBar()
     settingsMenu = menuBar->addMenu("设置(&S)");
     QAction *resetAction = settingsMenu->addAction("重置为默认值(&R)");
     
+    // 工具菜单
+    toolsMenu = menuBar->addMenu("工具(&T)");
+    QAction *throughputAction = toolsMenu->addAction("吞吐量测试(&T)");
+    cancelThroughputAction = toolsMenu->addAction("停止吞吐量测试(&U)");
+    cancelThroughputAction->setEnabled(false);
+    QAction *webSocketAction = toolsMenu->addAction("WebSocket回显测试(&W)...");
+    cancelWebSocketAction = toolsMenu->addAction("停止WebSocket回显测试(&Q)");
+    cancelWebSocketAction->setEnabled(false);
+    QAction *tlsBenchmarkAction = toolsMenu->addAction("TLS握手开销测试(&H)...");
+    cancelTlsBenchmarkAction = toolsMenu->addAction("停止TLS握手开销测试(&K)");
+    cancelTlsBenchmarkAction->setEnabled(false);
+    QAction *rttMonitorAction = toolsMenu->addAction("隧道RTT监视(&R)...");
+    QAction *rangeDownloadAction = toolsMenu->addAction("分段并行下载(&D)...");
+    cancelRangeDownloadAction = toolsMenu->addAction("停止分段下载(&S)");
+    cancelRangeDownloadAction->setEnabled(false);
+    batchAction = toolsMenu->addAction("批量请求(&B)...");
+    cancelBatchAction = toolsMenu->addAction("取消批量请求(&C)");
+    cancelBatchAction->setEnabled(false);
+    toolsMenu->addSeparator();
+    QAction *clearPinAction = toolsMenu->addAction("清除代理公钥固定(&P)");
+    toolsMenu->addSeparator();
+    QAction *traceAction = toolsMenu->addAction("记录传输时间线(&L)");
+    traceAction->setCheckable(true);
+    QAction *exportTraceAction = toolsMenu->addAction("导出传输时间线(&E)...");
+    QAction *spanProfileAction = toolsMenu->addAction("记录界面与回调耗时(&F)");
+    spanProfileAction->setCheckable(true);
+    spanProfileAction->setShortcut(QKeySequence("Ctrl+Alt+P"));
+    QAction *exportSpansAction = toolsMenu->addAction("导出耗时剖析(&X)...");
+    exportSpansAction->setShortcut(QKeySequence("Ctrl+Alt+E"));
+    // --profile-spans启动时两种记录已经开启
+    traceAction->setChecked(TransferTracer::isEnabled());
+    spanProfileAction->setChecked(SpanProfiler::isEnabled());
+    
     // 帮助菜单
     helpMenu = menuBar->addMenu("帮助(&H)");
     QAction *aboutAction = helpMenu->addAction("关于(&A)");
@@ -137,31 +240,110 @@ void MainWindow::setupMenuBar()
     // 连接菜单信号
     connect(saveAction, &QAction::triggered, this, &MainWindow::saveSettings);
     connect(loadAction, &QAction::triggered, this, &MainWindow::loadSettings);
-    connect(exitAction, &QAction::triggered, []() { QApplication::quit(); });
+    // 通过close()退出，保证closeEvent中的配置保存只走一次
+    connect(exitAction, &QAction::triggered, this, &QWidget::close);
     connect(resetAction, &QAction::triggered, this, &MainWindow::resetSettings);
     connect(aboutAction, &QAction::triggered, this, &MainWindow::about);
+    connect(throughputAction, &QAction::triggered, this, &MainWindow::runThroughputTest);
+    connect(cancelThroughputAction, &QAction::triggered, throughputTester, &ThroughputTester::cancel);
+    connect(webSocketAction, &QAction::triggered, this, &MainWindow::runWebSocketBenchmark);
+    connect(cancelWebSocketAction, &QAction::triggered, webSocketBenchmark, &WebSocketBenchmark::cancel);
+    connect(tlsBenchmarkAction, &QAction::triggered, this, &MainWindow::runTlsBenchmark);
+    connect(cancelTlsBenchmarkAction, &QAction::triggered, tlsBenchmark, &TlsHandshakeBenchmark::cancel);
+    connect(rttMonitorAction, &QAction::triggered, this, &MainWindow::showRttMonitor);
+    connect(rangeDownloadAction, &QAction::triggered, this, &MainWindow::runRangeDownload);
+    connect(cancelRangeDownloadAction, &QAction::triggered, rangeDownloader, &RangeDownloader::cancel);
+    connect(batchAction, &QAction::triggered, this, &MainWindow::runBatch);
+    connect(cancelBatchAction, &QAction::triggered, proxyClient, &ProxyClient::cancelBatch);
+    connect(clearPinAction, &QAction::triggered, this, &MainWindow::clearPinnedPublicKey);
+    connect(traceAction, &QAction::toggled, this, &MainWindow::setTransferTracing);
+    connect(exportTraceAction, &QAction::triggered, this, &MainWindow::exportTransferTrace);
+    connect(spanProfileAction, &QAction::toggled, this, &MainWindow::setSpanProfiling);
+    connect(exportSpansAction, &QAction::triggered, this, &MainWindow::exportSpanProfile);
 }
 
 void MainWindow::setupConnections()
 {
     connect(browseButton, &QPushButton::clicked, this, &MainWindow::browseCertificate);
+    connect(uploadBrowseButton, &QPushButton::clicked, this, &MainWindow::browseUploadFile);
+    connect(methodCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::onMethodChanged);
     connect(connectButton, &QPushButton::clicked, this, &MainWindow::connectToProxy);
     connect(saveConfigButton, &QPushButton::clicked, this, &MainWindow::saveConfigButtonClicked);
+    connect(profileCombo, &QComboBox::textActivated, this, &MainWindow::switchProfile);
+    connect(addProfileButton, &QPushButton::clicked, this, &MainWindow::addProfile);
+    connect(removeProfileButton, &QPushButton::clicked, this, &MainWindow::removeProfile);
     
     // 连接代理客户端信号
     connect(proxyClient, &ProxyClient::connectionStarted, this, &MainWindow::onConnectionStarted);
     connect(proxyClient, &ProxyClient::connectionFinished, this, &MainWindow::onConnectionFinished);
     connect(proxyClient, &ProxyClient::networkError, this, &MainWindow::onNetworkError);
     connect(proxyClient, &ProxyClient::debugMessage, this, &MainWindow::onDebugMessage);
+    connect(proxyClient, &ProxyClient::responseReceived, this, &MainWindow::onResponseReceived);
+    connect(proxyClient, &ProxyClient::proxyPublicKeyCaptured, this, &MainWindow::onProxyPublicKeyCaptured);
+    connect(progressTimer, &QTimer::timeout, this, &MainWindow::updateTransferProgress);
+    connect(proxyClient, &ProxyClient::batchFinished, this, [this](const QString &summary) {
+        debugText->append("\n" + summary);
+        batchAction->setEnabled(true);
+        cancelBatchAction->setEnabled(false);
+    });
+    connect(responseModeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        responseView->setMode(static_cast<ResponseView::Mode>(responseModeCombo->itemData(index).toInt()));
+    });
+    
+    // 配置文件被外部修改时刷新界面和网络层
+    connect(configManager, &ConfigManager::settingsReloaded, this, &MainWindow::onSettingsReloaded);
+    
+    // 连接吞吐量测试信号
+    connect(throughputTester, &ThroughputTester::sample, this, &MainWindow::onDebugMessage);
+    connect(throughputTester, &ThroughputTester::testFinished, this, [this](const QString &summary) {
+        debugText->append("\n" + summary);
+        connectButton->setEnabled(true);
+        cancelThroughputAction->setEnabled(false);
+    });
+    
+    // 连接WebSocket回显测试信号
+    connect(webSocketBenchmark, &WebSocketBenchmark::sample, this, &MainWindow::onDebugMessage);
+    connect(webSocketBenchmark, &WebSocketBenchmark::testFinished, this, [this](const QString &summary) {
+        debugText->append("\n" + summary);
+        connectButton->setEnabled(true);
+        cancelWebSocketAction->setEnabled(false);
+    });
+    
+    // 连接TLS握手测试信号
+    connect(tlsBenchmark, &TlsHandshakeBenchmark::sample, this, &MainWindow::onDebugMessage);
+    connect(tlsBenchmark, &TlsHandshakeBenchmark::testFinished, this, [this](const QString &summary) {
+        debugText->append("\n" + summary);
+        connectButton->setEnabled(true);
+        cancelTlsBenchmarkAction->setEnabled(false);
+    });
+    
+    // 连接分段并行下载信号
+    connect(rangeDownloader, &RangeDownloader::sample, this, &MainWindow::onDebugMessage);
+    connect(rangeDownloader, &RangeDownloader::testFinished, this, [this](const QString &summary) {
+        debugText->append("\n" + summary);
+        connectButton->setEnabled(true);
+        cancelRangeDownloadAction->setEnabled(false);
+    });
 }
 
 void MainWindow::loadConfigToUI()
 {
+    ScopedSpan span("MainWindow::loadConfigToUI");
+    // 刷新档案列表，程序化修改不触发切换
+    profileCombo->blockSignals(true);
+    profileCombo->clear();
+    profileCombo->addItems(configManager->profileNames());
+    profileCombo->setCurrentText(configManager->activeProfile());
+    profileCombo->blockSignals(false);
+    removeProfileButton->setEnabled(configManager->profileNames().size() > 1);
+    
     // 加载代理设置
     proxyHostEdit->setText(configManager->getProxyHost());
     proxyPortEdit->setText(QString::number(configManager->getProxyPort()));
     usernameEdit->setText(configManager->getProxyUsername());
     passwordEdit->setText(configManager->getProxyPassword());
+    compressionCheck->setChecked(configManager->getCompressionEnabled());
+    cacheCheck->setChecked(configManager->getCacheEnabled());
     
     // 加载SSL证书设置
     certificatePathEdit->setText(configManager->getCertificatePath());
@@ -170,13 +352,16 @@ void MainWindow::loadConfigToUI()
     urlEdit->setText(configManager->getLastUrl());
 }
 
-void MainWindow::saveConfigFromUI()
+void MainWindow::applyUIToConfig()
 {
+    ScopedSpan span("MainWindow::applyUIToConfig");
     // 保存代理设置
     configManager->setProxyHost(proxyHostEdit->text());
     configManager->setProxyPort(proxyPortEdit->text().toInt());
     configManager->setProxyUsername(usernameEdit->text());
     configManager->setProxyPassword(passwordEdit->text());
+    configManager->setCompressionEnabled(compressionCheck->isChecked());
+    configManager->setCacheEnabled(cacheCheck->isChecked());
     
     // 保存SSL证书设置
     configManager->setCertificatePath(certificatePathEdit->text());
@@ -186,11 +371,83 @@ void MainWindow::saveConfigFromUI()
     
     // 保存窗口大小
     configManager->setWindowSize(width(), height());
+}
+
+void MainWindow::saveConfigFromUI()
+{
+    ScopedSpan span("MainWindow::saveConfigFromUI");
+    applyUIToConfig();
     
-    // 保存配置
+    // 只有内容变化时才写盘
     configManager->saveConfig();
 }
 
+ProxyOptions MainWindow::proxyOptionsFromUI()
+{
+    applyUIToConfig();
+    return configManager->snapshot()->proxyOptions();
+}
+
+void MainWindow::switchProfile(const QString &name)
+{
+    ScopedSpan span("MainWindow::switchProfile");
+    if (name == configManager->activeProfile()) {
+        return;
+    }
+    
+    // 先把界面上的修改记到原档案，再切换
+    applyUIToConfig();
+    configManager->setActiveProfile(name);
+    loadConfigToUI();
+    
+    // 每个档案有自己的连接池，切换回已使用过的档案不需要重新建立连接
+    proxyClient->setSettings(configManager->snapshot());
+    proxyClient->prewarm(urlEdit->text());
+}
+
+void MainWindow::addProfile()
+{
+    bool ok = false;
+    const QString name = QInputDialog::getText(this, "新建档案",
+        "档案名称（以当前档案的设置为模板）:", QLineEdit::Normal, QString(), &ok).trimmed();
+    if (!ok || name.isEmpty()) {
+        return;
+    }
+    
+    applyUIToConfig();
+    if (!configManager->addProfile(name)) {
+        showError("档案名称无效或已存在");
+        return;
+    }
+    loadConfigToUI();
+    proxyClient->setSettings(configManager->snapshot());
+}
+
+void MainWindow::removeProfile()
+{
+    const QString name = configManager->activeProfile();
+    int ret = QMessageBox::question(this, "删除档案",
+                                   QString("确定要删除档案 \"%1\" 吗？").arg(name),
+                                   QMessageBox::Yes | QMessageBox::No);
+    if (ret != QMessageBox::Yes) {
+        return;
+    }
+    
+    if (!configManager->removeProfile(name)) {
+        showError("至少需要保留一个档案");
+        return;
+    }
+    loadConfigToUI();
+    proxyClient->setSettings(configManager->snapshot());
+}
+
+void MainWindow::onSettingsReloaded(const ConfigChanges &changes)
+{
+    ScopedSpan span("MainWindow::onSettingsReloaded");
+    loadConfigToUI();
+    proxyClient->reconfigure(configManager->snapshot(), changes);
+}
+
 void MainWindow::browseCertificate()
 {
     QString fileName = QFileDialog::getOpenFileName(this,
@@ -200,8 +457,25 @@ void MainWindow::browseCertificate()
     }
 }
 
+void MainWindow::browseUploadFile()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, "选择请求体文件", "", "所有文件 (*)");
+    if (!fileName.isEmpty()) {
+        uploadPathEdit->setText(fileName);
+    }
+}
+
+void MainWindow::onMethodChanged(int index)
+{
+    // 只有POST/PUT需要请求体
+    const bool hasBody = index > 0;
+    uploadPathEdit->setEnabled(hasBody);
+    uploadBrowseButton->setEnabled(hasBody);
+}
+
 void MainWindow::connectToProxy()
 {
+    ScopedSpan span("MainWindow::connectToProxy");
     // 基本输入验证
     if (urlEdit->text().isEmpty()) {
         showError("请输入目标网址");
@@ -218,38 +492,80 @@ void MainWindow::connectToProxy()
         return;
     }
     
-    // 清空之前的调试信息
-    debugText->clear();
+    const QByteArray method = methodCombo->currentText().toLatin1();
+    const QString uploadPath = uploadPathEdit->text().trimmed();
+    if (method != "GET" && uploadPath.isEmpty()) {
+        showError("请选择要上传的请求体文件");
+        return;
+    }
     
-    // 配置代理客户端
-    proxyClient->setProxySettings(
-        proxyHostEdit->text(),
-        proxyPortEdit->text().toInt(),
-        usernameEdit->text(),
-        passwordEdit->text()
-    );
+    // 清空之前的调试信息和响应
+    debugText->clear();
+    responseView->clear();
+    responseSizeLabel->clear();
     
-    // 配置SSL证书
-    if (!certificatePathEdit->text().isEmpty()) {
-        proxyClient->setSslCertificate(certificatePathEdit->text());
-    }
+    // 界面上的修改先写入内存配置（不写盘），再把快照交给代理客户端
+    applyUIToConfig();
+    proxyClient->setSettings(configManager->snapshot());
     
     // 发起连接
-    proxyClient->connectToUrl(urlEdit->text());
+    proxyClient->connectToUrl(urlEdit->text(), method, method == "GET" ? QString() : uploadPath);
 }
 
 void MainWindow::onConnectionStarted()
 {
     // 显示进度条
     progressBar->setVisible(true);
-    progressBar->setRange(0, 0); // 不确定进度
+    progressBar->setRange(0, 0); // 收到Content-Length之前不确定进度
+    speedLabel->clear();
+    speedLabel->setVisible(true);
     connectButton->setEnabled(false);
+    progressTimer->start();
+}
+
+void MainWindow::updateTransferProgress()
+{
+    ScopedSpan span("MainWindow::updateTransferProgress");
+    const TransferProgress progress = proxyClient->progress();
+    const QLocale locale;
+    
+    // 上传阶段显示上传进度，之后显示下载进度
+    const bool uploading = progress.uploadTotal > 0 && progress.uploaded < progress.uploadTotal;
+    const qint64 done = uploading ? progress.uploaded : progress.downloaded;
+    const qint64 total = uploading ? progress.uploadTotal : progress.downloadTotal;
+    
+    // 有请求体时上传和下载速度同时显示
+    QString speed = locale.formattedDataSize(progress.downloadBytesPerSecond) + "/s";
+    if (progress.uploaded > 0) {
+        speed = QString("上传 %1/s  下载 %2")
+                    .arg(locale.formattedDataSize(progress.uploadBytesPerSecond))
+                    .arg(speed);
+    }
+    
+    if (total > 0) {
+        // 按千分比显示，避免超过int范围
+        progressBar->setRange(0, 1000);
+        progressBar->setValue(static_cast<int>(qMin<qint64>(done, total) * 1000 / total));
+        speedLabel->setText(QString("%1 / %2  %3")
+                                .arg(locale.formattedDataSize(done))
+                                .arg(locale.formattedDataSize(total))
+                                .arg(speed));
+    } else {
+        progressBar->setRange(0, 0);
+        speedLabel->setText(done > 0 ? QString("%1  %2")
+                                           .arg(locale.formattedDataSize(done))
+                                           .arg(speed)
+                                     : QString());
+    }
 }
 
 void MainWindow::onConnectionFinished(bool success, const QString &result)
 {
+    ScopedSpan span("MainWindow::onConnectionFinished");
     // 隐藏进度条
+    progressTimer->stop();
     progressBar->setVisible(false);
+    speedLabel->setVisible(false);
     connectButton->setEnabled(true);
     
     // 只显示最终状态，不重复显示结果
@@ -268,9 +584,110 @@ void MainWindow::onNetworkError(const QString &errorMessage)
 
 void MainWindow::onDebugMessage(const QString &message)
 {
+    ScopedSpan span("MainWindow::onDebugMessage");
     debugText->append(message);
 }
 
+void MainWindow::onResponseReceived(const QSharedPointer<ResponseData> &response)
+{
+    ScopedSpan span("MainWindow::onResponseReceived");
+    responseSizeLabel->setText(QString("%1 字节%2")
+                                   .arg(response->size())
+                                   .arg(response->isMapped() ? QString("（内存映射）") : QString()));
+    // 二进制协议载荷默认按十六进制显示
+    if (response->looksBinary()) {
+        responseModeCombo->setCurrentIndex(responseModeCombo->findData(ResponseView::HexMode));
+    }
+    responseView->setResponse(response);
+}
+
+void MainWindow::clearPinnedPublicKey()
+{
+    const QString pin = configManager->getPinnedPublicKey();
+    if (pin.isEmpty()) {
+        QMessageBox::information(this, "代理公钥固定",
+                                 QString("档案 \"%1\" 还没有固定代理公钥").arg(configManager->activeProfile()));
+        return;
+    }
+    int ret = QMessageBox::question(this, "代理公钥固定",
+                                   QString("档案 \"%1\" 当前固定的代理公钥:\n%2\n\n"
+                                           "清除后恢复用CA证书验证，下次连接成功时重新固定。确定清除吗？")
+                                       .arg(configManager->activeProfile(), pin),
+                                   QMessageBox::Yes | QMessageBox::No);
+    if (ret != QMessageBox::Yes) {
+        return;
+    }
+    configManager->setProfilePin(configManager->activeProfile(), QString());
+    proxyClient->setSettings(configManager->snapshot());
+}
+
+void MainWindow::setTransferTracing(bool enabled)
+{
+    // 每次开启都从空白开始，导出的时间线只包含这一段记录期间的传输
+    if (enabled) {
+        TransferTracer::clear();
+    }
+    TransferTracer::setEnabled(enabled);
+    debugText->append(enabled ? "开始记录传输时间线" : "已停止记录传输时间线");
+}
+
+void MainWindow::exportTransferTrace()
+{
+    const int count = TransferTracer::transferCount();
+    if (count == 0) {
+        QMessageBox::information(this, "传输时间线", "还没有记录到传输，请先开启\"记录传输时间线\"再发起请求");
+        return;
+    }
+    const QString fileName = QFileDialog::getSaveFileName(this, "导出传输时间线", "transfers.json",
+                                                          "Trace Event JSON (*.json)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+    QString error;
+    if (!TransferTracer::exportChromeTrace(fileName, &error)) {
+        showError("导出传输时间线失败: " + error);
+        return;
+    }
+    debugText->append(QString("已导出 %1 个传输的时间线，可在 chrome://tracing 或 Perfetto 中打开").arg(count));
+}
+
+void MainWindow::setSpanProfiling(bool enabled)
+{
+    if (enabled) {
+        SpanProfiler::clear();
+    }
+    SpanProfiler::setEnabled(enabled);
+    debugText->append(enabled ? "开始记录界面与回调耗时" : "已停止记录界面与回调耗时");
+}
+
+void MainWindow::exportSpanProfile()
+{
+    if (SpanProfiler::spanCount() == 0 && TransferTracer::transferCount() == 0) {
+        QMessageBox::information(this, "耗时剖析", "还没有记录到数据，请先开启\"记录界面与回调耗时\"（Ctrl+Alt+P）");
+        return;
+    }
+    const QString fileName = QFileDialog::getSaveFileName(this, "导出耗时剖析", "spans.json",
+                                                          "Trace Event JSON (*.json)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+    QString error;
+    if (!SpanProfiler::exportChromeTrace(fileName, &error)) {
+        showError("导出耗时剖析失败: " + error);
+        return;
+    }
+    debugText->append(QString("已导出 %1 个代码段和 %2 个传输的时间线")
+                          .arg(SpanProfiler::spanCount())
+                          .arg(TransferTracer::transferCount()));
+}
+
+void MainWindow::onProxyPublicKeyCaptured(const QString &profile, const QString &pin)
+{
+    // 捕获是一次性的，立即写盘，不等退出时保存；只写这一个键，不顺带保存界面上改到一半的字段
+    configManager->setProfilePin(profile, pin);
+    proxyClient->setSettings(configManager->snapshot());
+}
+
 void MainWindow::saveSettings()
 {
     saveConfigFromUI();
@@ -279,6 +696,7 @@ void MainWindow::saveSettings()
 
 void MainWindow::loadSettings()
 {
+    configManager->loadConfig();
     loadConfigToUI();
     QMessageBox::information(this, "加载设置", "设置已加载");
 }
@@ -291,6 +709,8 @@ void MainWindow::resetSettings()
     if (ret == QMessageBox::Yes) {
         configManager->resetToDefaults();
         loadConfigToUI();
+        proxyClient->setSettings(configManager->snapshot());
+        proxyClient->prewarm(urlEdit->text());
         QMessageBox::information(this, "重置设置", "设置已重置为默认值");
     }
 }
@@ -305,6 +725,248 @@ void MainWindow::about()
         "MIT License");
 }
 
+void MainWindow::runThroughputTest()
+{
+    if (throughputTester->isRunning() || webSocketBenchmark->isRunning() || tlsBenchmark->isRunning()) {
+        showError("已有测试正在进行中");
+        return;
+    }
+    
+    if (urlEdit->text().isEmpty() || proxyHostEdit->text().isEmpty() || proxyPortEdit->text().isEmpty()) {
+        showError("请先填写目标网址（大文件下载地址）和代理设置");
+        return;
+    }
+    
+    bool ok = false;
+    const int seconds = QInputDialog::getInt(this, "吞吐量测试",
+        "每组设置的测试时长（秒）:", 5, 1, 60, 1, &ok);
+    if (!ok) {
+        return;
+    }
+    
+    ThroughputTester::Config config;
+    config.proxy = proxyOptionsFromUI();
+    // 压缩会让线路字节与解码字节不一致，测吞吐时关闭
+    config.proxy.compression = false;
+    config.url = urlEdit->text();
+    config.bufferSizes = ThroughputTester::defaultBufferSizes();
+    config.receiveBufferSizes = ThroughputTester::defaultReceiveBufferSizes();
+    config.secondsPerRun = seconds;
+    
+    debugText->clear();
+    debugText->append(QString("开始吞吐量测试: %1 组设置，每组 %2 秒")
+                          .arg(config.bufferSizes.size() * config.receiveBufferSizes.size())
+                          .arg(seconds));
+    connectButton->setEnabled(false);
+    cancelThroughputAction->setEnabled(true);
+    throughputTester->start(config);
+}
+
+void MainWindow::runWebSocketBenchmark()
+{
+    if (webSocketBenchmark->isRunning() || tlsBenchmark->isRunning() || throughputTester->isRunning()) {
+        showError("已有测试正在进行中");
+        return;
+    }
+    
+    if (proxyHostEdit->text().isEmpty() || proxyPortEdit->text().isEmpty()) {
+        showError("请先填写代理设置");
+        return;
+    }
+    
+    bool ok = false;
+    const QString url = QInputDialog::getText(this, "WebSocket回显测试",
+        "回显服务地址 (ws:// 或 wss://):", QLineEdit::Normal, webSocketUrlFromUI(), &ok).trimmed();
+    if (!ok || url.isEmpty()) {
+        return;
+    }
+    if (!url.startsWith("ws://") && !url.startsWith("wss://")) {
+        showError("地址必须以 ws:// 或 wss:// 开头");
+        return;
+    }
+    
+    const int messages = QInputDialog::getInt(this, "WebSocket回显测试",
+        "每种负载大小的消息数:", 200, 10, 100000, 10, &ok);
+    if (!ok) {
+        return;
+    }
+    
+    WebSocketBenchmark::Config config;
+    config.proxy = proxyOptionsFromUI();
+    config.url = url;
+    config.payloadSizes = WebSocketBenchmark::defaultPayloadSizes();
+    config.messagesPerSize = messages;
+    
+    debugText->clear();
+    debugText->append(QString("开始WebSocket回显测试: %1，负载大小 %2 种，每种 %3 条消息")
+                          .arg(url)
+                          .arg(config.payloadSizes.size())
+                          .arg(messages));
+    connectButton->setEnabled(false);
+    cancelWebSocketAction->setEnabled(true);
+    webSocketBenchmark->start(config);
+}
+
+void MainWindow::runTlsBenchmark()
+{
+    if (tlsBenchmark->isRunning() || webSocketBenchmark->isRunning() || throughputTester->isRunning()) {
+        showError("已有测试正在进行中");
+        return;
+    }
+    
+    if (proxyHostEdit->text().isEmpty() || proxyPortEdit->text().isEmpty()) {
+        showError("请先填写代理设置");
+        return;
+    }
+    
+    bool ok = false;
+    const int handshakes = QInputDialog::getInt(this, "TLS握手开销测试",
+        "每种配置的握手次数:", 20, 5, 1000, 5, &ok);
+    if (!ok) {
+        return;
+    }
+    
+    TlsHandshakeBenchmark::Config config;
+    config.proxy = proxyOptionsFromUI();
+    config.cases = TlsHandshakeBenchmark::defaultMatrix();
+    config.handshakesPerCase = handshakes;
+    
+    debugText->clear();
+    debugText->append(QString("开始TLS握手开销测试: %1:%2，%3 种配置，每种 %4 次握手")
+                          .arg(config.proxy.host)
+                          .arg(config.proxy.port)
+                          .arg(config.cases.size())
+                          .arg(handshakes));
+    connectButton->setEnabled(false);
+    cancelTlsBenchmarkAction->setEnabled(true);
+    tlsBenchmark->start(config);
+}
+
+void MainWindow::showRttMonitor()
+{
+    if (proxyHostEdit->text().isEmpty() || proxyPortEdit->text().isEmpty()) {
+        showError("请先填写代理设置");
+        return;
+    }
+    
+    if (!rttMonitorDialog) {
+        rttMonitorDialog = new RttMonitorDialog(this);
+    }
+    rttMonitorDialog->setTarget(proxyOptionsFromUI(), webSocketUrlFromUI());
+    rttMonitorDialog->show();
+    rttMonitorDialog->raise();
+    rttMonitorDialog->activateWindow();
+}
+
+QString MainWindow::webSocketUrlFromUI() const
+{
+    // 默认把目标网址的http(s)换成ws(s)
+    QString url = urlEdit->text();
+    if (url.startsWith("https://")) {
+        url.replace(0, 5, "wss");
+    } else if (url.startsWith("http://")) {
+        url.replace(0, 4, "ws");
+    }
+    return url;
+}
+
+void MainWindow::runRangeDownload()
+{
+    if (rangeDownloader->isRunning()) {
+        showError("分段下载正在进行中");
+        return;
+    }
+    
+    if (urlEdit->text().isEmpty() || proxyHostEdit->text().isEmpty() || proxyPortEdit->text().isEmpty()) {
+        showError("请先填写目标网址（大文件下载地址）和代理设置");
+        return;
+    }
+    
+    const QString defaultName = QUrl(urlEdit->text()).fileName();
+    const QString outputPath = QFileDialog::getSaveFileName(this, "保存到", defaultName);
+    if (outputPath.isEmpty()) {
+        return;
+    }
+    
+    bool ok = false;
+    const int connections = QInputDialog::getInt(this, "分段并行下载",
+        "并行连接数:", 4, 1, 32, 1, &ok);
+    if (!ok) {
+        return;
+    }
+    
+    RangeDownloader::Config config;
+    config.proxies << proxyOptionsFromUI();
+    config.url = urlEdit->text();
+    config.outputPath = outputPath;
+    config.connections = connections;
+    
+    // 有多个档案时可以把分段分散到各档案的代理上，突破单个代理的带宽
+    const QSharedPointer<const AppSettings> settings = configManager->snapshot();
+    if (settings->profiles.size() > 1 && connections > 1
+        && QMessageBox::question(this, "分段并行下载",
+               QString("是否把分段分散到全部 %1 个配置档案的代理上？").arg(settings->profiles.size()))
+               == QMessageBox::Yes) {
+        for (const ProxyProfile &profile : settings->profiles) {
+            if (profile.name != settings->activeProfile) {
+                config.proxies << settings->proxyOptions(profile);
+            }
+        }
+    }
+    
+    debugText->clear();
+    debugText->append(QString("开始分段并行下载: %1 -> %2，%3 个连接，%4 个代理")
+                          .arg(config.url, outputPath)
+                          .arg(connections)
+                          .arg(config.proxies.size()));
+    connectButton->setEnabled(false);
+    cancelRangeDownloadAction->setEnabled(true);
+    rangeDownloader->start(config);
+}
+
+void MainWindow::runBatch()
+{
+    if (proxyClient->isBatchRunning()) {
+        showError("批量请求正在进行中");
+        return;
+    }
+    
+    if (proxyHostEdit->text().isEmpty() || proxyPortEdit->text().isEmpty()) {
+        showError("请先填写代理设置");
+        return;
+    }
+    
+    // URL列表文件：每行一个URL，空行和#开头的行忽略
+    const QString fileName = QFileDialog::getOpenFileName(this, "选择URL列表",
+        QString(), "文本文件 (*.txt);;所有文件 (*.*)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        showError("无法读取文件: " + file.errorString());
+        return;
+    }
+    QStringList urls;
+    while (!file.atEnd()) {
+        const QString line = QString::fromUtf8(file.readLine()).trimmed();
+        if (!line.isEmpty() && !line.startsWith("#")) {
+            urls << line;
+        }
+    }
+    if (urls.isEmpty()) {
+        showError("文件中没有URL");
+        return;
+    }
+    
+    applyUIToConfig();
+    proxyClient->setSettings(configManager->snapshot());
+    debugText->clear();
+    batchAction->setEnabled(false);
+    cancelBatchAction->setEnabled(true);
+    proxyClient->runBatch(urls);
+}
+
 void MainWindow::showError(const QString &message)
 {
     QMessageBox::warning(this, "错误", message);
@@ -314,5 +976,5 @@ void MainWindow::saveConfigButtonClicked()
 {
     saveConfigFromUI();
     QMessageBox::information(this, "保存配置", 
-        QString("配置已保存到:\n%1").arg(QApplication::applicationDirPath() + "/config.ini"));
+        QString("配置已保存到:\n%1").arg(configManager->configPath()));
 } 
\ No newline at end of file
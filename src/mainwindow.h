@@ -3,6 +3,8 @@
 
 #include <QMainWindow>
 #include <QLineEdit>
+#include <QCheckBox>
+#include <QComboBox>
 #include <QPushButton>
 #include <QTextEdit>
 #include <QLabel>
@@ -16,7 +18,15 @@
 #include <QMenuBar>
 #include <QMenu>
 #include <QAction>
+#include <QSplitter>
+#include <QTimer>
 #include "proxyclient.h"
+#include "throughputtester.h"
+#include "websocketbenchmark.h"
+#include "tlsbenchmark.h"
+#include "rangedownloader.h"
+#include "rttmonitordialog.h"
+#include "responseview.h"
 #include "configmanager.h"
 
 class MainWindow : public QMainWindow
@@ -32,17 +42,39 @@ protected:
 
 private slots:
     void browseCertificate();
+    void browseUploadFile();
+    void onMethodChanged(int index);
     void connectToProxy();
     void onConnectionStarted();
     void onConnectionFinished(bool success, const QString &result);
     void onNetworkError(const QString &errorMessage);
     void onDebugMessage(const QString &message);
+    void updateTransferProgress();
+    void onResponseReceived(const QSharedPointer<ResponseData> &response);
+    
+    // 配置档案
+    void switchProfile(const QString &name);
+    void addProfile();
+    void removeProfile();
+    void onSettingsReloaded(const ConfigChanges &changes);
     
     // 配置相关槽函数
     void saveSettings();
     void loadSettings();
     void resetSettings();
     void about();
+    void runThroughputTest();
+    void runWebSocketBenchmark();
+    void runTlsBenchmark();
+    void showRttMonitor();
+    void runRangeDownload();
+    void runBatch();
+    void clearPinnedPublicKey();
+    void setTransferTracing(bool enabled);
+    void exportTransferTrace();
+    void setSpanProfiling(bool enabled);
+    void exportSpanProfile();
+    void onProxyPublicKeyCaptured(const QString &profile, const QString &pin);
     void saveConfigButtonClicked();
 
 private:
@@ -51,7 +83,10 @@ private:
     void setupConnections();
     void showError(const QString &message);
     void loadConfigToUI();
+    void applyUIToConfig();
     void saveConfigFromUI();
+    ProxyOptions proxyOptionsFromUI();
+    QString webSocketUrlFromUI() const;
 
     // UI组件
     QWidget *centralWidget;
@@ -59,14 +94,23 @@ private:
     
     // 目标网址
     QGroupBox *targetGroup;
+    QComboBox *methodCombo;
     QLineEdit *urlEdit;
+    // POST/PUT的请求体文件，"-"表示标准输入
+    QLineEdit *uploadPathEdit;
+    QPushButton *uploadBrowseButton;
     
     // 代理设置
     QGroupBox *proxyGroup;
+    QComboBox *profileCombo;
+    QPushButton *addProfileButton;
+    QPushButton *removeProfileButton;
     QLineEdit *proxyHostEdit;
     QLineEdit *proxyPortEdit;
     QLineEdit *usernameEdit;
     QLineEdit *passwordEdit;
+    QCheckBox *compressionCheck;
+    QCheckBox *cacheCheck;
     
     // 证书设置
     QGroupBox *certificateGroup;
@@ -78,18 +122,48 @@ private:
     QPushButton *connectButton;
     QPushButton *saveConfigButton;
     QProgressBar *progressBar;
+    QLabel *speedLabel;
+    // 按固定频率采样传输进度，回调再频繁也不会堆积界面事件
+    QTimer *progressTimer;
     
     // 调试信息显示
     QTextEdit *debugText;
     
+    // 响应内容显示
+    QComboBox *responseModeCombo;
+    QLabel *responseSizeLabel;
+    ResponseView *responseView;
+    
     // 菜单
     QMenu *fileMenu;
     QMenu *settingsMenu;
+    QMenu *toolsMenu;
+    QAction *batchAction;
+    QAction *cancelBatchAction;
+    QAction *cancelThroughputAction;
+    QAction *cancelWebSocketAction;
+    QAction *cancelTlsBenchmarkAction;
+    QAction *cancelRangeDownloadAction;
     QMenu *helpMenu;
     
     // 代理客户端
     ProxyClient *proxyClient;
     
+    // 吞吐量测试
+    ThroughputTester *throughputTester;
+    
+    // WebSocket回显测试
+    WebSocketBenchmark *webSocketBenchmark;
+    
+    // TLS握手开销测试
+    TlsHandshakeBenchmark *tlsBenchmark;
+    
+    // 分段并行下载
+    RangeDownloader *rangeDownloader;
+    
+    // 隧道RTT监视窗口，首次打开时创建
+    RttMonitorDialog *rttMonitorDialog;
+    
     // 配置管理器
     ConfigManager *configManager;
 };
@@ -0,0 +1,182 @@
+#include "memorycache.h"
+#include <QDateTime>
+#include <QStringList>
+
+namespace {
+// 等待其他请求时每隔这么久检查一次是否已被取消
+constexpr unsigned long kWaitSliceMs = 100;
+// 链表节点、哈希桶等簿记开销的粗略估计，计入条目大小
+constexpr qint64 kNodeOverhead = 128;
+}
+
+MemoryCache::MemoryCache(qint64 maxBytes, qint64 ttlMs, bool coalesce)
+    : maxBytes_(maxBytes)
+    , ttlMs_(ttlMs)
+    , coalesce_(coalesce)
+{
+}
+
+void MemoryCache::configure(qint64 maxBytes, qint64 ttlMs, bool coalesce)
+{
+    maxBytes_ = maxBytes;
+    ttlMs_ = ttlMs;
+    coalesce_ = coalesce;
+    for (Shard &shard : shards_) {
+        QMutexLocker locker(&shard.mutex);
+        trim(shard, shardBudget());
+    }
+}
+
+QByteArray MemoryCache::keyFor(const QByteArray &method, const QString &url)
+{
+    return method + " " + url.toUtf8();
+}
+
+qint64 MemoryCache::lifetimeFor(const ResponseCache::ResponseInfo &info, qint64 requestTimeMs,
+                                qint64 responseTimeMs) const
+{
+    // 条目按URL保存，不区分请求头，任何Vary都无法正确匹配
+    if (!info.vary.trimmed().isEmpty()) {
+        return 0;
+    }
+    // 合并请求时条目会交给其他请求，按共享缓存处理private
+    for (const QString &part : info.cacheControl.split(',', Qt::SkipEmptyParts)) {
+        const QString directive = part.trimmed().toLower();
+        if (directive == "private" || directive.startsWith("private=")) {
+            return 0;
+        }
+    }
+    if (info.cacheControl.isEmpty() && info.pragma.contains("no-cache", Qt::CaseInsensitive)) {
+        return 0;
+    }
+
+    const ResponseCache::Freshness freshness = ResponseCache::computeFreshness(info, requestTimeMs, responseTimeMs);
+    if (!freshness.storable || (freshness.flags & ResponseCache::NoCache)) {
+        return 0;
+    }
+    const qint64 remainingMs = (freshness.lifetimeSeconds - freshness.initialAgeSeconds) * 1000;
+    return qMax<qint64>(0, qMin<qint64>(ttlMs_, remainingMs));
+}
+
+MemoryCache::Shard &MemoryCache::shardFor(const QByteArray &key)
+{
+    return shards_[qHash(key) % kShardCount];
+}
+
+void MemoryCache::removeNode(Shard &shard, std::list<Node>::iterator node)
+{
+    shard.bytes -= node->cost;
+    shard.index.remove(node->key);
+    shard.lru.erase(node);
+}
+
+void MemoryCache::trim(Shard &shard, qint64 budget)
+{
+    while (!shard.lru.empty() && shard.bytes > budget) {
+        removeNode(shard, std::prev(shard.lru.end()));
+        ++evictions_;
+    }
+}
+
+MemoryCache::Claim MemoryCache::claim(const QByteArray &key, Entry *entry, const std::function<bool()> &cancelled)
+{
+    Shard &shard = shardFor(key);
+    QMutexLocker locker(&shard.mutex);
+    bool waited = false;
+    for (;;) {
+        const auto found = shard.index.constFind(key);
+        if (found != shard.index.constEnd()) {
+            const std::list<Node>::iterator node = found.value();
+            if (node->entry.expiresAtMs > QDateTime::currentMSecsSinceEpoch()) {
+                shard.lru.splice(shard.lru.begin(), shard.lru, node);
+                // QByteArray隐式共享，这里只增加引用计数，不复制响应体
+                *entry = node->entry;
+                ++(waited ? coalesced_ : hits_);
+                return ClaimHit;
+            }
+            removeNode(shard, node);
+        }
+        if (!coalesce_ || !shard.inflight.contains(key)) {
+            break;
+        }
+        if (cancelled && cancelled()) {
+            return ClaimBypass;
+        }
+        waited = true;
+        shard.settled.wait(&shard.mutex, kWaitSliceMs);
+    }
+
+    ++misses_;
+    // 前一个请求的结果不可缓存时，等待者各自访问网络，不再排队逐个当Leader
+    if (waited) {
+        return ClaimBypass;
+    }
+    shard.inflight.insert(key);
+    return ClaimLeader;
+}
+
+void MemoryCache::publish(const QByteArray &key, const Entry *entry)
+{
+    Shard &shard = shardFor(key);
+    QMutexLocker locker(&shard.mutex);
+    shard.inflight.remove(key);
+
+    const qint64 budget = shardBudget();
+    if (entry && entry->expiresAtMs > QDateTime::currentMSecsSinceEpoch()) {
+        const qint64 cost = key.size() + entry->headers.size() + entry->body.size() + kNodeOverhead;
+        // 单个条目最多占分片预算的四分之一，避免一个大响应冲掉整个分片
+        if (cost <= budget / 4) {
+            const auto found = shard.index.constFind(key);
+            if (found != shard.index.constEnd()) {
+                removeNode(shard, found.value());
+            }
+            shard.lru.push_front(Node { key, *entry, cost });
+            shard.index.insert(key, shard.lru.begin());
+            shard.bytes += cost;
+            trim(shard, budget);
+        }
+    }
+    shard.settled.wakeAll();
+}
+
+MemoryCache::Stats MemoryCache::stats() const
+{
+    Stats s;
+    s.hits = hits_;
+    s.coalesced = coalesced_;
+    s.misses = misses_;
+    s.evictions = evictions_;
+    for (const Shard &shard : shards_) {
+        QMutexLocker locker(&shard.mutex);
+        s.entries += shard.index.size();
+        s.bytes += shard.bytes;
+    }
+    return s;
+}
+
+QString MemoryCache::describeStats() const
+{
+    const Stats s = stats();
+    return QString("内存缓存: 命中 %1, 合并 %2, 未命中 %3, 淘汰 %4, 条目 %5, 占用 %6 KB")
+        .arg(s.hits)
+        .arg(s.coalesced)
+        .arg(s.misses)
+        .arg(s.evictions)
+        .arg(s.entries)
+        .arg(s.bytes / 1024);
+}
+
+QString MemoryCache::outcomeName(Outcome outcome)
+{
+    switch (outcome) {
+    case Hit:
+        return "命中";
+    case Coalesced:
+        return "与同时进行的相同请求合并";
+    case Miss:
+        return "未命中";
+    case NotUsed:
+        break;
+    }
+    return "未使用";
+}
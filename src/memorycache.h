@@ -0,0 +1,106 @@
+#ifndef MEMORYCACHE_H
+#define MEMORYCACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QWaitCondition>
+#include <atomic>
+#include <functional>
+#include <list>
+#include "responsecache.h"
+
+// 最近响应的内存LRU缓存，按“方法 URL”为键，保存响应头和响应体，用于几秒内重复请求同一URL的场景。
+// 按键哈希分成若干分片，每个分片有自己的锁、LRU链表和字节预算，并发的工作线程只在同一分片上竞争。
+// 开启合并时，同一键的并发请求只有第一个真正访问网络，其余等待它的结果
+class MemoryCache
+{
+public:
+    enum Outcome { NotUsed, Hit, Coalesced, Miss };
+
+    struct Entry
+    {
+        long       status { 0 };
+        // 最终响应的原始头部块，与TransferResult::headers格式相同
+        QByteArray headers;
+        QString    contentEncoding;
+        QByteArray body;
+        qint64     expiresAtMs { 0 };
+    };
+
+    // Hit：entry已填好；Leader：调用者负责访问网络，完成后必须调用publish；
+    // Bypass：等待的请求没有留下可用结果（或等待被取消），调用者自行访问网络，不调用publish
+    enum Claim { ClaimHit, ClaimLeader, ClaimBypass };
+
+    struct Stats
+    {
+        quint64 hits { 0 };
+        quint64 coalesced { 0 };
+        quint64 misses { 0 };
+        quint64 evictions { 0 };
+        int     entries { 0 };
+        qint64  bytes { 0 };
+    };
+
+    MemoryCache(qint64 maxBytes, qint64 ttlMs, bool coalesce);
+    MemoryCache(const MemoryCache &) = delete;
+    MemoryCache &operator=(const MemoryCache &) = delete;
+
+    // 可在使用中调整，缩小预算时立即淘汰超出的条目
+    void configure(qint64 maxBytes, qint64 ttlMs, bool coalesce);
+    qint64 ttlMs() const { return ttlMs_; }
+
+    static QByteArray keyFor(const QByteArray &method, const QString &url);
+    // 按与磁盘缓存相同的RFC 9111规则计算剩余新鲜时间，最多保存默认时长；
+    // 不可缓存、需要重新验证、带Vary或private的响应返回0
+    qint64 lifetimeFor(const ResponseCache::ResponseInfo &info, qint64 requestTimeMs, qint64 responseTimeMs) const;
+
+    // cancelled在等待其他请求期间周期性调用，返回true时放弃等待
+    Claim claim(const QByteArray &key, Entry *entry, const std::function<bool()> &cancelled);
+    // 领取了Leader的请求结束时调用；entry为空表示结果不可缓存，只唤醒等待者
+    void publish(const QByteArray &key, const Entry *entry);
+
+    Stats stats() const;
+    QString describeStats() const;
+    static QString outcomeName(Outcome outcome);
+
+private:
+    struct Node
+    {
+        QByteArray key;
+        Entry entry;
+        qint64 cost { 0 };
+    };
+
+    // 链表头部是最近使用的条目
+    struct Shard
+    {
+        mutable QMutex mutex;
+        QWaitCondition settled;
+        std::list<Node> lru;
+        QHash<QByteArray, std::list<Node>::iterator> index;
+        QSet<QByteArray> inflight;
+        qint64 bytes { 0 };
+    };
+
+    static constexpr int kShardCount = 16;
+
+    Shard &shardFor(const QByteArray &key);
+    void removeNode(Shard &shard, std::list<Node>::iterator node);
+    void trim(Shard &shard, qint64 budget);
+    qint64 shardBudget() const { return maxBytes_ / kShardCount; }
+
+    Shard shards_[kShardCount];
+    std::atomic<qint64> maxBytes_;
+    std::atomic<qint64> ttlMs_;
+    std::atomic<bool> coalesce_;
+
+    std::atomic<quint64> hits_ { 0 };
+    std::atomic<quint64> coalesced_ { 0 };
+    std::atomic<quint64> misses_ { 0 };
+    std::atomic<quint64> evictions_ { 0 };
+};
+
+#endif // MEMORYCACHE_H
@@ -1,17 +1,25 @@
 #include "proxyclient.h"
+#include "spanprofiler.h"
 #include <QDateTime>
 #include <QUrl>
 #include <QDebug>
-#include <QMetaObject>
+#include <QStandardPaths>
+
+namespace {
+// 公钥捕获失败后第一次重试的等待时间，之后每次翻倍，最长1小时
+constexpr qint64 kPinCaptureRetryMs = 30'000;
+constexpr qint64 kMaxPinCaptureRetryMs = 3600'000;
+}
 
 ProxyClient::ProxyClient(QObject *parent)
     : QObject(parent),
-      timer_(new QTimer(this))
+      scheduler_(new TransferScheduler(this))
 {
-    timer_->setSingleShot(true);
-    connect(timer_, &QTimer::timeout, this, [this]() {
-        if (connecting_) {
-            finishWithError(tr("连接超时"));
+    connect(scheduler_, &TransferScheduler::transferFinished, this, &ProxyClient::onScheduledTransferFinished);
+    // 只有交互请求经submit(context)提交，调试输出由调度器合并后在界面线程送来
+    connect(scheduler_, &TransferScheduler::transferDebug, this, [this](quint64 id, const QString &line) {
+        if (id == transferId_) {
+            appendDebug(line);
         }
     });
 }
@@ -19,25 +27,135 @@ ProxyClient::ProxyClient(QObject *parent)
 ProxyClient::~ProxyClient()
 {
     cancelRequest();
+    cancelBatch();
+    // 预热等剩余传输由调度器析构时中止并等待
+}
+
+void ProxyClient::setSettings(const QSharedPointer<const AppSettings> &settings)
+{
+    ScopedSpan span("ProxyClient::setSettings");
+    settings_ = settings;
+
+    TransferScheduler::Limits limits;
+    limits.maxPerHost = settings_->hostConcurrency;
+    limits.maxPerProxy = settings_->proxyConcurrency;
+    limits.hostRate = settings_->hostRequestRate;
+    limits.proxyRate = settings_->proxyRequestRate;
+    limits.reservedInteractive = settings_->interactiveReserved;
+    scheduler_->setLimits(limits);
+
+    // 关闭缓存只是不再使用，已缓存的文件保留在磁盘上，下次启用时继续有效
+    const qint64 cacheBytes = qint64(settings_->cacheMaxSizeMb) * 1024 * 1024;
+    if (!settings_->cacheEnabled) {
+        cache_.reset();
+    } else if (cache_) {
+        cache_->setMaxBytes(cacheBytes);
+    } else {
+        const QString directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/http";
+        cache_.reset(new ResponseCache(directory, cacheBytes));
+        if (!cache_->isOpen()) {
+            appendDebug(tr("无法打开响应缓存目录 %1，缓存已禁用").arg(directory));
+            cache_.reset();
+        }
+    }
+    const qint64 memoryBytes = qint64(settings_->memoryCacheMb) * 1024 * 1024;
+    const qint64 memoryTtlMs = qint64(settings_->memoryCacheTtlSeconds) * 1000;
+    if (!settings_->cacheEnabled || memoryBytes == 0) {
+        memoryCache_.reset();
+    } else if (memoryCache_) {
+        memoryCache_->configure(memoryBytes, memoryTtlMs, settings_->coalesceRequests);
+    } else {
+        memoryCache_.reset(new MemoryCache(memoryBytes, memoryTtlMs, settings_->coalesceRequests));
+    }
+
+    // 已删除档案的连接池不再保留
+    const QStringList names = settings_->profileNames();
+    for (const QString &name : pools_.keys()) {
+        if (!names.contains(name)) {
+            pools_.remove(name);
+        }
+    }
+}
+
+void ProxyClient::reconfigure(const QSharedPointer<const AppSettings> &settings, const ConfigChanges &changes)
+{
+    ScopedSpan span("ProxyClient::reconfigure");
+    // 删除的档案在setSettings中移除
+    setSettings(settings);
+
+    for (const QString &name : changes.addedProfiles) {
+        const ProxyProfile *profile = settings_->profile(name);
+        if (profile) {
+            pools_.insert(name, QSharedPointer<ConnectionPool>(new ConnectionPool(settings_->proxyOptions(*profile))));
+        }
+    }
+
+    // CA换了之后，之前的捕获失败不再有参考意义
+    for (const QString &name : changes.caChangedProfiles) {
+        pinCaptureBackoff_.remove(name);
+    }
+
+    // 端点或CA变化只影响该档案：换上新池后，旧池中的连接和TLS会话随最后一个使用者一起释放
+    QStringList rebuilt;
+    for (const QString &name : changes.endpointChangedProfiles + changes.caChangedProfiles) {
+        const ProxyProfile *profile = settings_->profile(name);
+        if (!profile || rebuilt.contains(name) || !pools_.contains(name)) {
+            continue;
+        }
+        pools_.insert(name, QSharedPointer<ConnectionPool>(new ConnectionPool(settings_->proxyOptions(*profile))));
+        rebuilt << name;
+    }
+
+    appendDebug(tr("配置已重新加载: %1").arg(changes.describe()));
+    if (!rebuilt.isEmpty()) {
+        appendDebug(tr("已重建连接池: %1").arg(rebuilt.join(", ")));
+    }
 }
 
-void ProxyClient::setProxySettings(const QString &host, int port,
-                                   const QString &username,
-                                   const QString &password)
+QSharedPointer<ConnectionPool> ProxyClient::poolFor(const ProxyProfile &profile)
 {
-    proxyHost_ = host;
-    proxyPort_ = port;
-    proxyUser_ = username;
-    proxyPass_ = password;
+    const ProxyOptions options = settings_->proxyOptions(profile);
+    QSharedPointer<ConnectionPool> pool = pools_.value(profile.name);
+    if (!pool || !pool->matches(options)) {
+        // 旧池仍被进行中的传输持有时，会在它们结束后自动释放
+        pool.reset(new ConnectionPool(options));
+        pools_.insert(profile.name, pool);
+    }
+    return pool;
 }
 
-void ProxyClient::setSslCertificate(const QString &certificatePath)
+void ProxyClient::prewarm(const QString &url)
 {
-    caPath_ = certificatePath;
+    if (!settings_ || connecting_ || prewarmId_ != 0) {
+        return;
+    }
+    const ProxyProfile &profile = settings_->active();
+    if (profile.proxyHost.isEmpty() || profile.proxyPort <= 0) {
+        return;
+    }
+    const QUrl u(url);
+    if (!u.isValid() || u.host().isEmpty()) {
+        return;
+    }
+
+    QSharedPointer<ConnectionPool> pool = poolFor(profile);
+    if (pool->isWarm()) {
+        return;
+    }
+
+    TransferRequest request;
+    request.proxy = settings_->proxyOptions(profile);
+    request.url = url;
+    request.headOnly = true;
+    request.pool = pool;
+
+    appendDebug(tr("预热档案 %1 的连接池").arg(profile.name));
+    prewarmId_ = scheduler_->submit(request, TransferScheduler::Background);
 }
 
 void ProxyClient::appendDebug(const QString &msg)
 {
+    ScopedSpan span("ProxyClient::appendDebug");
     const QString stamped = QString("[%1] %2")
                                 .arg(QDateTime::currentDateTime().toString("hh:mm:ss.zzz"), msg);
     debugLines_ << stamped;
@@ -49,18 +167,18 @@ void ProxyClient::finishWithError(const QString &msg)
 {
     appendDebug("ERROR: " + msg);
     connecting_ = false;
-    timer_->stop();
+    current_.reset();
     emit connectionFinished(false, msg);
 }
 
-void ProxyClient::connectToUrl(const QString &url)
+void ProxyClient::connectToUrl(const QString &url, const QByteArray &method, const QString &uploadPath)
 {
     if (connecting_) {
         emit networkError(tr("正在连接中，请等待当前请求完成"));
         return;
     }
 
-    if (proxyHost_.isEmpty() || proxyPort_ <= 0) {
+    if (!settings_ || settings_->active().proxyHost.isEmpty() || settings_->active().proxyPort <= 0) {
         emit networkError(tr("请填写有效的代理地址和端口"));
         return;
     }
@@ -71,144 +189,319 @@ void ProxyClient::connectToUrl(const QString &url)
         return;
     }
 
-    targetUrl_ = url;
+    TransferRequest request;
+    request.pool = poolFor(settings_->active());
+    request.proxy = settings_->proxyOptions();
+    request.url = url;
+    request.method = method;
+    request.uploadPath = uploadPath;
+    request.uploadBufferSize = settings_->uploadBufferSize;
+    request.cache = cache_;
+    request.memoryCache = memoryCache_;
+    requestProfile_ = settings_->activeProfile;
 
     connecting_ = true;
-    headerBuffer_.clear();
-    bodyBuffer_.clear();
     debugLines_.clear();
+    QSharedPointer<TransferContext> context(new TransferContext(request));
+    current_ = context;
 
     emit connectionStarted();
-    appendDebug(tr("开始连接流程 -> %1 via %2:%3").arg(targetUrl_).arg(proxyHost_).arg(proxyPort_));
+    appendDebug(tr("开始连接流程 -> %1 via %2:%3 (档案 %4%5)")
+                    .arg(url)
+                    .arg(request.proxy.host)
+                    .arg(request.proxy.port)
+                    .arg(settings_->activeProfile,
+                         request.pool->isWarm() ? tr(", 复用连接池") : QString()));
 
-    timer_->start(30'000); // 30s timeout
-
-    worker_ = QThread::create([this]() { performRequest(); });
-    connect(worker_, &QThread::finished, worker_, &QObject::deleteLater);
-    worker_->start();
+    // 超时由libcurl按阶段判断（连接超时和传输停滞），长时间的上传下载不会被打断
+    // 交互请求优先出队并使用预留连接，不会排在批量请求之后
+    transferId_ = scheduler_->submit(context, TransferScheduler::Interactive);
 }
 
 void ProxyClient::cancelRequest()
 {
+    if (connecting_) {
+        scheduler_->cancel(transferId_);
+    }
+    connecting_ = false;
+    current_.reset();
+}
+
+void ProxyClient::handleResult(quint64 transferId, const QSharedPointer<TransferResult> &result)
+{
+    ScopedSpan span("ProxyClient::handleResult");
+    // 已被取消的请求，结果直接丢弃
+    if (transferId != transferId_ || !connecting_) {
+        return;
+    }
+
     connecting_ = false;
-    timer_->stop();
-    if (worker_) {
-        worker_->quit();
-        worker_->wait();
-        worker_ = nullptr;
+    current_.reset();
+
+    const CURLcode res = result->curlCode;
+    if (res == CURLE_FAILED_INIT) {
+        finishWithError(tr("初始化curl失败"));
+        return;
+    }
+    if (res != CURLE_OK) {
+        QString errorMsg = QString::fromUtf8(curl_easy_strerror(res));
+        appendDebug("CURL错误代码: " + QString::number(res));
+        appendDebug("CURL错误描述: " + errorMsg);
+        
+        // 公钥固定不一致：给出期望值和代理实际出示的值，而不是笼统的证书建议
+        if (res == CURLE_SSL_PINNEDPUBKEYNOTMATCH) {
+            const ProxyProfile *profile = settings_->profile(requestProfile_);
+            errorMsg = tr("代理证书公钥与档案 %1 中固定的公钥不一致").arg(requestProfile_);
+            errorMsg += tr("\n\n已固定: %1").arg(profile ? profile->pinnedPublicKey : QString());
+            errorMsg += tr("\n实际出示: %1").arg(result->proxyPublicKey.isEmpty()
+                                                   ? tr("无法获取（%1）").arg(result->proxyPublicKeyError)
+                                                   : result->proxyPublicKey);
+            errorMsg += tr("\n\n如果代理证书是有意更换的，请用“工具 → 清除代理公钥固定”或重新选择CA证书，"
+                           "下次连接成功后会重新固定；否则连接可能被中间人拦截，不要继续使用。");
+        }
+
+        // 针对SSL错误的特殊处理
+        if (res == CURLE_SSL_CONNECT_ERROR || res == CURLE_SSL_CERTPROBLEM || 
+            res == CURLE_PEER_FAILED_VERIFICATION) {
+            errorMsg += "\n\n可能的解决方案:\n";
+            errorMsg += "1. 检查CA证书文件是否正确\n";
+            errorMsg += "2. 确认证书文件格式为PEM格式\n";
+            errorMsg += "3. 验证证书是否与代理服务器匹配\n";
+            errorMsg += "4. 尝试使用不同的SSL版本";
+        }
+        
+        finishWithError(errorMsg);
+        return;
+    }
+
+    // 响应体交给查看器：小响应合并为一块内存，大响应直接映射转存文件，不再整体转成QString；
+    // 命中缓存或304重新验证时直接映射缓存文件
+    const bool fromCache = result->cachedBody != nullptr;
+    const bool spilled = result->body.isSpilled();
+    const QSharedPointer<ResponseData> body = fromCache ? ResponseData::fromFile(result->cachedBody)
+                                                        : ResponseData::fromBody(std::move(result->body));
+    if (!body->errorString().isEmpty()) {
+        appendDebug("响应文件映射失败: " + body->errorString());
+    } else if (spilled) {
+        appendDebug(tr("响应体 %1 字节已转存到临时文件").arg(body->size()));
     }
+
+    const long response = result->httpStatus;
+    const QString transferStats = formatTransferStats(result->wireBytes, body->size(), result->contentEncoding);
+    appendDebug(tr("HTTP 状态 %1").arg(response));
+    appendDebug(transferStats);
+    if (result->memoryOutcome != MemoryCache::NotUsed && memoryCache_) {
+        appendDebug(tr("本次请求内存缓存%1; %2")
+                        .arg(MemoryCache::outcomeName(result->memoryOutcome), memoryCache_->describeStats()));
+    }
+    if (result->cacheOutcome != ResponseCache::NotCached && cache_) {
+        appendDebug(tr("本次请求缓存%1; %2")
+                        .arg(ResponseCache::outcomeName(result->cacheOutcome), cache_->describeStats()));
+    }
+    const QString uploadStats = formatUploadStats(*result);
+    if (!uploadStats.isEmpty()) {
+        appendDebug(uploadStats);
+    }
+    const BufferPool::Stats poolStats = BufferPool::instance().stats();
+    appendDebug(QString("接收缓冲池: 累计新分配 %1 次, 复用 %2 次")
+                    .arg(poolStats.allocations)
+                    .arg(poolStats.reuses));
+    appendDebug(scheduler_->describeStats());
+    emit responseReceived(body);
+    // 经CA验证连上代理之后才捕获公钥，握手在后台进行，不影响本次结果
+    capturePublicKey(requestProfile_);
+
+    if (response < 200 || response >= 300) {
+        finishWithError(tr("HTTP 状态码 %1").arg(response));
+        return;
+    }
+
+    // 状态和统计都已写入调试输出，界面只需要知道请求已成功结束
+    emit connectionFinished(true, QString());
 }
 
-size_t ProxyClient::headerCallback(char *buffer, size_t size, size_t nitems, void *userdata)
+void ProxyClient::runBatch(const QStringList &urls)
 {
-    ProxyClient *self = static_cast<ProxyClient *>(userdata);
-    QByteArray data(buffer, size * nitems);
-    self->headerBuffer_.append(data);
-    QMetaObject::invokeMethod(self, [self, data]() { self->appendDebug(QString::fromUtf8(data).trimmed()); }, Qt::QueuedConnection);
-    return size * nitems;
+    if (!settings_ || urls.isEmpty() || isBatchRunning()) {
+        return;
+    }
+
+    batch_ = BatchStats();
+    batch_.total = urls.size();
+    batch_.timer.start();
+    const TransferScheduler::Limits &limits = scheduler_->limits();
+    appendDebug(tr("批量请求: %1 个URL, 每主机并发 %2, 每代理并发 %3, 每主机限速 %4")
+                    .arg(urls.size())
+                    .arg(limits.maxPerHost)
+                    .arg(limits.maxPerProxy)
+                    .arg(limits.hostRate > 0 ? tr("%1 请求/秒").arg(limits.hostRate) : tr("不限")));
+
+    TransferRequest request;
+    request.proxy = settings_->proxyOptions();
+    // 批量任务在调度器的多个线程上并发运行，用单独的连接池：每个任务独占自己的easy句柄，
+    // 共享句柄只共享TLS会话和DNS缓存，不与交互请求和预热的句柄争用
+    request.pool.reset(new ConnectionPool(request.proxy));
+    request.cache = cache_;
+    request.memoryCache = memoryCache_;
+    for (const QString &url : urls) {
+        request.url = url;
+        batchIds_.insert(scheduler_->submit(request, TransferScheduler::Normal));
+    }
 }
 
-size_t ProxyClient::writeCallback(char *ptr, size_t size, size_t nmemb, void *userdata)
+void ProxyClient::cancelBatch()
 {
-    ProxyClient *self = static_cast<ProxyClient *>(userdata);
-    self->bodyBuffer_.append(ptr, size * nmemb);
-    return size * nmemb;
+    if (!isBatchRunning()) {
+        return;
+    }
+    // 只取消本批任务，进行中的交互请求和预热不受影响
+    scheduler_->cancel(batchIds_);
+    finishBatch(true);
 }
 
-void ProxyClient::performRequest()
+void ProxyClient::onScheduledTransferFinished(quint64 id, const QString &host,
+                                              const QSharedPointer<TransferResult> &result)
 {
-    CURL *curl = curl_easy_init();
-    if (!curl) {
-        QMetaObject::invokeMethod(this, [this]() { finishWithError(tr("初始化curl失败")); }, Qt::QueuedConnection);
+    ScopedSpan span("ProxyClient::onScheduledTransferFinished");
+    if (id == prewarmId_) {
+        prewarmId_ = 0;
+        // 预热的句柄归还连接池后，隧道、TLS会话和解析好的CA证书库都留给下一个请求
+        if (result->curlCode == CURLE_OK) {
+            appendDebug(tr("连接池预热完成"));
+        } else {
+            appendDebug(tr("连接池预热失败: %1").arg(QString::fromUtf8(curl_easy_strerror(result->curlCode))));
+        }
+        return;
+    }
+    if (id == transferId_) {
+        handleResult(id, result);
+        return;
+    }
+    if (pinCaptureIds_.contains(id)) {
+        onPublicKeyCaptureFinished(pinCaptureIds_.take(id), *result);
+        return;
+    }
+    if (!batchIds_.remove(id)) {
         return;
     }
 
-    curl_easy_setopt(curl, CURLOPT_URL, targetUrl_.toUtf8().constData());
-    curl_easy_setopt(curl, CURLOPT_PROXY, proxyHost_.toUtf8().constData());
-    curl_easy_setopt(curl, CURLOPT_PROXYPORT, proxyPort_);
-    curl_easy_setopt(curl, CURLOPT_PROXYTYPE, CURLPROXY_HTTPS);
-    curl_easy_setopt(curl, CURLOPT_HTTPPROXYTUNNEL, 1L);
+    ++batch_.finished;
+    ++batch_.perHost[host];
+    batch_.wireBytes += result->wireBytes;
+    if (result->curlCode == CURLE_OK && result->httpStatus >= 200 && result->httpStatus < 400) {
+        ++batch_.succeeded;
+    }
+    // 批量请求只统计，不保留响应体
+    result->body.release();
 
-    if (!proxyUser_.isEmpty()) {
-        QByteArray auth = QString("%1:%2").arg(proxyUser_, proxyPass_).toUtf8();
-        curl_easy_setopt(curl, CURLOPT_PROXYUSERPWD, auth.constData());
+    if (batch_.finished % 100 == 0 && batch_.finished < batch_.total) {
+        appendDebug(tr("批量请求进度: %1/%2").arg(batch_.finished).arg(batch_.total));
+    }
+    if (batch_.finished == batch_.total) {
+        finishBatch(false);
     }
+}
 
-    if (!caPath_.isEmpty()) {
-        curl_easy_setopt(curl, CURLOPT_CAINFO, caPath_.toUtf8().constData());
-        curl_easy_setopt(curl, CURLOPT_PROXY_CAINFO, caPath_.toUtf8().constData());
-        appendDebug("使用CA证书: " + caPath_);
-        
-        // SSL配置 - 针对自签名证书优化
-        // 对代理服务器启用SSL验证
-        curl_easy_setopt(curl, CURLOPT_PROXY_SSL_VERIFYPEER, 1L);
-        curl_easy_setopt(curl, CURLOPT_PROXY_SSL_VERIFYHOST, 2L);
-        
-        // 对目标服务器禁用SSL验证（因为目标服务器通常是受信任的）
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
-        appendDebug("代理服务器SSL验证已启用，目标服务器SSL验证已禁用");
-        
-        // 添加SSL选项以处理自签名证书的常见问题
-        curl_easy_setopt(curl, CURLOPT_SSL_OPTIONS, CURLSSLOPT_ALLOW_BEAST | CURLSSLOPT_NO_REVOKE | CURLSSLOPT_NO_PARTIALCHAIN);
-        
-        // 允许libcurl协商最佳TLS版本
-        curl_easy_setopt(curl, CURLOPT_SSLVERSION, CURL_SSLVERSION_MAX_DEFAULT);
-        curl_easy_setopt(curl, CURLOPT_PROXY_SSLVERSION, CURL_SSLVERSION_MAX_DEFAULT);
-    } else {
-        // 如果没有提供CA证书，禁用SSL验证
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
-        curl_easy_setopt(curl, CURLOPT_PROXY_SSL_VERIFYPEER, 0L);
-        curl_easy_setopt(curl, CURLOPT_PROXY_SSL_VERIFYHOST, 0L);
-        appendDebug("警告: 未提供CA证书，SSL验证已禁用");
-    }
-
-    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, &ProxyClient::headerCallback);
-    curl_easy_setopt(curl, CURLOPT_HEADERDATA, this);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &ProxyClient::writeCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, this);
-
-    CURLcode res = curl_easy_perform(curl);
-    long response = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response);
-    curl_easy_cleanup(curl);
-
-    QMetaObject::invokeMethod(this, [this, res, response]() {
-        timer_->stop();
-        connecting_ = false;
-        if (res != CURLE_OK) {
-            QString errorMsg = QString::fromUtf8(curl_easy_strerror(res));
-            appendDebug("CURL错误代码: " + QString::number(res));
-            appendDebug("CURL错误描述: " + errorMsg);
-            
-            // 针对SSL错误的特殊处理
-            if (res == CURLE_SSL_CONNECT_ERROR || res == CURLE_SSL_CERTPROBLEM || 
-                res == CURLE_PEER_FAILED_VERIFICATION) {
-                errorMsg += "\n\n可能的解决方案:\n";
-                errorMsg += "1. 检查CA证书文件是否正确\n";
-                errorMsg += "2. 确认证书文件格式为PEM格式\n";
-                errorMsg += "3. 验证证书是否与代理服务器匹配\n";
-                errorMsg += "4. 尝试使用不同的SSL版本";
-            }
-            
-            finishWithError(errorMsg);
-            return;
-        }
-        if (response < 200 || response >= 300) {
-            finishWithError(tr("HTTP 状态码 %1").arg(response));
-            return;
-        }
+void ProxyClient::capturePublicKey(const QString &profileName)
+{
+    const ProxyProfile *profile = settings_->profile(profileName);
+    if (!profile || profile->certificatePath.isEmpty() || !profile->pinnedPublicKey.isEmpty()) {
+        return;
+    }
+    if (pinCaptureIds_.values().contains(profileName)) {
+        return;
+    }
+    const auto backoff = pinCaptureBackoff_.constFind(profileName);
+    if (backoff != pinCaptureBackoff_.constEnd() && QDateTime::currentMSecsSinceEpoch() < backoff->retryAtMs) {
+        return;
+    }
 
-        QString result;
-        result += "=== 连接成功 ===\n";
-        result += QString("HTTP 状态 %1\n\n").arg(response);
-        if (bodyBuffer_.startsWith("<!DOCTYPE") || bodyBuffer_.startsWith("<html")) {
-            result += QString::fromUtf8(bodyBuffer_);
-        } else {
-            result += QString("[二进制内容, 前 128 字节十六进制]\n%1")
-                          .arg(QString(bodyBuffer_.left(128).toHex(' ')));
-        }
-        emit connectionFinished(true, result);
-    }, Qt::QueuedConnection);
+    TransferRequest request;
+    request.proxy = settings_->proxyOptions(*profile);
+    // 只用来让调度器按代理主机排队，握手本身直接连代理端口
+    const QString host = request.proxy.host.contains(':') ? "[" + request.proxy.host + "]" : request.proxy.host;
+    request.url = QString("https://%1:%2/").arg(host).arg(request.proxy.port);
+    request.capturePublicKey = true;
+    pinCaptureIds_.insert(scheduler_->submit(request, TransferScheduler::Background), profileName);
+}
+
+void ProxyClient::onPublicKeyCaptureFinished(const QString &profileName, const TransferResult &result)
+{
+    if (!result.proxyPublicKey.isEmpty()) {
+        pinCaptureBackoff_.remove(profileName);
+        appendDebug(tr("已固定档案 %1 的代理公钥: %2").arg(profileName, result.proxyPublicKey));
+        emit proxyPublicKeyCaptured(profileName, result.proxyPublicKey);
+        return;
+    }
+
+    PinCaptureBackoff &backoff = pinCaptureBackoff_[profileName];
+    const qint64 delayMs = qMin(kMaxPinCaptureRetryMs, kPinCaptureRetryMs << qMin(backoff.failures, 7));
+    ++backoff.failures;
+    backoff.retryAtMs = QDateTime::currentMSecsSinceEpoch() + delayMs;
+    appendDebug(tr("捕获档案 %1 的代理公钥失败，%2 秒后的请求成功时重试: %3")
+                    .arg(profileName)
+                    .arg(delayMs / 1000)
+                    .arg(result.proxyPublicKeyError));
+}
+
+void ProxyClient::finishBatch(bool cancelled)
+{
+    ScopedSpan span("ProxyClient::finishBatch");
+    const double seconds = qMax<qint64>(1, batch_.timer.elapsed()) / 1000.0;
+    QString summary = QString("=== 批量请求%1 ===\n").arg(cancelled ? "已取消" : "完成");
+    summary += QString("完成 %1/%2, 成功 %3, 用时 %4 秒, %5 请求/秒, 线路 %6 字节\n")
+                   .arg(batch_.finished)
+                   .arg(batch_.total)
+                   .arg(batch_.succeeded)
+                   .arg(seconds, 0, 'f', 1)
+                   .arg(batch_.finished / seconds, 0, 'f', 1)
+                   .arg(batch_.wireBytes);
+    summary += scheduler_->describeStats() + "\n";
+    if (memoryCache_) {
+        summary += memoryCache_->describeStats() + "\n";
+    }
+    if (cache_) {
+        summary += cache_->describeStats() + "\n";
+    }
+    for (auto it = batch_.perHost.constBegin(); it != batch_.perHost.constEnd(); ++it) {
+        summary += QString("  %1: %2 个请求\n").arg(it.key()).arg(it.value());
+    }
+
+    // 已中止的传输稍后仍会回报结果，清空ID后直接忽略
+    batchIds_.clear();
+    batch_ = BatchStats();
+    emit batchFinished(summary);
+}
+
+QString ProxyClient::formatTransferStats(qint64 wireBytes, qint64 decodedBytes, const QString &encoding)
+{
+    ScopedSpan span("ProxyClient::formatTransferStats");
+    QString stats = QString("传输统计: 线路 %1 字节, 解码后 %2 字节, 编码 %3")
+                        .arg(wireBytes)
+                        .arg(decodedBytes)
+                        .arg(encoding.isEmpty() ? QString("identity") : encoding);
+    if (decodedBytes > 0 && wireBytes < decodedBytes) {
+        const double saved = 100.0 * (decodedBytes - wireBytes) / decodedBytes;
+        stats += QString(", 节省 %1%").arg(saved, 0, 'f', 1);
+    }
+    return stats;
+}
+
+QString ProxyClient::formatUploadStats(const TransferResult &result)
+{
+    ScopedSpan span("ProxyClient::formatUploadStats");
+    if (result.uploadedBytes <= 0) {
+        return QString();
+    }
+    QString stats = QString("上传统计: %1 字节, 耗时 %2 ms, 上传 %3 KB/s, 下载 %4 KB/s")
+                        .arg(result.uploadedBytes)
+                        .arg(result.uploadMs)
+                        .arg(result.uploadBytesPerSecond / 1024)
+                        .arg(result.downloadBytesPerSecond / 1024);
+    // 读取源文件占上传时间的比例高时，瓶颈在本地而不是代理链路
+    if (result.uploadMs > 0) {
+        stats += QString(", 读取请求体占 %1%")
+                     .arg(qMin(100.0, 100.0 * result.uploadReadMs / result.uploadMs), 0, 'f', 1);
+    }
+    return stats;
 }
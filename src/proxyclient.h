@@ -2,10 +2,19 @@
 #define PROXYCLIENT_H
 
 #include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QSharedPointer>
 #include <QStringList>
-#include <QThread>
-#include <QTimer>
 #include <curl/curl.h>
+#include "appsettings.h"
+#include "connectionpool.h"
+#include "memorycache.h"
+#include "responsecache.h"
+#include "responsedata.h"
+#include "transfercontext.h"
+#include "transferscheduler.h"
 
 class ProxyClient : public QObject
 {
@@ -14,42 +23,87 @@ public:
     explicit ProxyClient(QObject *parent = nullptr);
     ~ProxyClient() override;
 
-    void setProxySettings(const QString &host, int port,
-                          const QString &username = {},
-                          const QString &password = {});
-    void setSslCertificate(const QString &certificatePath);
-    void connectToUrl(const QString &url);
+    // 使用的配置快照，后续请求都基于它创建
+    void setSettings(const QSharedPointer<const AppSettings> &settings);
+    // 配置热加载后只重建发生变化的档案的连接池，进行中的传输继续使用旧池直到结束
+    void reconfigure(const QSharedPointer<const AppSettings> &settings, const ConfigChanges &changes);
+    // method为POST或PUT时，请求体从uploadPath流式上传，"-"表示标准输入
+    void connectToUrl(const QString &url, const QByteArray &method = "GET", const QString &uploadPath = QString());
+    // 当前档案的连接池尚未使用过时，在后台对url发一个HEAD请求建立隧道
+    void prewarm(const QString &url);
     void cancelRequest();
     bool isConnecting() const { return connecting_; }
+    // 批量请求：交给调度器按每主机/每代理的并发和速率限制发出
+    void runBatch(const QStringList &urls);
+    void cancelBatch();
+    bool isBatchRunning() const { return batch_.total > 0; }
+    // 当前传输的进度快照，供界面定时采样；没有进行中的传输时返回全零
+    TransferProgress progress() const { return current_ ? current_->progress() : TransferProgress(); }
 
 signals:
     void connectionStarted();
+    // 失败时result是错误描述；成功时状态和统计已经写入调试输出，result为空
     void connectionFinished(bool success, const QString &result);
     void networkError(const QString &errorMessage);
     void debugMessage(const QString &message);
+    // 收到HTTP响应（含非2xx状态）时发出，响应体可能是内存映射的转存文件
+    void responseReceived(const QSharedPointer<ResponseData> &response);
+    void batchFinished(const QString &summary);
+    // 首次经CA验证连接成功后捕获到代理公钥，由界面写入该档案的配置
+    void proxyPublicKeyCaptured(const QString &profile, const QString &pin);
 
 private:
     void appendDebug(const QString &msg);
     void finishWithError(const QString &msg);
-    void performRequest();
-    static size_t headerCallback(char *buffer, size_t size, size_t nitems, void *userdata);
-    static size_t writeCallback(char *ptr, size_t size, size_t nmemb, void *userdata);
+    QSharedPointer<ConnectionPool> poolFor(const ProxyProfile &profile);
+    void handleResult(quint64 transferId, const QSharedPointer<TransferResult> &result);
+    static QString formatTransferStats(qint64 wireBytes, qint64 decodedBytes, const QString &encoding);
+    // 没有上传请求体时返回空字符串
+    static QString formatUploadStats(const TransferResult &result);
+    void onScheduledTransferFinished(quint64 id, const QString &host, const QSharedPointer<TransferResult> &result);
+    // 档案有CA但还没有固定公钥时，提交一个后台任务捕获代理公钥；失败后按退避时间暂停重试
+    void capturePublicKey(const QString &profileName);
+    void onPublicKeyCaptureFinished(const QString &profileName, const TransferResult &result);
+    void finishBatch(bool cancelled);
 
-    QThread *worker_ { nullptr };
-    QTimer  *timer_  { nullptr };
+    // 只在GUI线程上替换，每次请求开始时从中取出代理参数交给TransferContext
+    QSharedPointer<const AppSettings> settings_;
 
-    QString proxyHost_;
-    int     proxyPort_ { 8080 };
-    QString proxyUser_;
-    QString proxyPass_;
-
-    QString caPath_;
-    QString targetUrl_;
-
-    QByteArray headerBuffer_;
-    QByteArray bodyBuffer_;
+    // 每个档案各自的连接池，切换档案时互不影响
+    QHash<QString, QSharedPointer<ConnectionPool>> pools_;
+    // 未启用缓存时为空；工作线程通过TransferRequest共享同一个实例
+    QSharedPointer<ResponseCache> cache_;
+    QSharedPointer<MemoryCache> memoryCache_;
+    QSharedPointer<TransferContext> current_;
+    // 调度器任务ID：当前交互请求和后台预热
+    quint64 transferId_ { 0 };
+    quint64 prewarmId_ { 0 };
+    // 当前交互请求所用的档案，请求成功后据此捕获公钥
+    QString requestProfile_;
+    // 公钥捕获：进行中的任务（任务ID到档案名）和各档案连续失败后的退避
+    struct PinCaptureBackoff
+    {
+        int failures { 0 };
+        qint64 retryAtMs { 0 };
+    };
+    QHash<quint64, QString> pinCaptureIds_;
+    QHash<QString, PinCaptureBackoff> pinCaptureBackoff_;
     bool connecting_ { false };
     QStringList debugLines_;
+
+    // 批量请求
+    struct BatchStats
+    {
+        int total { 0 };
+        int finished { 0 };
+        int succeeded { 0 };
+        qint64 wireBytes { 0 };
+        QElapsedTimer timer;
+        QHash<QString, int> perHost;
+    };
+    TransferScheduler *scheduler_ { nullptr };
+    QSet<quint64> batchIds_;
+    BatchStats batch_;
 };
 
 #endif // PROXYCLIENT_H
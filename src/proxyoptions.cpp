@@ -0,0 +1,79 @@
+#include "proxyoptions.h"
+
+void applyProxyOptions(CURL *curl, const ProxyOptions &options, QStringList *log)
+{
+    curl_easy_setopt(curl, CURLOPT_PROXY, options.host.toUtf8().constData());
+    curl_easy_setopt(curl, CURLOPT_PROXYPORT, static_cast<long>(options.port));
+    curl_easy_setopt(curl, CURLOPT_PROXYTYPE, CURLPROXY_HTTPS);
+    curl_easy_setopt(curl, CURLOPT_HTTPPROXYTUNNEL, 1L);
+
+    if (!options.username.isEmpty()) {
+        QByteArray auth = QString("%1:%2").arg(options.username, options.password).toUtf8();
+        curl_easy_setopt(curl, CURLOPT_PROXYUSERPWD, auth.constData());
+    }
+
+    if (!options.pinnedPublicKey.isEmpty()) {
+        // 代理是自己部署的，证书公钥已知：握手时只比对SPKI哈希，省去加载CA文件和构建证书链，
+        // 不一致时libcurl以CURLE_SSL_PINNEDPUBKEYNOTMATCH明确报错
+        curl_easy_setopt(curl, CURLOPT_PROXY_PINNEDPUBLICKEY, options.pinnedPublicKey.toLatin1().constData());
+        curl_easy_setopt(curl, CURLOPT_PROXY_SSL_VERIFYPEER, 0L);
+        curl_easy_setopt(curl, CURLOPT_PROXY_SSL_VERIFYHOST, 0L);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+        curl_easy_setopt(curl, CURLOPT_PROXY_SSLVERSION, CURL_SSLVERSION_MAX_DEFAULT);
+        if (log) *log << "代理证书按固定公钥验证: " + options.pinnedPublicKey;
+    } else if (!options.caPath.isEmpty()) {
+        curl_easy_setopt(curl, CURLOPT_CAINFO, options.caPath.toUtf8().constData());
+        curl_easy_setopt(curl, CURLOPT_PROXY_CAINFO, options.caPath.toUtf8().constData());
+        if (log) *log << "使用CA证书: " + options.caPath;
+        
+        // SSL配置 - 针对自签名证书优化
+        // 对代理服务器启用SSL验证
+        curl_easy_setopt(curl, CURLOPT_PROXY_SSL_VERIFYPEER, 1L);
+        curl_easy_setopt(curl, CURLOPT_PROXY_SSL_VERIFYHOST, 2L);
+        
+        // 对目标服务器禁用SSL验证（因为目标服务器通常是受信任的）
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+        if (log) *log << "代理服务器SSL验证已启用，目标服务器SSL验证已禁用";
+        
+        // 添加SSL选项以处理自签名证书的常见问题
+        curl_easy_setopt(curl, CURLOPT_SSL_OPTIONS, CURLSSLOPT_ALLOW_BEAST | CURLSSLOPT_NO_REVOKE | CURLSSLOPT_NO_PARTIALCHAIN);
+        
+        // 允许libcurl协商最佳TLS版本
+        curl_easy_setopt(curl, CURLOPT_SSLVERSION, CURL_SSLVERSION_MAX_DEFAULT);
+        curl_easy_setopt(curl, CURLOPT_PROXY_SSLVERSION, CURL_SSLVERSION_MAX_DEFAULT);
+    } else {
+        // 如果没有提供CA证书，禁用SSL验证
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+        curl_easy_setopt(curl, CURLOPT_PROXY_SSL_VERIFYPEER, 0L);
+        curl_easy_setopt(curl, CURLOPT_PROXY_SSL_VERIFYHOST, 0L);
+        if (log) *log << "警告: 未提供CA证书，SSL验证已禁用";
+    }
+
+    // 压缩传输：空字符串表示协商当前libcurl支持的全部编码，并由libcurl流式解压后写入body
+    if (options.compression) {
+        curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+        if (log) *log << "压缩传输已启用，协商编码: " + supportedEncodings().join(", ");
+    }
+}
+
+QStringList supportedEncodings()
+{
+    QStringList encodings;
+    const curl_version_info_data *info = curl_version_info(CURLVERSION_NOW);
+    if (info->features & CURL_VERSION_LIBZ) {
+        encodings << "gzip" << "deflate";
+    }
+    if (info->features & CURL_VERSION_BROTLI) {
+        encodings << "br";
+    }
+    if (info->features & CURL_VERSION_ZSTD) {
+        encodings << "zstd";
+    }
+    if (encodings.isEmpty()) {
+        encodings << "identity";
+    }
+    return encodings;
+}
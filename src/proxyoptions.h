@@ -0,0 +1,27 @@
+#ifndef PROXYOPTIONS_H
+#define PROXYOPTIONS_H
+
+#include <QString>
+#include <QStringList>
+#include <curl/curl.h>
+
+// 通过EasyProxy建立HTTPS隧道所需的连接参数
+struct ProxyOptions
+{
+    QString host;
+    int     port { 8080 };
+    QString username;
+    QString password;
+    QString caPath;
+    // 非空时只核对代理证书公钥，不再用caPath构建证书链
+    QString pinnedPublicKey;
+    bool    compression { true };
+};
+
+// 把代理、认证与TLS设置应用到easy句柄上，log用于收集需要显示的调试信息
+void applyProxyOptions(CURL *curl, const ProxyOptions &options, QStringList *log = nullptr);
+
+// 当前libcurl支持的内容编码
+QStringList supportedEncodings();
+
+#endif // PROXYOPTIONS_H
@@ -0,0 +1,152 @@
+#include "publickeypin.h"
+#include "curlruntime.h"
+#include <QCryptographicHash>
+
+namespace {
+// 只做一次TLS握手，不需要等太久
+constexpr long kHandshakeTimeoutMs = 10'000;
+
+// 读取pos处的一个DER TLV，内容范围写入contentPos/contentLength，返回整个TLV之后的位置，格式错误时返回-1
+qsizetype readTlv(const QByteArray &der, qsizetype pos, quint8 *tag, qsizetype *contentPos, qsizetype *contentLength)
+{
+    if (pos + 2 > der.size()) {
+        return -1;
+    }
+    *tag = static_cast<quint8>(der.at(pos));
+    const quint8 first = static_cast<quint8>(der.at(pos + 1));
+    pos += 2;
+    qsizetype length = 0;
+    if (first < 0x80) {
+        length = first;
+    } else {
+        // 长格式：低7位是长度字段的字节数，证书里不会超过4字节
+        const int count = first & 0x7f;
+        if (count == 0 || count > 4 || pos + count > der.size()) {
+            return -1;
+        }
+        for (int i = 0; i < count; ++i) {
+            length = (length << 8) | static_cast<quint8>(der.at(pos + i));
+        }
+        pos += count;
+    }
+    if (length < 0 || pos + length > der.size()) {
+        return -1;
+    }
+    *contentPos = pos;
+    *contentLength = length;
+    return pos + length;
+}
+
+QByteArray pemToDer(const QByteArray &pem)
+{
+    const QByteArray begin = "-----BEGIN CERTIFICATE-----";
+    const QByteArray end = "-----END CERTIFICATE-----";
+    const qsizetype from = pem.indexOf(begin);
+    if (from < 0) {
+        return pem;  // 已经是DER
+    }
+    const qsizetype to = pem.indexOf(end, from);
+    if (to < 0) {
+        return QByteArray();
+    }
+    const qsizetype bodyStart = from + begin.size();
+    return QByteArray::fromBase64(pem.mid(bodyStart, to - bodyStart));
+}
+
+void setError(QString *error, const QString &message)
+{
+    if (error) {
+        *error = message;
+    }
+}
+}
+
+QString publicKeyPinFromCertificate(const QByteArray &certificate, QString *error)
+{
+    const QByteArray der = pemToDer(certificate);
+    quint8 tag = 0;
+    qsizetype pos = 0;
+    qsizetype length = 0;
+
+    // Certificate ::= SEQUENCE { tbsCertificate, signatureAlgorithm, signatureValue }
+    if (readTlv(der, 0, &tag, &pos, &length) < 0 || tag != 0x30
+        || readTlv(der, pos, &tag, &pos, &length) < 0 || tag != 0x30) {
+        setError(error, "证书不是有效的DER编码");
+        return QString();
+    }
+
+    // TBSCertificate ::= SEQUENCE { [0] version OPTIONAL, serialNumber, signature, issuer,
+    //                               validity, subject, subjectPublicKeyInfo, ... }
+    qsizetype cursor = pos;
+    qsizetype next = readTlv(der, cursor, &tag, &pos, &length);
+    if (next > 0 && tag == 0xa0) {
+        cursor = next;
+    }
+    // 跳过serialNumber、signature、issuer、validity、subject五个字段
+    for (int i = 0; i < 5 && cursor >= 0; ++i) {
+        cursor = readTlv(der, cursor, &tag, &pos, &length);
+    }
+
+    const qsizetype spkiEnd = cursor < 0 ? -1 : readTlv(der, cursor, &tag, &pos, &length);
+    if (spkiEnd < 0 || tag != 0x30) {
+        setError(error, "证书中找不到SubjectPublicKeyInfo");
+        return QString();
+    }
+
+    const QByteArray digest = QCryptographicHash::hash(der.mid(cursor, spkiEnd - cursor),
+                                                       QCryptographicHash::Sha256);
+    return "sha256//" + QString::fromLatin1(digest.toBase64());
+}
+
+QString fetchProxyPublicKeyPin(const ProxyOptions &options, bool verify, QString *error)
+{
+    CurlRuntime::ensureInitialized();
+    CURL *curl = curl_easy_init();
+    if (!curl) {
+        setError(error, "初始化curl失败");
+        return QString();
+    }
+
+    // 代理本身就是TLS服务端，直接以https访问代理端口即可拿到它的证书
+    const QString host = options.host.contains(':') ? "[" + options.host + "]" : options.host;
+    const QByteArray url = QString("https://%1:%2/").arg(host).arg(options.port).toUtf8();
+    char errorBuffer[CURL_ERROR_SIZE] = {};
+    curl_easy_setopt(curl, CURLOPT_URL, url.constData());
+    curl_easy_setopt(curl, CURLOPT_CONNECT_ONLY, 1L);
+    curl_easy_setopt(curl, CURLOPT_CERTINFO, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, kHandshakeTimeoutMs);
+    curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, errorBuffer);
+    if (verify) {
+        curl_easy_setopt(curl, CURLOPT_CAINFO, options.caPath.toUtf8().constData());
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 2L);
+        curl_easy_setopt(curl, CURLOPT_SSL_OPTIONS, CURLSSLOPT_NO_REVOKE | CURLSSLOPT_NO_PARTIALCHAIN);
+    } else {
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+    }
+
+    QString pin;
+    const CURLcode code = curl_easy_perform(curl);
+    struct curl_certinfo *certInfo = nullptr;
+    if (code != CURLE_OK) {
+        setError(error, QString::fromUtf8(errorBuffer[0] ? errorBuffer : curl_easy_strerror(code)));
+    } else if (curl_easy_getinfo(curl, CURLINFO_CERTINFO, &certInfo) != CURLE_OK || !certInfo
+               || certInfo->num_of_certs < 1) {
+        setError(error, "当前TLS后端不提供证书信息（CERTINFO）");
+    } else {
+        // 第0个是代理自己的证书，其余是链上的中间证书
+        for (struct curl_slist *item = certInfo->certinfo[0]; item; item = item->next) {
+            const QByteArray line(item->data);
+            if (line.startsWith("Cert:")) {
+                pin = publicKeyPinFromCertificate(line.mid(5), error);
+                break;
+            }
+        }
+        if (pin.isEmpty() && error && error->isEmpty()) {
+            *error = "证书信息中没有证书内容";
+        }
+    }
+    curl_easy_cleanup(curl);
+    return pin;
+}
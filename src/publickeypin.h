@@ -0,0 +1,19 @@
+#ifndef PUBLICKEYPIN_H
+#define PUBLICKEYPIN_H
+
+#include <QByteArray>
+#include <QString>
+#include "proxyoptions.h"
+
+// 代理证书公钥固定（CURLOPT_PROXY_PINNEDPUBLICKEY）使用的"sha256//<base64>"格式，
+// 哈希对象是证书中完整的SubjectPublicKeyInfo，与证书有效期、签发者无关
+
+// 从PEM或DER格式的X.509证书中取出SubjectPublicKeyInfo并计算固定值，格式不对时返回空字符串
+QString publicKeyPinFromCertificate(const QByteArray &certificate, QString *error = nullptr);
+
+// 直接与代理端口做一次TLS握手（不发送请求），通过CERTINFO取得代理证书并计算固定值。
+// verify为true时按options.caPath验证证书链和主机名，只有验证通过才返回结果；
+// 为false时只读取代理当前出示的证书，用于公钥不一致时的诊断
+QString fetchProxyPublicKeyPin(const ProxyOptions &options, bool verify, QString *error = nullptr);
+
+#endif // PUBLICKEYPIN_H
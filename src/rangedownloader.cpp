@@ -0,0 +1,567 @@
+#include "rangedownloader.h"
+#include "curlruntime.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QMetaObject>
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+// 每段至少这么大，小文件不值得为拆分付出额外的握手
+constexpr qint64 kMinSegmentBytes = 1024 * 1024;
+// 每段网络出错后从已写入的位置续传的次数
+constexpr int kMaxAttempts = 3;
+// 大接收缓冲减少回调和写入次数，参见吞吐量测试的结果
+constexpr long kReceiveBufferSize = 512 * 1024;
+// 日志更新间隔；每次更新前要刷盘，太频繁会拖慢下载
+constexpr qint64 kJournalIntervalMs = 2000;
+
+double toMbps(qint64 bytes, qint64 ms)
+{
+    return ms > 0 ? bytes / (ms / 1000.0) / (1024.0 * 1024.0) : 0.0;
+}
+}
+
+RangeDownloader::RangeDownloader(QObject *parent)
+    : QObject(parent)
+{
+}
+
+RangeDownloader::~RangeDownloader()
+{
+    // 工作线程访问本对象，必须等它结束
+    cancel_ = true;
+    if (worker_) {
+        worker_->wait();
+    }
+}
+
+void RangeDownloader::start(const Config &config)
+{
+    if (running_ || config.proxies.isEmpty()) {
+        return;
+    }
+
+    running_ = true;
+    cancel_ = false;
+
+    QThread *thread = QThread::create([this, config]() { run(config); });
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    worker_ = thread;
+    thread->start();
+}
+
+void RangeDownloader::cancel()
+{
+    cancel_ = true;
+}
+
+void RangeDownloader::post(const QString &message)
+{
+    QMetaObject::invokeMethod(this, [this, message]() { emit sample(message); }, Qt::QueuedConnection);
+}
+
+bool RangeDownloader::writeAt(int fd, qint64 offset, const char *data, qint64 size)
+{
+#ifdef _WIN32
+    HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+    while (size > 0) {
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD written = 0;
+        if (!WriteFile(handle, data, static_cast<DWORD>(size), &written, &overlapped) || written == 0) {
+            return false;
+        }
+        data += written;
+        offset += written;
+        size -= written;
+    }
+#else
+    while (size > 0) {
+        const ssize_t written = pwrite(fd, data, static_cast<size_t>(size), static_cast<off_t>(offset));
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        offset += written;
+        size -= written;
+    }
+#endif
+    return true;
+}
+
+bool RangeDownloader::preallocate(int fd, qint64 size)
+{
+#if defined(__linux__)
+    // resize只设置逻辑长度，这里再让文件系统一次性分配好块，避免并行写入造成碎片
+    return posix_fallocate(fd, 0, static_cast<off_t>(size)) == 0;
+#else
+    // Windows上SetEndOfFile已经为文件分配了空间
+    Q_UNUSED(fd);
+    Q_UNUSED(size);
+    return true;
+#endif
+}
+
+bool RangeDownloader::syncFile(int fd)
+{
+#ifdef _WIN32
+    return FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(fd)));
+#elif defined(__linux__)
+    return fdatasync(fd) == 0;
+#else
+    return fsync(fd) == 0;
+#endif
+}
+
+void RangeDownloader::checkpoint(const Config &config, const QList<Segment> &segments, int fd,
+                                 DownloadJournal *journal)
+{
+    if (!journal) {
+        return;
+    }
+    // 先取快照再刷盘：快照之后写入的字节这次不计入日志
+    for (qsizetype i = 0; i < segments.size(); ++i) {
+        journal->ranges[i].written = segments.at(i).written;
+    }
+    if (!syncFile(fd) || !journal->save(config.outputPath)) {
+        post("更新下载日志失败，中断后可能需要重新下载部分数据");
+    }
+}
+
+size_t RangeDownloader::writeCallback(char *ptr, size_t size, size_t nmemb, void *userdata)
+{
+    Segment *segment = static_cast<Segment *>(userdata);
+    RangeDownloader *self = segment->self;
+    const qint64 bytes = static_cast<qint64>(size * nmemb);
+
+    if (!segment->checkedStatus) {
+        long status = 0;
+        curl_easy_getinfo(segment->curl, CURLINFO_RESPONSE_CODE, &status);
+        // 分段时必须是206；If-Range不匹配时服务器会返回200和完整文件
+        const long expected = segment->length < 0 ? 200 : 206;
+        if (status != expected) {
+            segment->changed = status == 200 && segment->length >= 0;
+            segment->error = QString("服务器返回HTTP %1而不是%2，文件可能已变化或不支持Range").arg(status).arg(expected);
+            return 0;
+        }
+        segment->checkedStatus = true;
+        if (segment->firstByteMs < 0) {
+            segment->firstByteMs = self->clock_.elapsed();
+        }
+    }
+
+    if (segment->length >= 0 && segment->written + bytes > segment->length) {
+        segment->error = "服务器返回的数据超出了请求的范围";
+        return 0;
+    }
+    if (!writeAt(segment->fd, segment->offset + segment->written, ptr, bytes)) {
+        segment->error = "写入输出文件失败";
+        return 0;
+    }
+    segment->written += bytes;
+    return size * nmemb;
+}
+
+size_t RangeDownloader::discardCallback(char *, size_t size, size_t nmemb, void *)
+{
+    return size * nmemb;
+}
+
+int RangeDownloader::baselineProgressCallback(void *clientp, curl_off_t, curl_off_t, curl_off_t, curl_off_t)
+{
+    RangeDownloader *self = static_cast<RangeDownloader *>(clientp);
+    return self->cancel_ || self->clock_.elapsed() >= self->baselineDeadlineMs_ ? 1 : 0;
+}
+
+RangeDownloader::Probe RangeDownloader::probe(const Config &config)
+{
+    Probe info;
+    CURL *curl = curl_easy_init();
+    if (!curl) {
+        info.error = tr("初始化curl失败");
+        return info;
+    }
+
+    ProxyOptions proxy = config.proxies.first();
+    // 字节范围针对的是未编码的表示，不能协商压缩
+    proxy.compression = false;
+    applyProxyOptions(curl, proxy);
+    curl_easy_setopt(curl, CURLOPT_URL, config.url.toUtf8().constData());
+    curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+
+    const CURLcode rc = curl_easy_perform(curl);
+    long status = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+    if (rc != CURLE_OK) {
+        info.error = QString::fromUtf8(curl_easy_strerror(rc));
+    } else if (status < 200 || status >= 300) {
+        info.error = QString("HTTP 状态码 %1").arg(status);
+    } else {
+        curl_off_t length = -1;
+        curl_easy_getinfo(curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length);
+        info.size = length;
+
+        struct curl_header *header = nullptr;
+        if (curl_easy_header(curl, "Accept-Ranges", 0, CURLH_HEADER, -1, &header) == CURLHE_OK) {
+            info.acceptRanges = QString::fromLatin1(header->value).contains("bytes", Qt::CaseInsensitive);
+        }
+        // If-Range只接受强ETag，弱ETag时退而使用Last-Modified
+        if (curl_easy_header(curl, "ETag", 0, CURLH_HEADER, -1, &header) == CURLHE_OK
+            && !QString::fromLatin1(header->value).startsWith("W/")) {
+            info.validator = QString::fromLatin1(header->value).trimmed();
+        } else if (curl_easy_header(curl, "Last-Modified", 0, CURLH_HEADER, -1, &header) == CURLHE_OK) {
+            info.validator = QString::fromLatin1(header->value).trimmed();
+        }
+    }
+    curl_easy_cleanup(curl);
+    return info;
+}
+
+double RangeDownloader::measureBaseline(const Config &config, QString *error)
+{
+    CURL *curl = curl_easy_init();
+    if (!curl) {
+        *error = tr("初始化curl失败");
+        return 0;
+    }
+
+    ProxyOptions proxy = config.proxies.first();
+    proxy.compression = false;
+    applyProxyOptions(curl, proxy);
+    curl_easy_setopt(curl, CURLOPT_URL, config.url.toUtf8().constData());
+    curl_easy_setopt(curl, CURLOPT_BUFFERSIZE, kReceiveBufferSize);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &RangeDownloader::discardCallback);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, &RangeDownloader::baselineProgressCallback);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, this);
+
+    clock_.start();
+    baselineDeadlineMs_ = config.baselineSeconds * 1000LL;
+    const CURLcode rc = curl_easy_perform(curl);
+
+    curl_off_t downloaded = 0;
+    curl_off_t totalUs = 0;
+    curl_off_t firstByteUs = 0;
+    curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &downloaded);
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &totalUs);
+    curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &firstByteUs);
+    curl_easy_cleanup(curl);
+
+    if (rc != CURLE_OK && rc != CURLE_ABORTED_BY_CALLBACK) {
+        *error = QString::fromUtf8(curl_easy_strerror(rc));
+        return 0;
+    }
+    // 与吞吐量测试一致，只统计首字节之后的时间
+    return toMbps(downloaded, (totalUs - firstByteUs) / 1000);
+}
+
+void RangeDownloader::startSegment(CURLM *multi, const Config &config, const Probe &info, Segment &segment)
+{
+    CURL *curl = curl_easy_init();
+    segment.curl = curl;
+    segment.checkedStatus = false;
+    ++segment.attempts;
+
+    ProxyOptions proxy = config.proxies.at(segment.index % config.proxies.size());
+    proxy.compression = false;
+    applyProxyOptions(curl, proxy);
+    curl_easy_setopt(curl, CURLOPT_URL, config.url.toUtf8().constData());
+    if (segment.length >= 0) {
+        // 重试时从已写入的位置继续
+        const QByteArray range = QString("%1-%2")
+                                     .arg(segment.offset + segment.written)
+                                     .arg(segment.offset + segment.length - 1)
+                                     .toLatin1();
+        curl_easy_setopt(curl, CURLOPT_RANGE, range.constData());
+        if (!info.validator.isEmpty()) {
+            segment.headers = curl_slist_append(nullptr, ("If-Range: " + info.validator).toLatin1().constData());
+            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, segment.headers);
+        }
+    }
+    curl_easy_setopt(curl, CURLOPT_BUFFERSIZE, kReceiveBufferSize);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &RangeDownloader::writeCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &segment);
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, &segment);
+    curl_multi_add_handle(multi, curl);
+}
+
+bool RangeDownloader::download(const Config &config, const Probe &info, QList<Segment> &segments, int fd,
+                               DownloadJournal *journal, QString *error)
+{
+    CURLM *multi = curl_multi_init();
+    // 不做HTTP/2多路复用，每段独占一条隧道，这正是分段下载的意义
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, static_cast<long>(CURLPIPE_NOTHING));
+
+    clock_.start();
+    int running = 0;
+    for (Segment &segment : segments) {
+        segment.self = this;
+        segment.fd = fd;
+        // 续传时已完成的段不再请求
+        if (segment.length >= 0 && segment.written == segment.length) {
+            continue;
+        }
+        startSegment(multi, config, info, segment);
+        ++running;
+    }
+
+    qint64 lastSampleMs = 0;
+    qint64 lastSampleBytes = 0;
+    for (const Segment &segment : segments) {
+        lastSampleBytes += segment.written;
+    }
+    qint64 lastJournalMs = 0;
+    while (running > 0 && !cancel_ && error->isEmpty()) {
+        curl_multi_perform(multi, &running);
+
+        int queued = 0;
+        while (CURLMsg *message = curl_multi_info_read(multi, &queued)) {
+            if (message->msg != CURLMSG_DONE) {
+                continue;
+            }
+            Segment *segment = nullptr;
+            curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &segment);
+            const CURLcode rc = message->data.result;
+            curl_multi_remove_handle(multi, segment->curl);
+            curl_easy_cleanup(segment->curl);
+            segment->curl = nullptr;
+            curl_slist_free_all(segment->headers);
+            segment->headers = nullptr;
+
+            const bool complete = segment->length < 0 ? rc == CURLE_OK : segment->written == segment->length;
+            if (complete) {
+                segment->doneMs = clock_.elapsed();
+                continue;
+            }
+            // 写回调记录的错误（状态码不符、写盘失败）重试也无济于事；网络错误从断点续传
+            const bool retryable = segment->error.isEmpty() && segment->length >= 0
+                && segment->attempts < kMaxAttempts;
+            const QString reason = !segment->error.isEmpty() ? segment->error
+                : rc != CURLE_OK                             ? QString::fromUtf8(curl_easy_strerror(rc))
+                                                             : QString("连接提前关闭");
+            if (retryable) {
+                post(QString("第 %1 段在 %2/%3 字节处中断（%4），重试")
+                         .arg(segment->index + 1)
+                         .arg(segment->written)
+                         .arg(segment->length)
+                         .arg(reason));
+                startSegment(multi, config, info, *segment);
+                ++running;
+            } else {
+                *error = QString("第 %1 段失败: %2").arg(segment->index + 1).arg(reason);
+            }
+        }
+
+        const qint64 now = clock_.elapsed();
+        if (now - lastSampleMs >= 1000) {
+            qint64 bytes = 0;
+            for (const Segment &segment : segments) {
+                bytes += segment.written;
+            }
+            post(QString("%1s: %2 MB/s，已下载 %3%")
+                     .arg(now / 1000)
+                     .arg(toMbps(bytes - lastSampleBytes, now - lastSampleMs), 0, 'f', 1)
+                     .arg(info.size > 0 ? 100.0 * bytes / info.size : 0.0, 0, 'f', 1));
+            lastSampleMs = now;
+            lastSampleBytes = bytes;
+        }
+        if (now - lastJournalMs >= kJournalIntervalMs) {
+            checkpoint(config, segments, fd, journal);
+            lastJournalMs = clock_.elapsed();
+        }
+
+        if (running > 0) {
+            curl_multi_poll(multi, nullptr, 0, 100, nullptr);
+        }
+    }
+
+    for (Segment &segment : segments) {
+        if (segment.curl) {
+            curl_multi_remove_handle(multi, segment.curl);
+            curl_easy_cleanup(segment.curl);
+            segment.curl = nullptr;
+        }
+        curl_slist_free_all(segment.headers);
+        segment.headers = nullptr;
+    }
+    curl_multi_cleanup(multi);
+    // 失败或取消时保存最终进度，下次从这里继续
+    checkpoint(config, segments, fd, journal);
+    return error->isEmpty() && !cancel_;
+}
+
+void RangeDownloader::run(const Config &config)
+{
+    CurlRuntime::ensureInitialized();
+    QString summary = "=== 分段并行下载结果 ===\n";
+    QString error;
+
+    post(QString("探测 %1").arg(config.url));
+    const Probe info = probe(config);
+    double baselineMbps = 0;
+    QList<Segment> segments;
+    qint64 elapsedMs = 0;
+    qint64 resumedBytes = 0;
+    QFile output(config.outputPath);
+
+    if (!info.error.isEmpty()) {
+        error = "探测失败: " + info.error;
+    } else {
+        const bool ranged = info.acceptRanges && info.size > 0;
+        if (!ranged) {
+            post("服务器未声明Accept-Ranges或长度未知，退回单连接下载");
+        }
+        // 日志与本次探测结果一致且输出文件还在时续传，否则作废日志从头下载
+        DownloadJournal journal;
+        const bool resuming = ranged && journal.load(config.outputPath)
+            && journal.matches(config.url, info.size, info.validator)
+            && QFile::exists(config.outputPath) && QFileInfo(config.outputPath).size() == info.size;
+        if (!resuming) {
+            DownloadJournal::remove(config.outputPath);
+        }
+
+        // 续传时沿用日志里的分段，基线测量没有意义，跳过
+        if (config.baselineSeconds > 0 && !resuming && !cancel_) {
+            post(QString("单连接基线测量 %1 秒...").arg(config.baselineSeconds));
+            QString baselineError;
+            baselineMbps = measureBaseline(config, &baselineError);
+            if (!baselineError.isEmpty()) {
+                post("基线测量失败: " + baselineError);
+            } else {
+                post(QString("单连接基线: %1 MB/s").arg(baselineMbps, 0, 'f', 1));
+            }
+        }
+
+        if (cancel_) {
+            // 取消时还没有创建或改动输出文件
+        } else if (!output.open(resuming ? QIODevice::ReadWrite : QIODevice::WriteOnly | QIODevice::Truncate)) {
+            error = "无法创建输出文件: " + output.errorString();
+        } else {
+            if (resuming) {
+                for (int i = 0; i < journal.ranges.size(); ++i) {
+                    const DownloadJournal::Range &range = journal.ranges.at(i);
+                    Segment segment;
+                    segment.index = i;
+                    segment.offset = range.offset;
+                    segment.length = range.length;
+                    segment.written = range.written;
+                    segment.resumed = range.written;
+                    segments << segment;
+                }
+                resumedBytes = journal.completedBytes();
+                post(QString("从下载日志续传: 已完成 %1 / %2 字节 (%3%)")
+                         .arg(resumedBytes)
+                         .arg(info.size)
+                         .arg(100.0 * resumedBytes / info.size, 0, 'f', 1));
+            } else {
+                if (info.size > 0 && (!output.resize(info.size) || !preallocate(output.handle(), info.size))) {
+                    post("预分配输出文件空间失败，继续下载");
+                }
+                // 小于kMinSegmentBytes的文件也至少一段；不能用qBound，它要求下界不大于上界
+                const int count = ranged
+                    ? static_cast<int>(qMax<qint64>(1, qMin<qint64>(config.connections, info.size / kMinSegmentBytes)))
+                    : 1;
+                const qint64 segmentLength = ranged ? (info.size + count - 1) / count : -1;
+                for (int i = 0; i < count; ++i) {
+                    Segment segment;
+                    segment.index = i;
+                    segment.offset = ranged ? i * segmentLength : 0;
+                    segment.length = ranged ? qMin(segmentLength, info.size - segment.offset) : -1;
+                    segments << segment;
+                }
+                if (ranged) {
+                    journal = DownloadJournal();
+                    journal.url = config.url;
+                    journal.validator = info.validator;
+                    journal.size = info.size;
+                    for (const Segment &segment : segments) {
+                        journal.ranges << DownloadJournal::Range { segment.offset, segment.length, 0 };
+                    }
+                }
+            }
+
+            // 没有验证器时无法确认续传的是同一个文件，不记录日志
+            const bool journaled = ranged && !info.validator.isEmpty();
+            post(QString("开始下载: %1 段，%2 个代理%3")
+                     .arg(segments.size())
+                     .arg(qMin<qsizetype>(segments.size(), config.proxies.size()))
+                     .arg(journaled ? QString() : QString("，服务器未提供ETag/Last-Modified，不支持断点续传")));
+            download(config, info, segments, output.handle(), journaled ? &journal : nullptr, &error);
+            elapsedMs = clock_.elapsed();
+            output.close();
+
+            bool changed = false;
+            for (const Segment &segment : segments) {
+                changed = changed || segment.changed;
+            }
+            if (error.isEmpty() && !cancel_) {
+                DownloadJournal::remove(config.outputPath);
+            } else if (journaled && !changed) {
+                post(QString("下载进度已保存到 %1，再次下载同一文件时将续传")
+                         .arg(DownloadJournal::pathFor(config.outputPath)));
+            } else {
+                // 服务器上的文件已变化或无法续传，已写入的数据没有用处
+                DownloadJournal::remove(config.outputPath);
+                output.remove();
+            }
+        }
+    }
+
+    if (!error.isEmpty()) {
+        summary += error + "\n";
+    } else if (cancel_) {
+        summary += "下载已取消\n";
+    } else {
+        qint64 total = 0;
+        qint64 transferred = 0;
+        qint64 firstByteMs = -1;
+        qint64 lastDoneMs = 0;
+        for (const Segment &segment : segments) {
+            total += segment.written;
+            transferred += segment.written - segment.resumed;
+            if (segment.firstByteMs >= 0 && (firstByteMs < 0 || segment.firstByteMs < firstByteMs)) {
+                firstByteMs = segment.firstByteMs;
+            }
+            lastDoneMs = qMax(lastDoneMs, segment.doneMs);
+        }
+        // 持续吞吐量从最早的首字节算到最后一段完成，排除各隧道的建立开销；续传前的字节不计入
+        const double parallelMbps = toMbps(transferred, lastDoneMs - qMax<qint64>(0, firstByteMs));
+        summary += QString("文件: %1 (%2 字节)\n").arg(config.outputPath).arg(total);
+        if (resumedBytes > 0) {
+            summary += QString("续传: 日志中已完成 %1 字节，本次下载 %2 字节\n").arg(resumedBytes).arg(transferred);
+        }
+        summary += QString("分段: %1，代理: %2 个，总耗时 %3 s\n")
+                       .arg(segments.size())
+                       .arg(qMin<qsizetype>(segments.size(), config.proxies.size()))
+                       .arg(elapsedMs / 1000.0, 0, 'f', 2);
+        summary += QString("并行持续吞吐量: %1 MB/s\n").arg(parallelMbps, 0, 'f', 1);
+        if (baselineMbps > 0) {
+            summary += QString("单连接基线: %1 MB/s，加速比 %2x\n")
+                           .arg(baselineMbps, 0, 'f', 1)
+                           .arg(parallelMbps / baselineMbps, 0, 'f', 2);
+        }
+        for (const Segment &segment : segments) {
+            summary += QString("  第 %1 段 [%2, +%3): ").arg(segment.index + 1).arg(segment.offset).arg(segment.written);
+            if (segment.attempts == 0) {
+                summary += "续传前已完成\n";
+                continue;
+            }
+            summary += QString("%1 MB/s，尝试 %2 次\n")
+                           .arg(toMbps(segment.written - segment.resumed, segment.doneMs - segment.firstByteMs), 0, 'f', 1)
+                           .arg(segment.attempts);
+        }
+    }
+
+    QMetaObject::invokeMethod(this, [this, summary]() {
+        running_ = false;
+        worker_ = nullptr;
+        emit testFinished(summary);
+    }, Qt::QueuedConnection);
+}
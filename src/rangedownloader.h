@@ -0,0 +1,104 @@
+#ifndef RANGEDOWNLOADER_H
+#define RANGEDOWNLOADER_H
+
+#include <QObject>
+#include <QList>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QThread>
+#include <atomic>
+#include <curl/curl.h>
+#include "downloadjournal.h"
+#include "proxyoptions.h"
+
+// 把一个大文件按字节范围拆成N段，经N条代理隧道（可分布在多个代理上）并行下载，
+// 每段直接按偏移写入预分配的输出文件，并与单连接下载的持续吞吐量对比。
+// 进度定期记入日志，中断后再次下载同一URL到同一文件时从断点续传
+class RangeDownloader : public QObject
+{
+    Q_OBJECT
+public:
+    struct Config
+    {
+        // 第i段使用proxies[i % proxies.size()]
+        QList<ProxyOptions> proxies;
+        QString url;
+        QString outputPath;
+        int connections { 4 };
+        // 正式下载前用单连接测这么长时间作为对比基线，0表示跳过
+        int baselineSeconds { 5 };
+    };
+
+    explicit RangeDownloader(QObject *parent = nullptr);
+    ~RangeDownloader() override;
+
+    void start(const Config &config);
+    // 只请求停止，不等待：工作线程在下一次轮询时退出，服务器支持Range时进度保留在日志里供续传
+    void cancel();
+    bool isRunning() const { return running_; }
+
+signals:
+    void sample(const QString &message);
+    void testFinished(const QString &summary);
+
+private:
+    struct Probe
+    {
+        qint64  size { -1 };
+        bool    acceptRanges { false };
+        QString validator;  // ETag或Last-Modified，分段请求用If-Range保证各段来自同一版本
+        QString error;
+    };
+
+    struct Segment
+    {
+        RangeDownloader *self { nullptr };
+        int     index { 0 };
+        qint64  offset { 0 };
+        qint64  length { 0 };
+        qint64  written { 0 };
+        // 续传前已经写入的字节，不计入本次的吞吐量
+        qint64  resumed { 0 };
+        int     fd { -1 };
+        int     attempts { 0 };
+        bool    checkedStatus { false };
+        // 服务器对If-Range返回了完整文件，说明文件已变化，日志作废
+        bool    changed { false };
+        qint64  firstByteMs { -1 };
+        qint64  doneMs { 0 };
+        QString error;
+        CURL   *curl { nullptr };
+        struct curl_slist *headers { nullptr };
+    };
+
+    void run(const Config &config);
+    Probe probe(const Config &config);
+    // 单连接下载baselineSeconds秒，数据丢弃，返回首字节之后的MB/s
+    double measureBaseline(const Config &config, QString *error);
+    // journal为空表示服务器不支持Range，不记录进度
+    bool download(const Config &config, const Probe &info, QList<Segment> &segments, int fd,
+                  DownloadJournal *journal, QString *error);
+    // 先把已写入的数据刷到磁盘再更新日志，日志里的字节数不会多于实际落盘的
+    void checkpoint(const Config &config, const QList<Segment> &segments, int fd, DownloadJournal *journal);
+    void startSegment(CURLM *multi, const Config &config, const Probe &info, Segment &segment);
+    void post(const QString &message);
+
+    static size_t writeCallback(char *ptr, size_t size, size_t nmemb, void *userdata);
+    static size_t discardCallback(char *ptr, size_t size, size_t nmemb, void *userdata);
+    static int baselineProgressCallback(void *clientp, curl_off_t dltotal, curl_off_t dlnow,
+                                        curl_off_t ultotal, curl_off_t ulnow);
+    // 按绝对偏移写入，不移动文件指针，各段之间不需要加锁
+    static bool writeAt(int fd, qint64 offset, const char *data, qint64 size);
+    static bool preallocate(int fd, qint64 size);
+    static bool syncFile(int fd);
+
+    // 线程结束后自行deleteLater，QPointer随之清空
+    QPointer<QThread> worker_;
+    std::atomic<bool> cancel_ { false };
+    bool running_ { false };
+    // 以下只在工作线程访问
+    QElapsedTimer clock_;
+    qint64 baselineDeadlineMs_ { 0 };
+};
+
+#endif // RANGEDOWNLOADER_H
@@ -0,0 +1,636 @@
+#include "responsecache.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QSet>
+#include <QtEndian>
+#include <cstring>
+#include <curl/curl.h>
+
+namespace {
+const QByteArray kMagic = "EPCACHE1";
+constexpr qint64 kHeaderSize = 16;
+// 8192个槽位，索引文件固定4 MiB；条目数超过3/4时淘汰，保证探测链不会太长
+constexpr int kSlotCount = 8192;
+constexpr int kMaxEntries = kSlotCount * 3 / 4;
+// 启发式新鲜度的上限（RFC 9111 4.2.2建议取Last-Modified以来时间的10%）
+constexpr qint64 kMaxHeuristicSeconds = 24 * 3600;
+// 单个响应超过缓存上限的1/8时不缓存，避免一个大文件冲掉所有条目
+constexpr qint64 kMaxEntryFraction = 8;
+// 命中时只更新访问时间的槽位攒到这么多再一起写回，省掉每次命中的写盘和flush
+constexpr int kMaxDirtySlots = 64;
+
+// RFC 9110 15.1中默认可启发式缓存的状态码
+bool isHeuristicallyCacheable(int status)
+{
+    switch (status) {
+    case 200: case 203: case 204: case 300: case 301: case 308:
+    case 404: case 405: case 410: case 414: case 501:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// HTTP日期转为Unix秒，无法解析时返回-1
+qint64 parseHttpDate(const QString &value)
+{
+    if (value.isEmpty()) {
+        return -1;
+    }
+    return static_cast<qint64>(curl_getdate(value.toLatin1().constData(), nullptr));
+}
+}
+
+ResponseCache::ResponseCache(const QString &directory, qint64 maxBytes)
+    : directory_(directory)
+    , maxBytes_(maxBytes)
+{
+    QMutexLocker locker(&mutex_);
+    if (!openIndex()) {
+        qWarning() << "无法打开响应缓存索引:" << directory_;
+    }
+}
+
+ResponseCache::~ResponseCache()
+{
+    QMutexLocker locker(&mutex_);
+    if (index_.isOpen()) {
+        flushDirtySlots();
+    }
+    index_.close();
+}
+
+void ResponseCache::setMaxBytes(qint64 maxBytes)
+{
+    QMutexLocker locker(&mutex_);
+    maxBytes_ = maxBytes;
+    evict(0);
+}
+
+quint64 ResponseCache::keyHash(const QByteArray &url)
+{
+    const QByteArray digest = QCryptographicHash::hash(url, QCryptographicHash::Sha256);
+    return qFromLittleEndian<quint64>(digest.constData());
+}
+
+quint32 ResponseCache::recordChecksum(const Record &record)
+{
+    Record copy = record;
+    copy.checksum = 0;
+    return qChecksum(QByteArrayView(reinterpret_cast<const char *>(&copy), sizeof(copy)));
+}
+
+void ResponseCache::setField(char *field, size_t size, const QByteArray &value)
+{
+    std::memset(field, 0, size);
+    std::memcpy(field, value.constData(), qMin(size, static_cast<size_t>(value.size())));
+}
+
+QByteArray ResponseCache::field(const char *field, size_t size)
+{
+    return QByteArray(field, static_cast<qsizetype>(strnlen(field, size)));
+}
+
+QString ResponseCache::bodyPath(const QByteArray &hashHex) const
+{
+    return directory_ + "/bodies/" + QString::fromLatin1(hashHex.left(2)) + "/" + QString::fromLatin1(hashHex);
+}
+
+bool ResponseCache::openIndex()
+{
+    if (!QDir().mkpath(directory_ + "/bodies")) {
+        return false;
+    }
+    index_.setFileName(directory_ + "/index.db");
+    if (!index_.open(QIODevice::ReadWrite)) {
+        return false;
+    }
+
+    const qint64 expectedSize = kHeaderSize + static_cast<qint64>(kSlotCount) * sizeof(Record);
+    const QByteArray header = index_.read(kHeaderSize);
+    if (index_.size() != expectedSize || !header.startsWith(kMagic)
+        || qFromLittleEndian<quint32>(header.constData() + 8) != kSlotCount
+        || qFromLittleEndian<quint32>(header.constData() + 12) != sizeof(Record)) {
+        resetIndex();
+        return true;
+    }
+
+    slots_.resize(kSlotCount);
+    const qint64 bytes = static_cast<qint64>(kSlotCount) * sizeof(Record);
+    if (index_.read(reinterpret_cast<char *>(slots_.data()), bytes) != bytes) {
+        resetIndex();
+        return true;
+    }
+    // 相同内容的响应体只存一份，字节数也按内容哈希只算一次
+    QSet<QByteArray> bodies;
+    for (int i = 0; i < kSlotCount; ++i) {
+        Record &record = slots_[i];
+        if (record.state == Empty) {
+            continue;
+        }
+        // 写到一半的记录当作已删除，保留探测链，后面的条目仍然找得到
+        if (record.checksum != recordChecksum(record) || record.state != Used) {
+            record.state = Deleted;
+            ++deleted_;
+            continue;
+        }
+        ++used_;
+        const QByteArray bodyHash = field(record.bodyHash, sizeof(record.bodyHash));
+        if (!bodies.contains(bodyHash)) {
+            bodies.insert(bodyHash);
+            bytes_ += record.bodySize;
+        }
+    }
+    removeOrphanBodies();
+    return true;
+}
+
+void ResponseCache::resetIndex()
+{
+    slots_ = QList<Record>(kSlotCount);
+    dirtySlots_.clear();
+    used_ = 0;
+    deleted_ = 0;
+    bytes_ = 0;
+
+    QByteArray header = kMagic;
+    header.resize(kHeaderSize);
+    qToLittleEndian<quint32>(kSlotCount, header.data() + 8);
+    qToLittleEndian<quint32>(sizeof(Record), header.data() + 12);
+    index_.resize(0);
+    index_.seek(0);
+    index_.write(header);
+    index_.write(reinterpret_cast<const char *>(slots_.constData()), static_cast<qint64>(kSlotCount) * sizeof(Record));
+    index_.flush();
+
+    QDir(directory_ + "/bodies").removeRecursively();
+    QDir().mkpath(directory_ + "/bodies");
+}
+
+void ResponseCache::removeOrphanBodies()
+{
+    // 崩溃时可能留下没有索引记录的响应体，或淘汰时因文件被占用没删掉的
+    QSet<QString> referenced;
+    for (const Record &record : slots_) {
+        if (record.state == Used) {
+            referenced.insert(QString::fromLatin1(field(record.bodyHash, sizeof(record.bodyHash))));
+        }
+    }
+    QDirIterator it(directory_ + "/bodies", QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        if (!referenced.contains(QFileInfo(path).fileName())) {
+            QFile::remove(path);
+        }
+    }
+}
+
+void ResponseCache::writeRecord(int slot)
+{
+    Record &record = slots_[slot];
+    record.checksum = recordChecksum(record);
+    index_.seek(kHeaderSize + static_cast<qint64>(slot) * sizeof(Record));
+    index_.write(reinterpret_cast<const char *>(&record), sizeof(Record));
+}
+
+void ResponseCache::writeSlot(int slot)
+{
+    dirtySlots_.remove(slot);
+    writeRecord(slot);
+    index_.flush();
+}
+
+void ResponseCache::touchSlot(int slot, qint64 nowMs)
+{
+    slots_[slot].lastAccessMs = nowMs;
+    dirtySlots_.insert(slot);
+    if (dirtySlots_.size() >= kMaxDirtySlots) {
+        flushDirtySlots();
+    }
+}
+
+void ResponseCache::flushDirtySlots()
+{
+    if (dirtySlots_.isEmpty()) {
+        return;
+    }
+    for (int slot : std::as_const(dirtySlots_)) {
+        writeRecord(slot);
+    }
+    dirtySlots_.clear();
+    index_.flush();
+}
+
+bool ResponseCache::openBody(Entry *entry) const
+{
+    std::shared_ptr<QFile> file = std::make_shared<QFile>(entry->bodyPath);
+    if (!file->open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    entry->bodyFile = std::move(file);
+    return true;
+}
+
+int ResponseCache::findSlot(quint64 keyHash, const QByteArray &url) const
+{
+    const QByteArray storedUrl = url.left(sizeof(Record::url));
+    const int start = static_cast<int>(keyHash % kSlotCount);
+    for (int i = 0; i < kSlotCount; ++i) {
+        const int slot = (start + i) % kSlotCount;
+        const Record &record = slots_.at(slot);
+        if (record.state == Empty) {
+            return -1;
+        }
+        if (record.state == Used && record.keyHash == keyHash && field(record.url, sizeof(record.url)) == storedUrl) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+int ResponseCache::freeSlot(quint64 keyHash) const
+{
+    const int start = static_cast<int>(keyHash % kSlotCount);
+    for (int i = 0; i < kSlotCount; ++i) {
+        const int slot = (start + i) % kSlotCount;
+        if (slots_.at(slot).state != Used) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+bool ResponseCache::isBodyReferenced(const QByteArray &hashHex) const
+{
+    for (const Record &record : slots_) {
+        if (record.state == Used && field(record.bodyHash, sizeof(record.bodyHash)) == hashHex) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ResponseCache::removeSlot(int slot, const QByteArray &keepBody)
+{
+    Record &record = slots_[slot];
+    const QByteArray hash = field(record.bodyHash, sizeof(record.bodyHash));
+    record.state = Deleted;
+    --used_;
+    ++deleted_;
+    writeSlot(slot);
+
+    // 内容寻址的响应体可能被其他URL共用，没有引用时才扣除字节数并删除
+    if (isBodyReferenced(hash)) {
+        return;
+    }
+    bytes_ -= record.bodySize;
+    if (hash != keepBody) {
+        QFile::remove(bodyPath(hash));
+    }
+}
+
+void ResponseCache::evict(qint64 incomingBytes, const QByteArray &keepBody)
+{
+    while (used_ > 0 && (used_ >= kMaxEntries || bytes_ + incomingBytes > maxBytes_)) {
+        int oldest = -1;
+        for (int i = 0; i < kSlotCount; ++i) {
+            const Record &record = slots_.at(i);
+            if (record.state == Used && (oldest < 0 || record.lastAccessMs < slots_.at(oldest).lastAccessMs)) {
+                oldest = i;
+            }
+        }
+        removeSlot(oldest, keepBody);
+    }
+    if (deleted_ > kSlotCount / 4) {
+        compact();
+    }
+}
+
+void ResponseCache::compact()
+{
+    // 删除标记太多时探测链变长，重新插入全部条目并整体重写索引
+    QList<Record> live;
+    for (const Record &record : slots_) {
+        if (record.state == Used) {
+            live << record;
+        }
+    }
+    slots_ = QList<Record>(kSlotCount);
+    dirtySlots_.clear();
+    deleted_ = 0;
+    for (Record record : live) {
+        record.checksum = recordChecksum(record);
+        slots_[freeSlot(record.keyHash)] = record;
+    }
+    index_.seek(kHeaderSize);
+    index_.write(reinterpret_cast<const char *>(slots_.constData()), static_cast<qint64>(kSlotCount) * sizeof(Record));
+    index_.flush();
+}
+
+ResponseCache::Freshness ResponseCache::computeFreshness(const ResponseInfo &info, qint64 requestTimeMs,
+                                                         qint64 responseTimeMs)
+{
+    Freshness freshness;
+
+    bool hasMaxAge = false;
+    qint64 maxAge = 0;
+    for (const QString &part : info.cacheControl.split(',', Qt::SkipEmptyParts)) {
+        const QString directive = part.trimmed().toLower();
+        if (directive == "no-store") {
+            return freshness;
+        }
+        if (directive == "no-cache") {
+            freshness.flags |= NoCache;
+        } else if (directive == "must-revalidate") {
+            freshness.flags |= MustRevalidate;
+        } else if (directive.startsWith("max-age=")) {
+            QString value = directive.mid(8);
+            value.remove(QLatin1Char('"'));
+            maxAge = qMax<qint64>(0, value.toLongLong(&hasMaxAge));
+        }
+    }
+    // 请求头只有Accept-Encoding会变化，而缓存保存的是解码后的内容；按其他请求头区分的响应不缓存
+    for (const QString &name : info.vary.split(',', Qt::SkipEmptyParts)) {
+        if (name.trimmed().compare("Accept-Encoding", Qt::CaseInsensitive) != 0) {
+            return freshness;
+        }
+    }
+    freshness.storable = true;
+
+    // RFC 9111 4.2.3 计算年龄
+    const qint64 responseTime = responseTimeMs / 1000;
+    qint64 date = parseHttpDate(info.date);
+    if (date < 0) {
+        date = responseTime;
+    }
+    const qint64 ageValue = qMax<qint64>(0, info.age.trimmed().toLongLong());
+    const qint64 apparentAge = qMax<qint64>(0, responseTime - date);
+    const qint64 responseDelay = qMax<qint64>(0, (responseTimeMs - requestTimeMs) / 1000);
+    freshness.initialAgeSeconds = qMax(apparentAge, ageValue + responseDelay);
+
+    // RFC 9111 4.2.1 新鲜度：max-age优先，其次Expires，最后根据Last-Modified启发式估计
+    if (hasMaxAge) {
+        freshness.lifetimeSeconds = maxAge;
+    } else if (!info.expires.isEmpty()) {
+        // 无法解析的Expires（例如"0"）视为已过期
+        const qint64 expires = parseHttpDate(info.expires);
+        freshness.lifetimeSeconds = expires < 0 ? 0 : qMax<qint64>(0, expires - date);
+    } else {
+        const qint64 lastModified = parseHttpDate(info.lastModified);
+        if (lastModified >= 0 && lastModified < date) {
+            freshness.lifetimeSeconds = qMin(kMaxHeuristicSeconds, (date - lastModified) / 10);
+        }
+    }
+    return freshness;
+}
+
+ResponseCache::Entry ResponseCache::entryFor(const Record &record, qint64 nowMs) const
+{
+    Entry entry;
+    entry.valid = true;
+    entry.status = record.status;
+    entry.bodySize = record.bodySize;
+    entry.bodyPath = bodyPath(field(record.bodyHash, sizeof(record.bodyHash)));
+    entry.etag = QString::fromLatin1(field(record.etag, sizeof(record.etag)));
+    entry.lastModified = QString::fromLatin1(field(record.lastModified, sizeof(record.lastModified)));
+    entry.contentType = QString::fromLatin1(field(record.contentType, sizeof(record.contentType)));
+    entry.ageSeconds = record.initialAgeSeconds + qMax<qint64>(0, nowMs - record.responseTimeMs) / 1000;
+    entry.lifetimeSeconds = record.lifetimeSeconds;
+    entry.fresh = !(record.flags & NoCache) && record.lifetimeSeconds > entry.ageSeconds;
+    return entry;
+}
+
+ResponseCache::Entry ResponseCache::lookup(const QString &url)
+{
+    QMutexLocker locker(&mutex_);
+    if (!index_.isOpen()) {
+        return Entry();
+    }
+    const QByteArray key = url.toUtf8();
+    const int slot = findSlot(keyHash(key), key);
+    if (slot < 0) {
+        return Entry();
+    }
+
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    Entry entry = entryFor(slots_.at(slot), nowMs);
+    // 在锁内打开响应体：解锁后其他线程的store可能淘汰本条目并删除文件
+    if (!openBody(&entry)) {
+        removeSlot(slot);
+        return Entry();
+    }
+    touchSlot(slot, nowMs);
+    return entry;
+}
+
+QByteArray ResponseCache::writeBody(const BodyBuffer &body)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if (!body.forEachChunk([&hash](const char *data, qsizetype size) {
+            hash.addData(QByteArrayView(data, size));
+            return true;
+        })) {
+        return QByteArray();
+    }
+    const QByteArray hex = hash.result().toHex();
+    const QString path = bodyPath(hex);
+    if (QFile::exists(path)) {
+        return hex;
+    }
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return QByteArray();
+    }
+    if (!body.forEachChunk([&file](const char *data, qsizetype size) { return file.write(data, size) == size; })) {
+        file.cancelWriting();
+        return QByteArray();
+    }
+    return file.commit() ? hex : QByteArray();
+}
+
+void ResponseCache::store(const QString &url, const ResponseInfo &info, const BodyBuffer &body,
+                          qint64 requestTimeMs, qint64 responseTimeMs)
+{
+    if (!isOpen()) {
+        return;
+    }
+    const QByteArray key = url.toUtf8();
+    const quint64 hash = keyHash(key);
+    const Freshness freshness = computeFreshness(info, requestTimeMs, responseTimeMs);
+    const bool hasValidator = !info.etag.isEmpty() || !info.lastModified.isEmpty();
+
+    {
+        // 新响应总是替换旧条目；不可缓存时旧条目也一并作废
+        QMutexLocker locker(&mutex_);
+        const int slot = findSlot(hash, key);
+        if (slot >= 0) {
+            removeSlot(slot);
+        }
+    }
+    // 既不新鲜又无法重新验证的响应存下来也用不上
+    if (!freshness.storable || !isHeuristicallyCacheable(info.status)
+        || (freshness.lifetimeSeconds == 0 && !hasValidator)
+        || body.size() > maxBytes_ / kMaxEntryFraction) {
+        return;
+    }
+
+    // 响应体在锁外计算哈希和写盘
+    const QByteArray bodyHash = writeBody(body);
+    if (bodyHash.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&mutex_);
+    // 锁外写盘期间其他线程可能已存入同一URL，先删掉它，否则会留下两条Used记录
+    const int existing = findSlot(hash, key);
+    if (existing >= 0) {
+        removeSlot(existing, bodyHash);
+    }
+    evict(isBodyReferenced(bodyHash) ? 0 : body.size(), bodyHash);
+    // 写盘之后、加锁之前，其他线程淘汰共用这份内容的条目时可能已删除文件
+    if (!QFile::exists(bodyPath(bodyHash))) {
+        return;
+    }
+    const int slot = freeSlot(hash);
+    if (slot < 0) {
+        return;
+    }
+    if (slots_.at(slot).state == Deleted) {
+        --deleted_;
+    }
+
+    const bool newBody = !isBodyReferenced(bodyHash);
+    Record record;
+    std::memset(&record, 0, sizeof(record));
+    record.keyHash = hash;
+    record.state = Used;
+    record.flags = freshness.flags;
+    record.status = static_cast<quint16>(info.status);
+    record.responseTimeMs = responseTimeMs;
+    record.initialAgeSeconds = freshness.initialAgeSeconds;
+    record.lifetimeSeconds = freshness.lifetimeSeconds;
+    record.lastAccessMs = responseTimeMs;
+    record.bodySize = body.size();
+    setField(record.bodyHash, sizeof(record.bodyHash), bodyHash);
+    // 验证器放不下时不保存，避免发出截断后永远不匹配的条件请求
+    if (info.etag.size() < static_cast<qsizetype>(sizeof(record.etag))) {
+        setField(record.etag, sizeof(record.etag), info.etag.toLatin1());
+    }
+    setField(record.lastModified, sizeof(record.lastModified), info.lastModified.toLatin1());
+    setField(record.contentType, sizeof(record.contentType), info.contentType.toLatin1());
+    setField(record.url, sizeof(record.url), key);
+    slots_[slot] = record;
+    ++used_;
+    if (newBody) {
+        bytes_ += record.bodySize;
+    }
+    writeSlot(slot);
+    ++stores_;
+}
+
+ResponseCache::Entry ResponseCache::refresh(const QString &url, const ResponseInfo &info, qint64 requestTimeMs,
+                                            qint64 responseTimeMs)
+{
+    QMutexLocker locker(&mutex_);
+    const QByteArray key = url.toUtf8();
+    const int slot = findSlot(keyHash(key), key);
+    if (slot < 0) {
+        return Entry();
+    }
+
+    // RFC 9111 4.3.4：用304中出现的头部更新保存的元数据，没出现的保持原值
+    Record &record = slots_[slot];
+    ResponseInfo merged = info;
+    merged.status = record.status;
+    if (merged.etag.isEmpty()) {
+        merged.etag = QString::fromLatin1(field(record.etag, sizeof(record.etag)));
+    }
+    if (merged.lastModified.isEmpty()) {
+        merged.lastModified = QString::fromLatin1(field(record.lastModified, sizeof(record.lastModified)));
+    }
+    const Freshness freshness = computeFreshness(merged, requestTimeMs, responseTimeMs);
+    record.responseTimeMs = responseTimeMs;
+    record.initialAgeSeconds = freshness.initialAgeSeconds;
+    record.lastAccessMs = responseTimeMs;
+    if (!info.cacheControl.isEmpty() || !info.expires.isEmpty()) {
+        record.flags = freshness.flags;
+        record.lifetimeSeconds = freshness.lifetimeSeconds;
+    }
+    if (merged.etag.size() < static_cast<qsizetype>(sizeof(record.etag))) {
+        setField(record.etag, sizeof(record.etag), merged.etag.toLatin1());
+    }
+    setField(record.lastModified, sizeof(record.lastModified), merged.lastModified.toLatin1());
+    writeSlot(slot);
+    Entry entry = entryFor(record, responseTimeMs);
+    if (!openBody(&entry)) {
+        removeSlot(slot);
+        return Entry();
+    }
+    return entry;
+}
+
+void ResponseCache::count(Outcome outcome)
+{
+    switch (outcome) {
+    case Hit:
+        ++hits_;
+        break;
+    case Revalidated:
+        ++revalidated_;
+        break;
+    case Miss:
+        ++misses_;
+        break;
+    case NotCached:
+        break;
+    }
+}
+
+ResponseCache::Stats ResponseCache::stats() const
+{
+    Stats stats;
+    stats.hits = hits_;
+    stats.revalidated = revalidated_;
+    stats.misses = misses_;
+    stats.stores = stores_;
+    QMutexLocker locker(&mutex_);
+    stats.entries = used_;
+    stats.bytes = bytes_;
+    return stats;
+}
+
+QString ResponseCache::describeStats() const
+{
+    const Stats s = stats();
+    const quint64 total = s.hits + s.revalidated + s.misses;
+    return QString("响应缓存: 命中 %1, 重新验证 %2, 未命中 %3 (命中率 %4%), 条目 %5, 占用 %6 KB")
+        .arg(s.hits)
+        .arg(s.revalidated)
+        .arg(s.misses)
+        .arg(total > 0 ? 100.0 * (s.hits + s.revalidated) / total : 0.0, 0, 'f', 1)
+        .arg(s.entries)
+        .arg(s.bytes / 1024);
+}
+
+QString ResponseCache::outcomeName(Outcome outcome)
+{
+    switch (outcome) {
+    case Hit:
+        return "命中，未访问网络";
+    case Revalidated:
+        return "已重新验证（304），使用缓存内容";
+    case Miss:
+        return "未命中";
+    case NotCached:
+        break;
+    }
+    return "未使用";
+}
@@ -0,0 +1,170 @@
+#ifndef RESPONSECACHE_H
+#define RESPONSECACHE_H
+
+#include <QFile>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <atomic>
+#include <memory>
+#include "bufferpool.h"
+
+// 按RFC 9111实现的私有响应缓存，只缓存GET请求。
+// 索引是磁盘上的开放寻址哈希表（定长记录，按槽位原地更新），响应体按SHA-256内容寻址存放，
+// 相同内容的响应只保存一份。所有方法都可以从工作线程调用
+class ResponseCache
+{
+public:
+    enum Outcome { NotCached, Hit, Revalidated, Miss };
+
+    // 响应中与缓存有关的头部，同名头部多次出现时以逗号连接
+    struct ResponseInfo
+    {
+        int     status { 0 };
+        QString cacheControl;
+        QString expires;
+        QString date;
+        QString age;
+        QString etag;
+        QString lastModified;
+        QString contentType;
+        QString vary;
+        // RFC 9111已不再定义响应中的Pragma，磁盘缓存忽略它；内存缓存遇到no-cache时不保存
+        QString pragma;
+    };
+
+    struct Entry
+    {
+        bool    valid { false };
+        // 新鲜的条目直接使用，不访问网络；否则需要带验证器发条件请求
+        bool    fresh { false };
+        int     status { 0 };
+        qint64  bodySize { 0 };
+        QString bodyPath;
+        // lookup/refresh在锁内打开的响应体。之后条目即使被淘汰，已打开的文件仍可读取和映射
+        // （Windows上被占用的文件删不掉，留给下次启动时清理）
+        std::shared_ptr<QFile> bodyFile;
+        QString etag;
+        QString lastModified;
+        QString contentType;
+        qint64  ageSeconds { 0 };
+        qint64  lifetimeSeconds { 0 };
+    };
+
+    enum RecordFlag : quint8 { NoCache = 0x01, MustRevalidate = 0x02 };
+
+    // 按RFC 9111从响应头计算出的可缓存性和新鲜度，内存缓存也用它决定条目的有效期
+    struct Freshness
+    {
+        bool   storable { false };
+        quint8 flags { 0 };
+        qint64 initialAgeSeconds { 0 };
+        qint64 lifetimeSeconds { 0 };
+    };
+
+    struct Stats
+    {
+        quint64 hits { 0 };
+        quint64 revalidated { 0 };
+        quint64 misses { 0 };
+        quint64 stores { 0 };
+        int     entries { 0 };
+        qint64  bytes { 0 };
+    };
+
+    ResponseCache(const QString &directory, qint64 maxBytes);
+    ~ResponseCache();
+    ResponseCache(const ResponseCache &) = delete;
+    ResponseCache &operator=(const ResponseCache &) = delete;
+
+    bool isOpen() const { return index_.isOpen(); }
+    QString directory() const { return directory_; }
+    void setMaxBytes(qint64 maxBytes);
+
+    Entry lookup(const QString &url);
+    // 网络请求完成后调用；不可缓存的响应（no-store、Vary等）会顺带删除旧条目
+    void store(const QString &url, const ResponseInfo &info, const BodyBuffer &body,
+               qint64 requestTimeMs, qint64 responseTimeMs);
+    // 条件请求得到304后，用新的头部更新新鲜度并返回原来的响应体
+    Entry refresh(const QString &url, const ResponseInfo &info, qint64 requestTimeMs, qint64 responseTimeMs);
+    void count(Outcome outcome);
+
+    Stats stats() const;
+    QString describeStats() const;
+    static QString outcomeName(Outcome outcome);
+
+    static Freshness computeFreshness(const ResponseInfo &info, qint64 requestTimeMs, qint64 responseTimeMs);
+
+private:
+    enum RecordState : quint8 { Empty = 0, Used = 1, Deleted = 2 };
+
+    // 索引文件中的一条记录，定长512字节，按本机字节序存放
+    struct Record
+    {
+        quint64 keyHash;
+        quint8  state;
+        quint8  flags;
+        quint16 status;
+        quint32 checksum;
+        qint64  responseTimeMs;
+        qint64  initialAgeSeconds;
+        qint64  lifetimeSeconds;
+        qint64  lastAccessMs;
+        qint64  bodySize;
+        char    bodyHash[64];
+        char    etag[128];
+        char    lastModified[48];
+        char    contentType[96];
+        // URL只保存前120字节，用来在64位键哈希之外再核对一次
+        char    url[120];
+    };
+    static_assert(sizeof(Record) == 512, "索引记录必须是定长512字节");
+
+    bool openIndex();
+    void resetIndex();
+    void removeOrphanBodies();
+    void writeSlot(int slot);
+    // 命中时只更新内存中的访问时间，攒够一批再写回索引
+    void touchSlot(int slot, qint64 nowMs);
+    void flushDirtySlots();
+    void writeRecord(int slot);
+    // 打开条目的响应体文件，文件已不存在时返回false
+    bool openBody(Entry *entry) const;
+    int findSlot(quint64 keyHash, const QByteArray &url) const;
+    int freeSlot(quint64 keyHash) const;
+    bool isBodyReferenced(const QByteArray &hashHex) const;
+    // 删除条目；keepBody是正要存入的响应体，即使不再被引用也不删除文件
+    void removeSlot(int slot, const QByteArray &keepBody = QByteArray());
+    // 条目数或字节数超出上限时按最近访问时间淘汰
+    void evict(qint64 incomingBytes, const QByteArray &keepBody = QByteArray());
+    void compact();
+    Entry entryFor(const Record &record, qint64 nowMs) const;
+    QString bodyPath(const QByteArray &hashHex) const;
+    // 计算SHA-256并写入内容寻址文件，已存在则跳过写入
+    QByteArray writeBody(const BodyBuffer &body);
+
+    static quint64 keyHash(const QByteArray &url);
+    static quint32 recordChecksum(const Record &record);
+    static void setField(char *field, size_t size, const QByteArray &value);
+    static QByteArray field(const char *field, size_t size);
+
+    const QString directory_;
+    std::atomic<qint64> maxBytes_;
+    mutable QMutex mutex_;
+    QFile index_;
+    QList<Record> slots_;
+    // 访问时间已更新但还没写回索引的槽位；丢失只影响重启后的淘汰顺序
+    QSet<int> dirtySlots_;
+    int used_ { 0 };
+    int deleted_ { 0 };
+    // 磁盘上响应体的总字节数，多条记录共用的内容只算一次
+    qint64 bytes_ { 0 };
+
+    std::atomic<quint64> hits_ { 0 };
+    std::atomic<quint64> revalidated_ { 0 };
+    std::atomic<quint64> misses_ { 0 };
+    std::atomic<quint64> stores_ { 0 };
+};
+
+#endif // RESPONSECACHE_H
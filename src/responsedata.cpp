@@ -0,0 +1,69 @@
+#include "responsedata.h"
+#include <cstring>
+
+QSharedPointer<ResponseData> ResponseData::fromBody(BodyBuffer &&body)
+{
+    QSharedPointer<ResponseData> response(new ResponseData());
+    const qint64 size = body.size();
+
+    if (body.isSpilled()) {
+        response->file_ = body.takeSpillFile();
+        response->file_->flush();
+        if (size > 0) {
+            response->map_ = response->file_->map(0, size);
+        }
+        if (size > 0 && !response->map_) {
+            response->error_ = response->file_->errorString();
+            return response;
+        }
+        response->data_ = reinterpret_cast<const char *>(response->map_);
+        response->size_ = size;
+        return response;
+    }
+
+    response->bytes_ = body.takeByteArray();
+    response->data_ = response->bytes_.constData();
+    response->size_ = response->bytes_.size();
+    return response;
+}
+
+QSharedPointer<ResponseData> ResponseData::fromFile(const std::shared_ptr<QFile> &file)
+{
+    QSharedPointer<ResponseData> response(new ResponseData());
+    response->file_ = file;
+    const qint64 size = response->file_->size();
+    if (size > 0) {
+        response->map_ = response->file_->map(0, size);
+        if (!response->map_) {
+            response->error_ = response->file_->errorString();
+            return response;
+        }
+    }
+    response->data_ = reinterpret_cast<const char *>(response->map_);
+    response->size_ = size;
+    return response;
+}
+
+ResponseData::~ResponseData()
+{
+    if (map_) {
+        file_->unmap(map_);
+    }
+    // 单分段的响应体是从缓冲池借来的，还回去供下一个请求复用
+    BufferPool::instance().release(std::move(bytes_));
+}
+
+bool ResponseData::looksBinary() const
+{
+    const qint64 probe = qMin<qint64>(size_, 4096);
+    return probe > 0 && std::memchr(data_, 0, static_cast<size_t>(probe)) != nullptr;
+}
+
+QByteArray ResponseData::slice(qint64 offset, qint64 length) const
+{
+    if (offset < 0 || offset >= size_ || length <= 0) {
+        return QByteArray();
+    }
+    length = qMin(length, size_ - offset);
+    return QByteArray::fromRawData(data_ + offset, static_cast<qsizetype>(length));
+}
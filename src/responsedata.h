@@ -0,0 +1,43 @@
+#ifndef RESPONSEDATA_H
+#define RESPONSEDATA_H
+
+#include <QByteArray>
+#include <QSharedPointer>
+#include <QString>
+#include <QFile>
+#include <memory>
+#include "bufferpool.h"
+
+// 完整响应体的只读连续视图：小响应保存在内存中，转存到文件的大响应通过内存映射访问
+class ResponseData
+{
+public:
+    static QSharedPointer<ResponseData> fromBody(BodyBuffer &&body);
+    // 直接映射已打开的文件（例如缓存中的响应体），不复制；映射期间文件对象一直被持有
+    static QSharedPointer<ResponseData> fromFile(const std::shared_ptr<QFile> &file);
+    ~ResponseData();
+    ResponseData(const ResponseData &) = delete;
+    ResponseData &operator=(const ResponseData &) = delete;
+
+    const char *data() const { return data_; }
+    qint64 size() const { return size_; }
+    bool isMapped() const { return map_ != nullptr; }
+    QString errorString() const { return error_; }
+    // 开头4 KiB中出现NUL字节即视为二进制内容
+    bool looksBinary() const;
+
+    // 不复制数据的片段，生命周期不能超过本对象
+    QByteArray slice(qint64 offset, qint64 length) const;
+
+private:
+    ResponseData() = default;
+
+    QByteArray bytes_;
+    std::shared_ptr<QFile> file_;
+    uchar *map_ { nullptr };
+    const char *data_ { nullptr };
+    qint64 size_ { 0 };
+    QString error_;
+};
+
+#endif // RESPONSEDATA_H
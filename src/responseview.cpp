@@ -0,0 +1,284 @@
+#include "responseview.h"
+#include "hexdump.h"
+#include "spanprofiler.h"
+#include <QFontMetrics>
+#include <QMutexLocker>
+#include <QPainter>
+#include <QScrollBar>
+#include <QtConcurrent>
+#include <climits>
+#include <cstring>
+
+namespace {
+// 每隔多少行记录一次行起始偏移
+constexpr qint64 kCheckpointInterval = 1024;
+// 超长的行（例如压缩后的JSON）按此字节数折行，保证单行渲染开销有上限
+constexpr qint64 kMaxLineBytes = 1024;
+// 检查点按批提交，减少后台线程和界面线程的锁竞争
+constexpr int kCheckpointBatch = 4096;
+
+// 从offset开始的下一行起始位置：遇到换行符或达到折行长度为止
+qint64 nextLineStartIn(const char *data, qint64 size, qint64 offset)
+{
+    if (offset >= size) {
+        return size;
+    }
+    const qint64 span = qMin(kMaxLineBytes, size - offset);
+    const void *newline = std::memchr(data + offset, '\n', static_cast<size_t>(span));
+    if (newline) {
+        return static_cast<const char *>(newline) - data + 1;
+    }
+    qint64 end = offset + span;
+    if (end < size) {
+        // 不在UTF-8多字节字符中间折行
+        qint64 back = end;
+        while (back > offset + span - 4 && (static_cast<uchar>(data[back]) & 0xC0) == 0x80) {
+            --back;
+        }
+        if ((static_cast<uchar>(data[back]) & 0xC0) != 0x80 && back > offset) {
+            end = back;
+        }
+    }
+    return end;
+}
+} // namespace
+
+ResponseView::ResponseView(QWidget *parent)
+    : QAbstractScrollArea(parent)
+{
+    QFont font("Consolas", 9);
+    font.setStyleHint(QFont::Monospace);
+    setFont(font);
+
+    indexTimer_ = new QTimer(this);
+    indexTimer_->setInterval(100);
+    connect(indexTimer_, &QTimer::timeout, this, [this]() {
+        bool complete;
+        {
+            QMutexLocker locker(&indexMutex_);
+            complete = indexComplete_;
+        }
+        updateScrollBars();
+        viewport()->update();
+        if (complete) {
+            indexTimer_->stop();
+        }
+    });
+}
+
+ResponseView::~ResponseView()
+{
+    stopIndexing();
+}
+
+void ResponseView::setResponse(const QSharedPointer<ResponseData> &response)
+{
+    ScopedSpan span("ResponseView::setResponse");
+    stopIndexing();
+    response_ = response;
+    verticalScrollBar()->setValue(0);
+    horizontalScrollBar()->setValue(0);
+    if (mode_ == TextMode) {
+        startIndexing();
+    }
+    updateScrollBars();
+    viewport()->update();
+}
+
+void ResponseView::setMode(Mode mode)
+{
+    if (mode_ == mode) {
+        return;
+    }
+    mode_ = mode;
+    verticalScrollBar()->setValue(0);
+    if (mode_ == TextMode) {
+        bool indexed;
+        {
+            QMutexLocker locker(&indexMutex_);
+            indexed = indexComplete_ || indexFuture_.isRunning();
+        }
+        if (!indexed) {
+            startIndexing();
+        }
+    }
+    updateScrollBars();
+    viewport()->update();
+}
+
+void ResponseView::clear()
+{
+    setResponse(QSharedPointer<ResponseData>());
+}
+
+void ResponseView::startIndexing()
+{
+    {
+        QMutexLocker locker(&indexMutex_);
+        checkpoints_.clear();
+        indexedLines_ = 0;
+        indexComplete_ = false;
+    }
+    if (!response_ || response_->size() == 0) {
+        QMutexLocker locker(&indexMutex_);
+        indexComplete_ = true;
+        return;
+    }
+
+    cancelIndex_.store(false);
+    // 持有响应的强引用，保证映射在索引期间有效
+    QSharedPointer<ResponseData> response = response_;
+    indexFuture_ = QtConcurrent::run([this, response]() {
+        const char *data = response->data();
+        const qint64 size = response->size();
+        QList<qint64> batch;
+        batch.reserve(kCheckpointBatch);
+        qint64 offset = 0;
+        qint64 line = 0;
+
+        while (offset < size) {
+            if (line % kCheckpointInterval == 0) {
+                batch.append(offset);
+                if (batch.size() == kCheckpointBatch) {
+                    if (cancelIndex_.load(std::memory_order_relaxed)) {
+                        return;
+                    }
+                    QMutexLocker locker(&indexMutex_);
+                    checkpoints_.append(batch);
+                    indexedLines_ = line - (line % kCheckpointInterval);
+                    batch.clear();
+                }
+            }
+            offset = nextLineStartIn(data, size, offset);
+            ++line;
+        }
+
+        QMutexLocker locker(&indexMutex_);
+        checkpoints_.append(batch);
+        indexedLines_ = line;
+        indexComplete_ = true;
+    });
+    indexTimer_->start();
+}
+
+void ResponseView::stopIndexing()
+{
+    cancelIndex_.store(true);
+    indexFuture_.waitForFinished();
+    indexTimer_->stop();
+}
+
+qint64 ResponseView::lineCount() const
+{
+    if (!response_) {
+        return 0;
+    }
+    if (mode_ == HexMode) {
+        return (response_->size() + HexDump::kBytesPerRow - 1) / HexDump::kBytesPerRow;
+    }
+    QMutexLocker locker(&indexMutex_);
+    return indexedLines_;
+}
+
+qint64 ResponseView::lineOffset(qint64 line) const
+{
+    qint64 offset = 0;
+    qint64 remaining = line;
+    {
+        QMutexLocker locker(&indexMutex_);
+        if (!checkpoints_.isEmpty()) {
+            const qint64 checkpoint = qMin<qint64>(line / kCheckpointInterval, checkpoints_.size() - 1);
+            offset = checkpoints_.at(checkpoint);
+            remaining = line - checkpoint * kCheckpointInterval;
+        }
+    }
+    while (remaining-- > 0 && offset < response_->size()) {
+        offset = nextLineStart(offset);
+    }
+    return offset;
+}
+
+qint64 ResponseView::nextLineStart(qint64 offset) const
+{
+    return nextLineStartIn(response_->data(), response_->size(), offset);
+}
+
+QString ResponseView::textLine(qint64 start, qint64 end) const
+{
+    const char *data = response_->data();
+    while (end > start && (data[end - 1] == '\n' || data[end - 1] == '\r')) {
+        --end;
+    }
+    QString text = QString::fromUtf8(data + start, static_cast<qsizetype>(end - start));
+    text.replace(QLatin1Char('\t'), QLatin1String("    "));
+    return text;
+}
+
+void ResponseView::updateScrollBars()
+{
+    const QFontMetrics metrics(font());
+    const int visibleRows = qMax(1, viewport()->height() / metrics.lineSpacing());
+    const qint64 rows = lineCount();
+    // 滚动条只支持int范围，超过约20亿行的部分无法定位，这对查看器而言足够
+    verticalScrollBar()->setRange(0, static_cast<int>(qMin<qint64>(qMax<qint64>(0, rows - visibleRows), INT_MAX)));
+    verticalScrollBar()->setPageStep(visibleRows);
+    verticalScrollBar()->setSingleStep(1);
+
+    const int columns = mode_ == HexMode ? HexDump::kRowLength + 2 : static_cast<int>(kMaxLineBytes);
+    const int contentWidth = columns * metrics.horizontalAdvance(QLatin1Char('0'));
+    horizontalScrollBar()->setRange(0, qMax(0, contentWidth - viewport()->width()));
+    horizontalScrollBar()->setPageStep(viewport()->width());
+}
+
+void ResponseView::paintEvent(QPaintEvent *)
+{
+    ScopedSpan span("ResponseView::paintEvent");
+    QPainter painter(viewport());
+    painter.fillRect(viewport()->rect(), palette().base());
+    if (!response_) {
+        return;
+    }
+    if (response_->data() == nullptr && response_->size() == 0 && !response_->errorString().isEmpty()) {
+        painter.drawText(viewport()->rect().adjusted(4, 4, -4, -4), Qt::AlignLeft | Qt::AlignTop,
+                         tr("无法映射响应文件：%1").arg(response_->errorString()));
+        return;
+    }
+
+    painter.setPen(palette().text().color());
+    const QFontMetrics metrics(font());
+    const int lineHeight = metrics.lineSpacing();
+    const int rows = viewport()->height() / lineHeight + 1;
+    const int x = 4 - horizontalScrollBar()->value();
+    const qint64 first = verticalScrollBar()->value();
+    int y = metrics.ascent();
+
+    if (mode_ == HexMode) {
+        // 可见页一次格式化完成，再逐行绘制
+        const int stride = HexDump::kRowLength + 1;
+        hexPage_.resize(rows * stride);
+        const qint64 written = HexDump::formatRows(reinterpret_cast<const uchar *>(response_->data()),
+                                                   response_->size(), first, rows, hexPage_.data());
+        for (qint64 pos = 0; pos < written; pos += stride, y += lineHeight) {
+            painter.drawText(x, y, QString::fromLatin1(hexPage_.constData() + pos, HexDump::kRowLength));
+        }
+        return;
+    }
+
+    qint64 start = lineOffset(first);
+    for (int row = 0; row < rows && start < response_->size(); ++row, y += lineHeight) {
+        const qint64 end = nextLineStart(start);
+        painter.drawText(x, y, textLine(start, end));
+        start = end;
+    }
+}
+
+void ResponseView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+void ResponseView::scrollContentsBy(int, int)
+{
+    viewport()->update();
+}
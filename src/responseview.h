@@ -0,0 +1,55 @@
+#ifndef RESPONSEVIEW_H
+#define RESPONSEVIEW_H
+
+#include <QAbstractScrollArea>
+#include <QFuture>
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QTimer>
+#include <atomic>
+#include "responsedata.h"
+
+// 虚拟化的响应查看器：只绘制可见的几十行，数据直接从内存映射中读取
+// 文本模式用稀疏行索引（每1024行一个检查点）定位，几GB的响应也只占很少的堆内存
+class ResponseView : public QAbstractScrollArea
+{
+    Q_OBJECT
+public:
+    enum Mode { TextMode, HexMode };
+
+    explicit ResponseView(QWidget *parent = nullptr);
+    ~ResponseView() override;
+
+    void setResponse(const QSharedPointer<ResponseData> &response);
+    void setMode(Mode mode);
+    void clear();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+
+private:
+    void updateScrollBars();
+    void startIndexing();
+    void stopIndexing();
+    qint64 lineCount() const;
+    qint64 lineOffset(qint64 line) const;
+    qint64 nextLineStart(qint64 offset) const;
+    QString textLine(qint64 start, qint64 end) const;
+
+    QSharedPointer<ResponseData> response_;
+    Mode mode_ { TextMode };
+    QByteArray hexPage_;
+
+    mutable QMutex indexMutex_;
+    QList<qint64> checkpoints_;
+    qint64 indexedLines_ { 0 };
+    bool indexComplete_ { false };
+    std::atomic<bool> cancelIndex_ { false };
+    QFuture<void> indexFuture_;
+    QTimer *indexTimer_ { nullptr };
+};
+
+#endif // RESPONSEVIEW_H
@@ -0,0 +1,132 @@
+#include "rttchartwidget.h"
+#include <QFontMetrics>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QPolygonF>
+#include <cmath>
+
+namespace {
+// 1秒间隔时约保留最近5分钟
+constexpr int kMaxPoints = 300;
+constexpr int kGridLines = 4;
+const QColor kRttColor(0x1f, 0x77, 0xb4);
+const QColor kJitterColor(0xff, 0x7f, 0x0e);
+const QColor kLostColor(0xd6, 0x27, 0x28);
+const QColor kGridColor(0xd0, 0xd0, 0xd0);
+}
+
+RttChartWidget::RttChartWidget(QWidget *parent)
+    : QWidget(parent)
+{
+    setMinimumSize(320, 160);
+}
+
+QSize RttChartWidget::sizeHint() const
+{
+    return QSize(640, 260);
+}
+
+void RttChartWidget::addSample(double rttMs, double jitterMs)
+{
+    points_.append({ rttMs, jitterMs });
+    if (points_.size() > kMaxPoints) {
+        points_.removeFirst();
+    }
+    update();
+}
+
+void RttChartWidget::clear()
+{
+    points_.clear();
+    update();
+}
+
+double RttChartWidget::niceStep(double value)
+{
+    const double magnitude = std::pow(10.0, std::floor(std::log10(value)));
+    for (double factor : { 1.0, 2.0, 5.0 }) {
+        if (factor * magnitude >= value) {
+            return factor * magnitude;
+        }
+    }
+    return 10.0 * magnitude;
+}
+
+void RttChartWidget::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().base());
+
+    const QFontMetrics metrics(font());
+    const QRect plot = rect().adjusted(metrics.horizontalAdvance("00000 ms") + 8, metrics.height() + 8,
+                                       -8, -(metrics.height() + 6));
+    if (plot.width() <= 0 || plot.height() <= 0) {
+        return;
+    }
+
+    double peakMs = 1.0;
+    for (const Point &point : points_) {
+        peakMs = qMax(peakMs, qMax(point.rttMs, point.jitterMs));
+    }
+    const double stepMs = niceStep(peakMs / kGridLines);
+    const double topMs = stepMs * std::ceil(peakMs / stepMs);
+
+    // 刻度和网格
+    for (int i = 0; i * stepMs <= topMs + stepMs / 2; ++i) {
+        const int y = plot.bottom() - static_cast<int>(i * stepMs / topMs * plot.height());
+        painter.setPen(kGridColor);
+        painter.drawLine(plot.left(), y, plot.right(), y);
+        painter.setPen(palette().color(QPalette::Text));
+        painter.drawText(QRect(0, y - metrics.height() / 2, plot.left() - 4, metrics.height()),
+                         Qt::AlignRight | Qt::AlignVCenter, QString("%1 ms").arg(i * stepMs, 0, 'g', 4));
+    }
+    painter.drawText(QRect(plot.left(), plot.bottom() + 4, plot.width(), metrics.height()),
+                     Qt::AlignRight | Qt::AlignVCenter, QString("最近 %1 个样本").arg(points_.size()));
+
+    // 图例
+    int legendX = plot.left();
+    const auto legend = [&](const QColor &color, const QString &text) {
+        painter.fillRect(QRect(legendX, 4 + metrics.height() / 2 - 2, 12, 4), color);
+        painter.setPen(palette().color(QPalette::Text));
+        painter.drawText(legendX + 16, 4 + metrics.ascent(), text);
+        legendX += 16 + metrics.horizontalAdvance(text) + 16;
+    };
+    legend(kRttColor, "RTT");
+    legend(kJitterColor, "抖动");
+    legend(kLostColor, "丢失");
+
+    if (points_.isEmpty()) {
+        return;
+    }
+
+    const double dx = static_cast<double>(plot.width()) / (kMaxPoints - 1);
+    const auto xAt = [&](qsizetype index) {
+        return plot.right() - (points_.size() - 1 - index) * dx;
+    };
+    const auto yAt = [&](double ms) {
+        return plot.bottom() - ms / topMs * plot.height();
+    };
+
+    painter.setRenderHint(QPainter::Antialiasing);
+    QPolygonF rttLine;
+    QPolygonF jitterLine;
+    for (qsizetype i = 0; i < points_.size(); ++i) {
+        const Point &point = points_.at(i);
+        jitterLine << QPointF(xAt(i), yAt(point.jitterMs));
+        if (point.rttMs < 0) {
+            // 丢包处把RTT折线断开
+            painter.setPen(QPen(kRttColor, 1.5));
+            painter.drawPolyline(rttLine);
+            rttLine.clear();
+            const int x = static_cast<int>(xAt(i));
+            painter.setPen(kLostColor);
+            painter.drawLine(x, plot.top(), x, plot.bottom());
+            continue;
+        }
+        rttLine << QPointF(xAt(i), yAt(point.rttMs));
+    }
+    painter.setPen(QPen(kRttColor, 1.5));
+    painter.drawPolyline(rttLine);
+    painter.setPen(QPen(kJitterColor, 1));
+    painter.drawPolyline(jitterLine);
+}
@@ -0,0 +1,36 @@
+#ifndef RTTCHARTWIDGET_H
+#define RTTCHARTWIDGET_H
+
+#include <QWidget>
+#include <QList>
+
+// 滚动折线图：最新样本在最右侧，纵轴按可见样本的最大RTT自动取整刻度
+class RttChartWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit RttChartWidget(QWidget *parent = nullptr);
+
+    // rttMs小于0表示丢失，画成贯穿绘图区的红线
+    void addSample(double rttMs, double jitterMs);
+    void clear();
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    struct Point
+    {
+        double rttMs;
+        double jitterMs;
+    };
+
+    // 取不小于value的1/2/5×10^n刻度
+    static double niceStep(double value);
+
+    QList<Point> points_;
+};
+
+#endif // RTTCHARTWIDGET_H
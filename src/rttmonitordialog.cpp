@@ -0,0 +1,158 @@
+#include "rttmonitordialog.h"
+#include <QCloseEvent>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <cmath>
+
+RttMonitorDialog::RttMonitorDialog(QWidget *parent)
+    : QDialog(parent)
+    , monitor(new TunnelRttMonitor(this))
+{
+    setWindowTitle("隧道RTT监视");
+
+    urlEdit = new QLineEdit(this);
+    urlEdit->setPlaceholderText("ws:// 或 wss:// 地址，服务器需响应ping");
+    intervalSpin = new QSpinBox(this);
+    intervalSpin->setRange(100, 60000);
+    intervalSpin->setValue(1000);
+    intervalSpin->setSuffix(" ms");
+    startButton = new QPushButton("开始", this);
+
+    QHBoxLayout *targetLayout = new QHBoxLayout();
+    targetLayout->addWidget(new QLabel("地址:", this));
+    targetLayout->addWidget(urlEdit, 1);
+    targetLayout->addWidget(new QLabel("间隔:", this));
+    targetLayout->addWidget(intervalSpin);
+    targetLayout->addWidget(startButton);
+
+    statusLabel = new QLabel("未开始", this);
+    statsLabel = new QLabel(this);
+    chart = new RttChartWidget(this);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addLayout(targetLayout);
+    layout->addWidget(statusLabel);
+    layout->addWidget(statsLabel);
+    layout->addWidget(chart, 1);
+
+    connect(startButton, &QPushButton::clicked, this, &RttMonitorDialog::toggleMonitor);
+    connect(monitor, &TunnelRttMonitor::connected, this, &RttMonitorDialog::onConnected);
+    connect(monitor, &TunnelRttMonitor::sampled, this, &RttMonitorDialog::onSampled);
+    connect(monitor, &TunnelRttMonitor::stopped, this, &RttMonitorDialog::onStopped);
+
+    resetStats();
+}
+
+void RttMonitorDialog::setTarget(const ProxyOptions &proxy, const QString &url)
+{
+    proxy_ = proxy;
+    if (!monitor->isRunning()) {
+        urlEdit->setText(url);
+    }
+}
+
+void RttMonitorDialog::closeEvent(QCloseEvent *event)
+{
+    // 不等待监视线程退出，界面在stopped到达时复位
+    if (monitor->isRunning()) {
+        monitor->stop();
+        startButton->setEnabled(false);
+        statusLabel->setText("正在停止...");
+    }
+    QDialog::closeEvent(event);
+}
+
+void RttMonitorDialog::toggleMonitor()
+{
+    if (monitor->isRunning()) {
+        monitor->stop();
+        startButton->setEnabled(false);
+        statusLabel->setText("正在停止...");
+        return;
+    }
+
+    const QString url = urlEdit->text().trimmed();
+    if (!url.startsWith("ws://") && !url.startsWith("wss://")) {
+        statusLabel->setText("地址必须以 ws:// 或 wss:// 开头");
+        return;
+    }
+
+    TunnelRttMonitor::Config config;
+    config.proxy = proxy_;
+    config.url = url;
+    config.intervalMs = intervalSpin->value();
+    // 超时不超过间隔的3倍，也不少于1秒
+    config.timeoutMs = qBound(1000, config.intervalMs * 3, 10000);
+
+    resetStats();
+    chart->clear();
+    startButton->setText("停止");
+    urlEdit->setEnabled(false);
+    intervalSpin->setEnabled(false);
+    statusLabel->setText("正在建立隧道...");
+    monitor->start(config);
+}
+
+void RttMonitorDialog::onConnected(qint64 handshakeMs)
+{
+    statusLabel->setText(QString("已连接，握手（隧道+TLS+升级）耗时 %1 ms，之后的样本不含握手").arg(handshakeMs));
+}
+
+void RttMonitorDialog::onSampled(quint64 sequence, double rttMs)
+{
+    Q_UNUSED(sequence);
+    if (rttMs < 0) {
+        ++lost_;
+    } else {
+        if (received_ == 0) {
+            minMs_ = maxMs_ = rttMs;
+        } else {
+            minMs_ = qMin(minMs_, rttMs);
+            maxMs_ = qMax(maxMs_, rttMs);
+        }
+        if (lastMs_ >= 0) {
+            jitterMs_ += (std::abs(rttMs - lastMs_) - jitterMs_) / 16.0;
+        }
+        ++received_;
+        sumMs_ += rttMs;
+        lastMs_ = rttMs;
+    }
+    chart->addSample(rttMs, jitterMs_);
+    updateStats();
+}
+
+void RttMonitorDialog::onStopped(const QString &reason)
+{
+    startButton->setText("开始");
+    startButton->setEnabled(true);
+    urlEdit->setEnabled(true);
+    intervalSpin->setEnabled(true);
+    statusLabel->setText(reason.isEmpty() ? QString("已停止") : "已停止: " + reason);
+}
+
+void RttMonitorDialog::resetStats()
+{
+    received_ = 0;
+    lost_ = 0;
+    lastMs_ = -1;
+    minMs_ = 0;
+    maxMs_ = 0;
+    sumMs_ = 0;
+    jitterMs_ = 0;
+    updateStats();
+}
+
+void RttMonitorDialog::updateStats()
+{
+    const quint64 total = received_ + lost_;
+    const double avgMs = received_ > 0 ? sumMs_ / received_ : 0;
+    statsLabel->setText(QString("样本 %1，丢失 %2 (%3%)；当前 %4 ms，最小 %5 / 平均 %6 / 最大 %7 ms，抖动 %8 ms")
+                            .arg(total)
+                            .arg(lost_)
+                            .arg(total > 0 ? 100.0 * lost_ / total : 0.0, 0, 'f', 1)
+                            .arg(qMax(lastMs_, 0.0), 0, 'f', 2)
+                            .arg(minMs_, 0, 'f', 2)
+                            .arg(avgMs, 0, 'f', 2)
+                            .arg(maxMs_, 0, 'f', 2)
+                            .arg(jitterMs_, 0, 'f', 2));
+}
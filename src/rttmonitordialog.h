@@ -0,0 +1,55 @@
+#ifndef RTTMONITORDIALOG_H
+#define RTTMONITORDIALOG_H
+
+#include <QDialog>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QSpinBox>
+#include "rttchartwidget.h"
+#include "tunnelrttmonitor.h"
+
+// 隧道RTT监视窗口：非模态，关闭窗口即停止监视
+class RttMonitorDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit RttMonitorDialog(QWidget *parent = nullptr);
+
+    // 打开窗口前由主窗口填入当前代理设置和默认地址
+    void setTarget(const ProxyOptions &proxy, const QString &url);
+
+protected:
+    void closeEvent(QCloseEvent *event) override;
+
+private slots:
+    void toggleMonitor();
+    void onConnected(qint64 handshakeMs);
+    void onSampled(quint64 sequence, double rttMs);
+    void onStopped(const QString &reason);
+
+private:
+    void resetStats();
+    void updateStats();
+
+    QLineEdit *urlEdit;
+    QSpinBox *intervalSpin;
+    QPushButton *startButton;
+    QLabel *statusLabel;
+    QLabel *statsLabel;
+    RttChartWidget *chart;
+
+    TunnelRttMonitor *monitor;
+    ProxyOptions proxy_;
+
+    // 统计只覆盖本次监视；抖动按RFC 3550的平滑算法J += (|D| - J) / 16
+    quint64 received_ { 0 };
+    quint64 lost_ { 0 };
+    double lastMs_ { -1 };
+    double minMs_ { 0 };
+    double maxMs_ { 0 };
+    double sumMs_ { 0 };
+    double jitterMs_ { 0 };
+};
+
+#endif // RTTMONITORDIALOG_H
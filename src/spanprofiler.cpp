@@ -0,0 +1,245 @@
+#include "spanprofiler.h"
+#include "transfertracer.h"
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStringList>
+#include <QThread>
+#include <atomic>
+
+namespace {
+// 每个线程缓冲区的容量（代码段数），满了以后覆盖最早的
+constexpr quint64 kSpansPerThread = 16 * 1024;
+// 同时存活的线程最多占用这么多缓冲区；线程退出后缓冲区交给新线程继续用
+constexpr int kMaxBuffers = 64;
+// trace event JSON中代码段所在的进程号，传输时间线是1
+constexpr int kSpanPid = 2;
+
+// 字段都是原子量：导出时可能与所属线程的写入同时发生，靠written判断哪些记录是完整的
+struct SpanRecord
+{
+    std::atomic<const char *> name { nullptr };
+    std::atomic<qint64> beginNs { 0 };
+    std::atomic<qint64> endNs { 0 };
+    std::atomic<int> thread { 0 };
+};
+
+// 导出时从缓冲区复制出来的一条记录
+struct SpanSnapshot
+{
+    const char *name;
+    qint64 beginNs;
+    qint64 endNs;
+    int thread;
+};
+
+// 单写者环形缓冲区：只有占用它的线程写入，written是已写入的总条数
+struct ThreadBuffer
+{
+    SpanRecord records[kSpansPerThread];
+    std::atomic<quint64> written { 0 };
+    // clear()时记下当时的written，导出时跳过之前的记录
+    std::atomic<quint64> clearedAt { 0 };
+    std::atomic<bool> inUse { false };
+};
+
+std::atomic<bool> g_enabled { false };
+// 拿不到缓冲区（同时存活的线程过多）而丢弃的代码段
+std::atomic<qint64> g_dropped { 0 };
+
+// 以下只在线程第一次记录时和导出时访问，用互斥锁保护
+QMutex g_mutex;
+ThreadBuffer *g_buffers[kMaxBuffers] = {};
+int g_bufferCount = 0;
+QStringList g_threadNames;
+
+// 线程退出时把缓冲区标记为空闲；已写入的记录保留到导出
+struct ThreadSlot
+{
+    ThreadBuffer *buffer { nullptr };
+    int thread { 0 };
+    bool unavailable { false };
+
+    ~ThreadSlot()
+    {
+        if (buffer) {
+            buffer->inUse.store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadSlot t_slot;
+
+QString currentThreadName(int index)
+{
+    QThread *thread = QThread::currentThread();
+    if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread()) {
+        return "界面线程";
+    }
+    const QString name = thread ? thread->objectName() : QString();
+    return name.isEmpty() ? QString("线程 %1").arg(index) : QString("%1 (%2)").arg(name).arg(index);
+}
+
+bool attachBuffer(ThreadSlot &slot)
+{
+    QMutexLocker locker(&g_mutex);
+    ThreadBuffer *buffer = nullptr;
+    for (int i = 0; i < g_bufferCount && !buffer; ++i) {
+        if (!g_buffers[i]->inUse.load(std::memory_order_acquire)) {
+            buffer = g_buffers[i];
+        }
+    }
+    if (!buffer) {
+        if (g_bufferCount == kMaxBuffers) {
+            slot.unavailable = true;
+            return false;
+        }
+        // 缓冲区在进程生命周期内不释放，线程退出后由新线程复用
+        buffer = new ThreadBuffer;
+        g_buffers[g_bufferCount++] = buffer;
+    }
+    buffer->inUse.store(true, std::memory_order_relaxed);
+    slot.buffer = buffer;
+    slot.thread = static_cast<int>(g_threadNames.size()) + 1;
+    g_threadNames.append(currentThreadName(slot.thread));
+    return true;
+}
+
+QJsonObject spanTraceEvent(const QString &name, const char *phase, qint64 nsecs, int tid)
+{
+    QJsonObject event;
+    event.insert("name", name);
+    event.insert("cat", "span");
+    event.insert("ph", phase);
+    event.insert("ts", nsecs / 1000.0);
+    event.insert("pid", kSpanPid);
+    event.insert("tid", tid);
+    return event;
+}
+}
+
+void SpanProfiler::setEnabled(bool enabled)
+{
+    g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool SpanProfiler::isEnabled()
+{
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+void SpanProfiler::record(const char *name, qint64 beginNs, qint64 endNs)
+{
+    ThreadSlot &slot = t_slot;
+    if (!slot.buffer && (slot.unavailable || !attachBuffer(slot))) {
+        g_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ThreadBuffer *buffer = slot.buffer;
+    const quint64 index = buffer->written.load(std::memory_order_relaxed);
+    SpanRecord &record = buffer->records[index % kSpansPerThread];
+    // 与导出时第二次读取written前的acquire栅栏配对：导出线程读到下面任何一个字段的新值，
+    // 就一定能读到written >= index，从而丢掉正被覆盖的那条记录
+    std::atomic_thread_fence(std::memory_order_release);
+    record.name.store(name, std::memory_order_relaxed);
+    record.beginNs.store(beginNs, std::memory_order_relaxed);
+    record.endNs.store(endNs, std::memory_order_relaxed);
+    record.thread.store(slot.thread, std::memory_order_relaxed);
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+void SpanProfiler::clear()
+{
+    QMutexLocker locker(&g_mutex);
+    for (int i = 0; i < g_bufferCount; ++i) {
+        g_buffers[i]->clearedAt.store(g_buffers[i]->written.load(std::memory_order_acquire),
+                                      std::memory_order_relaxed);
+    }
+    g_dropped.store(0, std::memory_order_relaxed);
+}
+
+qint64 SpanProfiler::spanCount()
+{
+    QMutexLocker locker(&g_mutex);
+    qint64 count = 0;
+    for (int i = 0; i < g_bufferCount; ++i) {
+        const quint64 written = g_buffers[i]->written.load(std::memory_order_acquire);
+        const quint64 clearedAt = g_buffers[i]->clearedAt.load(std::memory_order_relaxed);
+        count += static_cast<qint64>(qMin(written - clearedAt, kSpansPerThread));
+    }
+    return count;
+}
+
+bool SpanProfiler::exportChromeTrace(const QString &path, QString *error)
+{
+    QJsonArray events;
+    QJsonObject processName = spanTraceEvent("process_name", "M", 0, 0);
+    processName.insert("args", QJsonObject { { "name", "应用" } });
+    events.append(processName);
+
+    QMutexLocker locker(&g_mutex);
+    for (int i = 0; i < g_threadNames.size(); ++i) {
+        QJsonObject threadName = spanTraceEvent("thread_name", "M", 0, i + 1);
+        threadName.insert("args", QJsonObject { { "name", g_threadNames.at(i) } });
+        events.append(threadName);
+    }
+
+    for (int i = 0; i < g_bufferCount; ++i) {
+        ThreadBuffer *buffer = g_buffers[i];
+        const quint64 written = buffer->written.load(std::memory_order_acquire);
+        const quint64 clearedAt = buffer->clearedAt.load(std::memory_order_relaxed);
+        quint64 first = qMax(clearedAt, written > kSpansPerThread ? written - kSpansPerThread : 0);
+        QList<SpanSnapshot> spans;
+        spans.reserve(static_cast<qsizetype>(written - first));
+        for (quint64 index = first; index < written; ++index) {
+            const SpanRecord &record = buffer->records[index % kSpansPerThread];
+            spans.append({ record.name.load(std::memory_order_relaxed),
+                           record.beginNs.load(std::memory_order_relaxed),
+                           record.endNs.load(std::memory_order_relaxed),
+                           record.thread.load(std::memory_order_relaxed) });
+        }
+
+        // 复制期间所属线程可能继续写入并覆盖了最早的几条，这些记录可能是新旧混合的，丢掉。
+        // 栅栏保证上面复制时读到的覆盖写入，在这次读取的written中一定已经计入
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const quint64 after = buffer->written.load(std::memory_order_acquire);
+        const quint64 stableFrom = after >= kSpansPerThread ? after - kSpansPerThread + 1 : 0;
+        const qsizetype skip = stableFrom > first ? static_cast<qsizetype>(stableFrom - first) : 0;
+        for (qsizetype k = skip; k < spans.size(); ++k) {
+            const SpanSnapshot &span = spans.at(k);
+            QJsonObject event = spanTraceEvent(QString::fromUtf8(span.name), "X", span.beginNs, span.thread);
+            event.insert("dur", qMax<qint64>(0, span.endNs - span.beginNs) / 1000.0);
+            events.append(event);
+        }
+    }
+    const qint64 dropped = g_dropped.load(std::memory_order_relaxed);
+    locker.unlock();
+
+    if (dropped > 0) {
+        QJsonObject note = spanTraceEvent("丢弃的代码段", "i", TransferTracer::nowNs(), 0);
+        note.insert("s", "g");
+        note.insert("args", QJsonObject { { "count", dropped } });
+        events.append(note);
+    }
+
+    for (const QJsonValue &event : TransferTracer::chromeTraceEvents()) {
+        events.append(event);
+    }
+    return TransferTracer::writeChromeTrace(path, events, error);
+}
+
+ScopedSpan::ScopedSpan(const char *name)
+    : name_(name)
+    , beginNs_(SpanProfiler::isEnabled() ? TransferTracer::nowNs() : -1)
+{
+}
+
+ScopedSpan::~ScopedSpan()
+{
+    if (beginNs_ >= 0) {
+        SpanProfiler::record(name_, beginNs_, TransferTracer::nowNs());
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef SPANPROFILER_H
+#define SPANPROFILER_H
+
+#include <QString>
+
+// 应用内的耗时剖析：界面槽函数、ProxyClient回调、结果格式化、配置读写和curl回调用ScopedSpan标出，
+// 开启后写入各线程自己的环形缓冲区（写入不加锁，缓冲区满时覆盖最早的记录），
+// 导出时与TransferTracer的传输时间线合并成同一个trace event JSON，
+// 可以在同一时间轴上看出时间花在网络、界面还是自己的格式化代码上
+class SpanProfiler
+{
+public:
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    // name必须是字符串字面量等静态存储的字符串，记录时只保存指针
+    static void record(const char *name, qint64 beginNs, qint64 endNs);
+    // 丢弃已记录的代码段；可与记录并发调用
+    static void clear();
+    static qint64 spanCount();
+
+    static bool exportChromeTrace(const QString &path, QString *error = nullptr);
+};
+
+// 作用域内的一段代码，析构时记录；未开启剖析时只读一次开关
+class ScopedSpan
+{
+public:
+    explicit ScopedSpan(const char *name);
+    ~ScopedSpan();
+    ScopedSpan(const ScopedSpan &) = delete;
+    ScopedSpan &operator=(const ScopedSpan &) = delete;
+
+private:
+    const char *name_;
+    qint64 beginNs_;
+};
+
+#endif // SPANPROFILER_H
@@ -0,0 +1,63 @@
+#include "startupprofiler.h"
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
+namespace {
+struct StartupMark
+{
+    QString name;
+    qint64  nsecs;
+    bool    mainThread;
+};
+
+QElapsedTimer g_clock;
+QThread *g_mainThread = nullptr;
+QMutex g_mutex;
+QList<StartupMark> g_marks;
+bool g_finished = false;
+}
+
+void StartupProfiler::start()
+{
+    g_clock.start();
+    g_mainThread = QThread::currentThread();
+    g_marks.append({ QString("进入main"), 0, true });
+}
+
+void StartupProfiler::mark(const QString &name)
+{
+    if (!g_clock.isValid()) {
+        return;
+    }
+    const qint64 nsecs = g_clock.nsecsElapsed();
+    QMutexLocker locker(&g_mutex);
+    if (!g_finished) {
+        g_marks.append({ name, nsecs, QThread::currentThread() == g_mainThread });
+    }
+}
+
+QString StartupProfiler::report()
+{
+    QMutexLocker locker(&g_mutex);
+    g_finished = true;
+
+    QString text = "=== 启动耗时 (ms) ===\n";
+    qint64 previousUiMark = 0;
+    for (const StartupMark &m : g_marks) {
+        // 界面线程的阶段按先后相减得到各段耗时，后台线程的阶段只显示完成时刻
+        const QString delta = m.mainThread
+            ? QString("+%1").arg((m.nsecs - previousUiMark) / 1e6, 0, 'f', 1)
+            : QString("后台");
+        text += QString("%1  %2  %3\n")
+                    .arg(m.nsecs / 1e6, 8, 'f', 1)
+                    .arg(delta, 8)
+                    .arg(m.name);
+        if (m.mainThread) {
+            previousUiMark = m.nsecs;
+        }
+    }
+    return text;
+}
@@ -0,0 +1,18 @@
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+#include <QString>
+
+// 记录启动过程中各阶段相对进入main的耗时，--startup-profile时打印
+class StartupProfiler
+{
+public:
+    // 在main第一行调用，作为时间零点
+    static void start();
+    // 记录一个阶段完成，可在任意线程调用；报告生成后不再记录
+    static void mark(const QString &name);
+    // 生成报告并结束记录
+    static QString report();
+};
+
+#endif // STARTUPPROFILER_H
@@ -0,0 +1,255 @@
+#include "throughputtester.h"
+#include "curlruntime.h"
+#include <QElapsedTimer>
+#include <QMetaObject>
+#ifndef _WIN32
+#include <sys/socket.h>
+#endif
+
+namespace {
+// 追加模式下QByteArray的最大长度，超过后释放重来，模拟接收路径的重分配开销又不占满内存
+const qint64 kAppendSinkLimit = 256LL * 1024 * 1024;
+
+// 写入回调在工作线程上读时钟，靠局部静态变量的线程安全初始化启动计时
+const QElapsedTimer &monotonicClock()
+{
+    static const QElapsedTimer clock = [] {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    }();
+    return clock;
+}
+}
+
+QList<long> ThroughputTester::defaultBufferSizes()
+{
+    // 16 KiB是libcurl默认值，10 MiB是CURL_MAX_READ_SIZE上限
+    return { 16L * 1024, 64L * 1024, 256L * 1024, 1024L * 1024, 4L * 1024 * 1024, CURL_MAX_READ_SIZE };
+}
+
+QList<int> ThroughputTester::defaultReceiveBufferSizes()
+{
+    return { 0, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024 };
+}
+
+ThroughputTester::ThroughputTester(QObject *parent)
+    : QObject(parent)
+{
+}
+
+ThroughputTester::~ThroughputTester()
+{
+    cancel_ = true;
+    if (worker_) {
+        worker_->wait();
+    }
+}
+
+void ThroughputTester::start(const Config &config)
+{
+    if (running_) {
+        return;
+    }
+
+    running_ = true;
+    cancel_ = false;
+
+    QThread *thread = QThread::create([this, config]() { runAll(config); });
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    worker_ = thread;
+    thread->start();
+}
+
+void ThroughputTester::cancel()
+{
+    cancel_ = true;
+}
+
+void ThroughputTester::post(const QString &message)
+{
+    QMetaObject::invokeMethod(this, [this, message]() { emit sample(message); }, Qt::QueuedConnection);
+}
+
+size_t ThroughputTester::writeCallback(char *ptr, size_t size, size_t nmemb, void *userdata)
+{
+    RunState *state = static_cast<RunState *>(userdata);
+    const size_t bytes = size * nmemb;
+    if (state->appendSink) {
+        // 与ProxyClient相同的接收方式：每个数据块一次append
+        if (state->sink.size() + static_cast<qint64>(bytes) > kAppendSinkLimit) {
+            state->sink.clear();
+        }
+        state->sink.append(ptr, static_cast<qsizetype>(bytes));
+    }
+    return bytes;
+}
+
+int ThroughputTester::xferInfoCallback(void *clientp, curl_off_t, curl_off_t dlnow,
+                                       curl_off_t, curl_off_t)
+{
+    RunState *state = static_cast<RunState *>(clientp);
+    if (state->self->cancel_) {
+        return 1;
+    }
+
+    const qint64 now = monotonicClock().elapsed();
+    if (now - state->lastSampleMs >= 1000) {
+        const double seconds = (now - state->lastSampleMs) / 1000.0;
+        const double mbps = (dlnow - state->lastSampleBytes) / seconds / (1024.0 * 1024.0);
+        state->self->post(QString("%1 %2s: %3 MB/s")
+                              .arg(state->label)
+                              .arg((now - state->startMs) / 1000)
+                              .arg(mbps, 0, 'f', 1));
+        state->lastSampleMs = now;
+        state->lastSampleBytes = dlnow;
+    }
+
+    if (now - state->startMs >= state->limitMs) {
+        state->limitReached = true;
+        return 1;
+    }
+    return 0;
+}
+
+int ThroughputTester::sockoptCallback(void *clientp, curl_socket_t fd, curlsocktype purpose)
+{
+    RunState *state = static_cast<RunState *>(clientp);
+    if (purpose == CURLSOCKTYPE_IPCXN && state->receiveBuffer > 0) {
+        const int size = state->receiveBuffer;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char *>(&size), sizeof(size));
+    }
+    return CURL_SOCKOPT_OK;
+}
+
+ThroughputTester::RunResult ThroughputTester::runOnce(const Config &config, long bufferSize,
+                                                      int receiveBuffer, bool appendSink)
+{
+    RunResult result;
+    result.bufferSize = bufferSize;
+    result.receiveBuffer = receiveBuffer;
+
+    CurlRuntime::ensureInitialized();
+    CURL *curl = curl_easy_init();
+    if (!curl) {
+        result.error = tr("初始化curl失败");
+        return result;
+    }
+
+    RunState state;
+    state.self = this;
+    state.appendSink = appendSink;
+    state.receiveBuffer = receiveBuffer;
+    state.limitMs = config.secondsPerRun * 1000LL;
+    state.label = QString("[buffer=%1 rcvbuf=%2%3]")
+                      .arg(formatSize(bufferSize),
+                           receiveBuffer > 0 ? formatSize(receiveBuffer) : QString("默认"),
+                           appendSink ? QString(" append") : QString());
+
+    curl_easy_setopt(curl, CURLOPT_URL, config.url.toUtf8().constData());
+    applyProxyOptions(curl, config.proxy);
+    curl_easy_setopt(curl, CURLOPT_BUFFERSIZE, bufferSize);
+    curl_easy_setopt(curl, CURLOPT_SOCKOPTFUNCTION, &ThroughputTester::sockoptCallback);
+    curl_easy_setopt(curl, CURLOPT_SOCKOPTDATA, &state);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &ThroughputTester::writeCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &state);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, &ThroughputTester::xferInfoCallback);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &state);
+    // 每轮都建立新连接，保证SO_RCVBUF在握手前生效
+    curl_easy_setopt(curl, CURLOPT_FRESH_CONNECT, 1L);
+
+    state.startMs = monotonicClock().elapsed();
+    state.lastSampleMs = state.startMs;
+    const CURLcode res = curl_easy_perform(curl);
+
+    curl_off_t downloaded = 0;
+    curl_off_t totalUs = 0;
+    curl_off_t firstByteUs = 0;
+    curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &downloaded);
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &totalUs);
+    curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &firstByteUs);
+    curl_easy_cleanup(curl);
+
+    if (res != CURLE_OK && !(res == CURLE_ABORTED_BY_CALLBACK && state.limitReached)) {
+        result.error = QString::fromUtf8(curl_easy_strerror(res));
+        return result;
+    }
+
+    // 持续吞吐量只统计首字节之后的时间，排除TCP/TLS/CONNECT建立开销
+    result.bytes = downloaded;
+    const double seconds = (totalUs - firstByteUs) / 1e6;
+    if (seconds > 0) {
+        result.mbps = downloaded / seconds / (1024.0 * 1024.0);
+    }
+    return result;
+}
+
+void ThroughputTester::runAll(const Config &config)
+{
+    QList<RunResult> results;
+    RunResult best;
+
+    for (long bufferSize : config.bufferSizes) {
+        for (int receiveBuffer : config.receiveBufferSizes) {
+            if (cancel_) {
+                break;
+            }
+            const RunResult r = runOnce(config, bufferSize, receiveBuffer, false);
+            results << r;
+            if (r.error.isEmpty() && r.mbps > best.mbps) {
+                best = r;
+            }
+        }
+    }
+
+    QString summary = "=== 吞吐量测试结果 ===\n";
+    for (const RunResult &r : results) {
+        summary += QString("buffer=%1 rcvbuf=%2: ")
+                       .arg(formatSize(r.bufferSize),
+                            r.receiveBuffer > 0 ? formatSize(r.receiveBuffer) : QString("默认"));
+        if (r.error.isEmpty()) {
+            summary += QString("%1 MB/s (%2)\n").arg(r.mbps, 0, 'f', 1).arg(formatSize(r.bytes));
+        } else {
+            summary += "失败: " + r.error + "\n";
+        }
+    }
+
+    if (best.mbps > 0 && !cancel_) {
+        summary += QString("最快设置: buffer=%1 rcvbuf=%2, %3 MB/s\n")
+                       .arg(formatSize(best.bufferSize),
+                            best.receiveBuffer > 0 ? formatSize(best.receiveBuffer) : QString("默认"))
+                       .arg(best.mbps, 0, 'f', 1);
+
+        // 用最快设置再跑一轮逐块append的接收方式，判断瓶颈是否在客户端
+        const RunResult appendRun = runOnce(config, best.bufferSize, best.receiveBuffer, true);
+        if (appendRun.error.isEmpty() && appendRun.mbps > 0) {
+            summary += QString("QByteArray::append接收路径: %1 MB/s (丢弃写入为 %2 MB/s，相差 %3%)\n")
+                           .arg(appendRun.mbps, 0, 'f', 1)
+                           .arg(best.mbps, 0, 'f', 1)
+                           .arg(100.0 * (best.mbps - appendRun.mbps) / best.mbps, 0, 'f', 1);
+        }
+    } else if (cancel_) {
+        summary += "测试已取消\n";
+    }
+
+    QMetaObject::invokeMethod(this, [this, summary]() {
+        running_ = false;
+        worker_ = nullptr;
+        emit testFinished(summary);
+    }, Qt::QueuedConnection);
+}
+
+QString ThroughputTester::formatSize(qint64 bytes)
+{
+    if (bytes >= 1024 * 1024 && bytes % (1024 * 1024) == 0) {
+        return QString("%1 MiB").arg(bytes / (1024 * 1024));
+    }
+    if (bytes >= 1024 && bytes % 1024 == 0) {
+        return QString("%1 KiB").arg(bytes / 1024);
+    }
+    if (bytes >= 1024 * 1024) {
+        return QString("%1 MiB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
+    }
+    return QString("%1 B").arg(bytes);
+}
@@ -0,0 +1,80 @@
+#ifndef THROUGHPUTTESTER_H
+#define THROUGHPUTTESTER_H
+
+#include <QObject>
+#include <QList>
+#include <QPointer>
+#include <QThread>
+#include <atomic>
+#include <curl/curl.h>
+#include "proxyoptions.h"
+
+// 通过代理隧道下载大对象，扫描接收缓冲区设置并统计持续吞吐量
+class ThroughputTester : public QObject
+{
+    Q_OBJECT
+public:
+    struct Config
+    {
+        ProxyOptions proxy;
+        QString url;
+        QList<long> bufferSizes;        // CURLOPT_BUFFERSIZE
+        QList<int>  receiveBufferSizes; // SO_RCVBUF，0表示使用系统默认值
+        int secondsPerRun { 5 };
+    };
+
+    static QList<long> defaultBufferSizes();
+    static QList<int> defaultReceiveBufferSizes();
+
+    explicit ThroughputTester(QObject *parent = nullptr);
+    ~ThroughputTester() override;
+
+    void start(const Config &config);
+    // 只发出停止请求，不等待：工作线程在当前这一轮结束后照常发出testFinished
+    void cancel();
+    bool isRunning() const { return running_; }
+
+signals:
+    void sample(const QString &message);
+    void testFinished(const QString &summary);
+
+private:
+    struct RunResult
+    {
+        long    bufferSize { 0 };
+        int     receiveBuffer { 0 };
+        qint64  bytes { 0 };
+        double  mbps { 0.0 };
+        QString error;
+    };
+
+    struct RunState
+    {
+        ThroughputTester *self { nullptr };
+        QString label;
+        bool    appendSink { false };
+        QByteArray sink;
+        int     receiveBuffer { 0 };
+        qint64  limitMs { 0 };
+        qint64  lastSampleMs { 0 };
+        qint64  lastSampleBytes { 0 };
+        qint64  startMs { 0 };
+        bool    limitReached { false };
+    };
+
+    void runAll(const Config &config);
+    RunResult runOnce(const Config &config, long bufferSize, int receiveBuffer, bool appendSink);
+    void post(const QString &message);
+
+    static size_t writeCallback(char *ptr, size_t size, size_t nmemb, void *userdata);
+    static int xferInfoCallback(void *clientp, curl_off_t dltotal, curl_off_t dlnow,
+                                curl_off_t ultotal, curl_off_t ulnow);
+    static int sockoptCallback(void *clientp, curl_socket_t fd, curlsocktype purpose);
+    static QString formatSize(qint64 bytes);
+
+    QPointer<QThread> worker_;
+    std::atomic<bool> cancel_ { false };
+    bool running_ { false };
+};
+
+#endif // THROUGHPUTTESTER_H
@@ -0,0 +1,366 @@
+#include "tlsbenchmark.h"
+#include "curlruntime.h"
+#include <QMetaObject>
+#include <algorithm>
+#include <cmath>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <windows.h>
+#else
+#include <poll.h>
+#include <time.h>
+#endif
+
+namespace {
+constexpr long kConnectTimeoutMs = 10'000;
+// TLS 1.3的会话票据在握手完成后才由服务器发出，最多等这么久把它读进会话缓存
+constexpr int kTicketWaitMs = 50;
+// 与applyProxyOptions对代理使用的SSL选项一致（基线另加ALLOW_BEAST）
+constexpr long kSslOptions = CURLSSLOPT_NO_REVOKE | CURLSSLOPT_NO_PARTIALCHAIN;
+
+struct Suite
+{
+    const char *name;
+    const char *tls12;
+    const char *tls13;
+};
+
+const Suite kSuites[] = {
+    { "AES128-GCM", "ECDHE-ECDSA-AES128-GCM-SHA256:ECDHE-RSA-AES128-GCM-SHA256", "TLS_AES_128_GCM_SHA256" },
+    { "AES256-GCM", "ECDHE-ECDSA-AES256-GCM-SHA384:ECDHE-RSA-AES256-GCM-SHA384", "TLS_AES_256_GCM_SHA384" },
+    { "CHACHA20", "ECDHE-ECDSA-CHACHA20-POLY1305:ECDHE-RSA-CHACHA20-POLY1305", "TLS_CHACHA20_POLY1305_SHA256" },
+};
+
+const char *const kCurves[] = { "X25519", "P-256" };
+
+bool waitReadable(curl_socket_t socket, int timeoutMs)
+{
+#ifdef _WIN32
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(socket, &set);
+    timeval timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_usec = (timeoutMs % 1000) * 1000;
+    return select(0, &set, nullptr, nullptr, &timeout) > 0;
+#else
+    pollfd descriptor;
+    descriptor.fd = socket;
+    descriptor.events = POLLIN;
+    descriptor.revents = 0;
+    return poll(&descriptor, 1, timeoutMs) > 0;
+#endif
+}
+}
+
+QList<TlsHandshakeBenchmark::Case> TlsHandshakeBenchmark::defaultMatrix()
+{
+    QList<Case> cases;
+    for (bool resume : { false, true }) {
+        Case baseline;
+        baseline.label = "当前配置(MAX_DEFAULT)";
+        baseline.sslVersion = CURL_SSLVERSION_MAX_DEFAULT;
+        baseline.sslOptions = kSslOptions | CURLSSLOPT_ALLOW_BEAST;
+        baseline.resume = resume;
+        cases << baseline;
+    }
+    for (bool tls13 : { false, true }) {
+        for (const Suite &suite : kSuites) {
+            for (const char *curve : kCurves) {
+                for (bool resume : { false, true }) {
+                    Case c;
+                    c.label = QString("TLS%1 %2 %3").arg(tls13 ? "1.3" : "1.2", suite.name, curve);
+                    c.sslVersion = tls13 ? (CURL_SSLVERSION_TLSv1_3 | CURL_SSLVERSION_MAX_TLSv1_3)
+                                         : (CURL_SSLVERSION_TLSv1_2 | CURL_SSLVERSION_MAX_TLSv1_2);
+                    if (tls13) {
+                        c.tls13Ciphers = suite.tls13;
+                    } else {
+                        c.cipherList = suite.tls12;
+                    }
+                    c.curves = curve;
+                    c.sslOptions = kSslOptions;
+                    c.resume = resume;
+                    cases << c;
+                }
+            }
+        }
+    }
+    return cases;
+}
+
+TlsHandshakeBenchmark::TlsHandshakeBenchmark(QObject *parent)
+    : QObject(parent)
+{
+}
+
+TlsHandshakeBenchmark::~TlsHandshakeBenchmark()
+{
+    // 工作线程访问本对象，必须等它结束；最多再等一次握手
+    cancel_ = true;
+    if (worker_) {
+        worker_->wait();
+    }
+}
+
+void TlsHandshakeBenchmark::start(const Config &config)
+{
+    if (running_) {
+        return;
+    }
+
+    running_ = true;
+    cancel_ = false;
+
+    QThread *thread = QThread::create([this, config]() { runAll(config); });
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    worker_ = thread;
+    thread->start();
+}
+
+void TlsHandshakeBenchmark::cancel()
+{
+    cancel_ = true;
+}
+
+void TlsHandshakeBenchmark::post(const QString &message)
+{
+    QMetaObject::invokeMethod(this, [this, message]() { emit sample(message); }, Qt::QueuedConnection);
+}
+
+qint64 TlsHandshakeBenchmark::threadCpuNs()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+        return 0;
+    }
+    const auto ticks = [](const FILETIME &t) {
+        return (static_cast<qint64>(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+    };
+    return (ticks(kernel) + ticks(user)) * 100;
+#else
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return 0;
+    }
+    return static_cast<qint64>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+#endif
+}
+
+double TlsHandshakeBenchmark::percentileMs(const QList<qint64> &sortedNs, double fraction)
+{
+    if (sortedNs.isEmpty()) {
+        return 0;
+    }
+    // 最近秩法：第ceil(p*n)个样本
+    const qsizetype rank = static_cast<qsizetype>(std::ceil(fraction * sortedNs.size()));
+    return sortedNs.at(qBound<qsizetype>(0, rank - 1, sortedNs.size() - 1)) / 1e6;
+}
+
+void TlsHandshakeBenchmark::setupHandle(CURL *curl, const Config &config, const Case &testCase) const
+{
+    // 直接以https访问代理端口：代理本身就是TLS服务端，测到的只有TCP连接之后的TLS握手，不含CONNECT往返
+    const ProxyOptions &proxy = config.proxy;
+    const QString host = proxy.host.contains(':') ? "[" + proxy.host + "]" : proxy.host;
+    curl_easy_setopt(curl, CURLOPT_URL, QString("https://%1:%2/").arg(host).arg(proxy.port).toUtf8().constData());
+    curl_easy_setopt(curl, CURLOPT_CONNECT_ONLY, 1L);
+    curl_easy_setopt(curl, CURLOPT_FRESH_CONNECT, 1L);
+    curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, kConnectTimeoutMs);
+    curl_easy_setopt(curl, CURLOPT_SSL_SESSIONID_CACHE, testCase.resume ? 1L : 0L);
+
+    curl_easy_setopt(curl, CURLOPT_SSLVERSION, testCase.sslVersion);
+    curl_easy_setopt(curl, CURLOPT_SSL_OPTIONS, testCase.sslOptions);
+    if (!testCase.cipherList.isEmpty()) {
+        curl_easy_setopt(curl, CURLOPT_SSL_CIPHER_LIST, testCase.cipherList.toLatin1().constData());
+    }
+    if (!testCase.tls13Ciphers.isEmpty()) {
+        curl_easy_setopt(curl, CURLOPT_TLS13_CIPHERS, testCase.tls13Ciphers.toLatin1().constData());
+    }
+    if (!testCase.curves.isEmpty()) {
+        curl_easy_setopt(curl, CURLOPT_SSL_EC_CURVES, testCase.curves.toLatin1().constData());
+    }
+
+    // 证书验证方式与正常连接代理时相同，验证开销计入每次握手的CPU
+    if (!proxy.pinnedPublicKey.isEmpty()) {
+        curl_easy_setopt(curl, CURLOPT_PINNEDPUBLICKEY, proxy.pinnedPublicKey.toLatin1().constData());
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+    } else if (!proxy.caPath.isEmpty()) {
+        curl_easy_setopt(curl, CURLOPT_CAINFO, proxy.caPath.toUtf8().constData());
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 2L);
+    } else {
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+    }
+}
+
+bool TlsHandshakeBenchmark::handshake(CURL *curl, const Case &testCase, qint64 *handshakeNs, qint64 *cpuNs,
+                                      QString *error)
+{
+    char errorBuffer[CURL_ERROR_SIZE] = {};
+    curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, errorBuffer);
+
+    const qint64 cpuStart = threadCpuNs();
+    const CURLcode code = curl_easy_perform(curl);
+    const qint64 cpuEnd = threadCpuNs();
+    curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, nullptr);
+    if (code != CURLE_OK) {
+        *error = QString::fromUtf8(errorBuffer[0] ? errorBuffer : curl_easy_strerror(code));
+        return false;
+    }
+
+    curl_off_t connectUs = 0;
+    curl_off_t appConnectUs = 0;
+    curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connectUs);
+    curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &appConnectUs);
+    *handshakeNs = (appConnectUs - connectUs) * 1000;
+    *cpuNs = cpuEnd - cpuStart;
+
+    // 只握手不收数据时，TLS 1.3的NewSessionTicket留在套接字里，不读一次下次就无从复用
+    if (testCase.resume) {
+        curl_socket_t socket = CURL_SOCKET_BAD;
+        if (curl_easy_getinfo(curl, CURLINFO_ACTIVESOCKET, &socket) == CURLE_OK && socket != CURL_SOCKET_BAD
+            && waitReadable(socket, kTicketWaitMs)) {
+            char buffer[256];
+            size_t received = 0;
+            curl_easy_recv(curl, buffer, sizeof(buffer), &received);
+        }
+    }
+    return true;
+}
+
+TlsHandshakeBenchmark::CaseResult TlsHandshakeBenchmark::runCase(const Config &config, const Case &testCase)
+{
+    CaseResult result;
+    CURL *curl = curl_easy_init();
+    if (!curl) {
+        result.error = "初始化curl失败";
+        return result;
+    }
+    setupHandle(curl, config, testCase);
+
+    // 第一次握手加载CA文件并（复用开启时）建立会话，不计入结果
+    qint64 handshakeNs = 0;
+    qint64 cpuNs = 0;
+    if (!handshake(curl, testCase, &handshakeNs, &cpuNs, &result.error)) {
+        curl_easy_cleanup(curl);
+        return result;
+    }
+
+    QList<qint64> latencies;
+    qint64 totalCpuNs = 0;
+    for (int i = 0; i < config.handshakesPerCase && !cancel_; ++i) {
+        QString error;
+        if (!handshake(curl, testCase, &handshakeNs, &cpuNs, &error)) {
+            ++result.failures;
+            result.error = error;
+            continue;
+        }
+        latencies << handshakeNs;
+        totalCpuNs += cpuNs;
+    }
+    curl_easy_cleanup(curl);
+
+    if (latencies.isEmpty()) {
+        return result;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    result.handshakes = latencies.size();
+    result.p50Ms = percentileMs(latencies, 0.50);
+    result.p90Ms = percentileMs(latencies, 0.90);
+    result.maxMs = latencies.last() / 1e6;
+    result.cpuMs = totalCpuNs / 1e6 / latencies.size();
+    return result;
+}
+
+void TlsHandshakeBenchmark::runAll(const Config &config)
+{
+    CurlRuntime::ensureInitialized();
+    const curl_version_info_data *info = curl_version_info(CURLVERSION_NOW);
+    QString summary = "=== TLS握手测试结果 ===\n";
+    summary += QString("代理 %1:%2, TLS库 %3, 证书验证: %4, 每种配置 %5 次握手\n")
+                   .arg(config.proxy.host)
+                   .arg(config.proxy.port)
+                   .arg(QString::fromLatin1(info->ssl_version),
+                        !config.proxy.pinnedPublicKey.isEmpty() ? QString("固定公钥")
+                        : !config.proxy.caPath.isEmpty()       ? QString("CA证书链")
+                                                                : QString("不验证"))
+                   .arg(config.handshakesPerCase);
+    summary += QString("%1 %2 %3 %4 %5 %6\n")
+                   .arg(QString("配置"), -32)
+                   .arg(QString("复用"), -4)
+                   .arg(QString("p50 ms"), 8)
+                   .arg(QString("p90 ms"), 8)
+                   .arg(QString("max ms"), 8)
+                   .arg(QString("CPU ms/次"), 10);
+
+    const Case *cheapest[2] = { nullptr, nullptr };
+    double cheapestCpu[2] = { 0, 0 };
+    const Case *fastest = nullptr;
+    double fastestP50 = 0;
+    for (const Case &testCase : config.cases) {
+        if (cancel_) {
+            break;
+        }
+        const CaseResult r = runCase(config, testCase);
+        // 被取消打断的配置只测了一部分，不计入结果
+        if (cancel_) {
+            break;
+        }
+        const QString resume = testCase.resume ? "开" : "关";
+        if (r.handshakes == 0) {
+            summary += QString("%1 %2 失败: %3\n").arg(testCase.label, -32).arg(resume, -4).arg(r.error);
+            post(QString("  %1 (复用%2): 失败 %3").arg(testCase.label, resume, r.error));
+            continue;
+        }
+        summary += QString("%1 %2 %3 %4 %5 %6%7\n")
+                       .arg(testCase.label, -32)
+                       .arg(resume, -4)
+                       .arg(r.p50Ms, 8, 'f', 2)
+                       .arg(r.p90Ms, 8, 'f', 2)
+                       .arg(r.maxMs, 8, 'f', 2)
+                       .arg(r.cpuMs, 10, 'f', 3)
+                       .arg(r.failures > 0 ? QString("  (失败 %1 次: %2)").arg(r.failures).arg(r.error) : QString());
+        post(QString("  %1 (复用%2): p50 %3 ms, CPU %4 ms/次")
+                 .arg(testCase.label, resume)
+                 .arg(r.p50Ms, 0, 'f', 2)
+                 .arg(r.cpuMs, 0, 'f', 3));
+
+        // 有失败的配置不参与推荐
+        if (r.failures == 0) {
+            const int slot = testCase.resume ? 1 : 0;
+            if (!cheapest[slot] || r.cpuMs < cheapestCpu[slot]) {
+                cheapest[slot] = &testCase;
+                cheapestCpu[slot] = r.cpuMs;
+            }
+            if (!fastest || r.p50Ms < fastestP50) {
+                fastest = &testCase;
+                fastestP50 = r.p50Ms;
+            }
+        }
+    }
+
+    if (cheapest[0]) {
+        summary += QString("\n完整握手CPU最低: %1 (%2 ms/次)\n").arg(cheapest[0]->label).arg(cheapestCpu[0], 0, 'f', 3);
+    }
+    if (cheapest[1]) {
+        summary += QString("会话复用CPU最低: %1 (%2 ms/次)\n").arg(cheapest[1]->label).arg(cheapestCpu[1], 0, 'f', 3);
+    }
+    if (fastest) {
+        summary += QString("握手延迟最低: %1%2 (p50 %3 ms)\n")
+                       .arg(fastest->label, fastest->resume ? QString("，复用") : QString())
+                       .arg(fastestP50, 0, 'f', 2);
+    }
+    summary += "说明: 服务器不支持的版本/套件/曲线会显示为失败；会话复用需要服务器支持会话票据或会话ID\n";
+    if (cancel_) {
+        summary += "测试已取消\n";
+    }
+
+    QMetaObject::invokeMethod(this, [this, summary]() {
+        running_ = false;
+        worker_ = nullptr;
+        emit testFinished(summary);
+    }, Qt::QueuedConnection);
+}
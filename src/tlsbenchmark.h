@@ -0,0 +1,82 @@
+#ifndef TLSBENCHMARK_H
+#define TLSBENCHMARK_H
+
+#include <QObject>
+#include <QList>
+#include <QPointer>
+#include <QThread>
+#include <atomic>
+#include <curl/curl.h>
+#include "proxyoptions.h"
+
+// 反复与代理做TLS握手（只握手，不发请求），在TLS版本、密码套件、密钥交换曲线和会话复用的组合下
+// 测量握手延迟和每次握手消耗的客户端CPU，用来给整批客户端挑选开销最低的安全配置
+class TlsHandshakeBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    // 矩阵中的一种配置，空字符串表示使用TLS库的默认值
+    struct Case
+    {
+        QString label;
+        long    sslVersion { CURL_SSLVERSION_DEFAULT };
+        QString cipherList;     // TLS 1.2及以下（CURLOPT_SSL_CIPHER_LIST）
+        QString tls13Ciphers;   // TLS 1.3（CURLOPT_TLS13_CIPHERS）
+        QString curves;         // CURLOPT_SSL_EC_CURVES
+        long    sslOptions { 0 };
+        bool    resume { false };
+    };
+
+    struct Config
+    {
+        ProxyOptions proxy;
+        QList<Case> cases;
+        int handshakesPerCase { 20 };
+    };
+
+    // 当前applyProxyOptions使用的配置作为基线，加上TLS 1.2/1.3下各种套件和曲线，每种分别测复用开/关
+    static QList<Case> defaultMatrix();
+
+    explicit TlsHandshakeBenchmark(QObject *parent = nullptr);
+    ~TlsHandshakeBenchmark() override;
+
+    void start(const Config &config);
+    // 只请求停止，不等待：当前握手结束后工作线程退出，结果仍经testFinished送出
+    void cancel();
+    bool isRunning() const { return running_; }
+
+signals:
+    void sample(const QString &message);
+    void testFinished(const QString &summary);
+
+private:
+    struct CaseResult
+    {
+        int    handshakes { 0 };
+        int    failures { 0 };
+        double p50Ms { 0 };
+        double p90Ms { 0 };
+        double maxMs { 0 };
+        // 每次握手在本线程上消耗的CPU时间（用户态+内核态）
+        double cpuMs { 0 };
+        QString error;
+    };
+
+    void runAll(const Config &config);
+    CaseResult runCase(const Config &config, const Case &testCase);
+    void setupHandle(CURL *curl, const Config &config, const Case &testCase) const;
+    // 完成一次握手；成功时写入握手耗时和CPU耗时（纳秒）
+    // 同一种配置复用一个easy句柄：CA证书库和会话缓存保留在句柄中，每次强制新建连接
+    bool handshake(CURL *curl, const Case &testCase, qint64 *handshakeNs, qint64 *cpuNs, QString *error);
+    void post(const QString &message);
+
+    static qint64 threadCpuNs();
+    static double percentileMs(const QList<qint64> &sortedNs, double fraction);
+
+    // 线程结束后自行deleteLater，QPointer随之清空
+    QPointer<QThread> worker_;
+    std::atomic<bool> cancel_ { false };
+    bool running_ { false };
+};
+
+#endif // TLSBENCHMARK_H
@@ -0,0 +1,28 @@
+#include "tokenbucket.h"
+#include <cmath>
+
+void TokenBucket::configure(double rate, qint64 nowMs)
+{
+    rate_ = rate;
+    capacity_ = qMax(1.0, rate);
+    tokens_ = qMin(tokens_, capacity_);
+    lastMs_ = nowMs;
+}
+
+bool TokenBucket::available(qint64 nowMs)
+{
+    if (rate_ <= 0) {
+        return true;
+    }
+    tokens_ = qMin(capacity_, tokens_ + (nowMs - lastMs_) * rate_ / 1000.0);
+    lastMs_ = nowMs;
+    return tokens_ >= 1.0;
+}
+
+qint64 TokenBucket::msUntilAvailable() const
+{
+    if (rate_ <= 0 || tokens_ >= 1.0) {
+        return 0;
+    }
+    return static_cast<qint64>(std::ceil((1.0 - tokens_) * 1000.0 / rate_));
+}
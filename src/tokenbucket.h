@@ -0,0 +1,23 @@
+#ifndef TOKENBUCKET_H
+#define TOKENBUCKET_H
+
+#include <QtGlobal>
+
+// 令牌桶：每秒补充rate个令牌，容量为一秒的量（至少1个），rate为0时不限速。
+// 时间由调用方传入（毫秒，单调递增），不读时钟，也不加锁
+class TokenBucket
+{
+public:
+    void configure(double rate, qint64 nowMs);
+    bool available(qint64 nowMs);
+    void take() { tokens_ -= 1.0; }
+    qint64 msUntilAvailable() const;
+
+private:
+    double rate_ { 0 };
+    double capacity_ { 1 };
+    double tokens_ { 1 };
+    qint64 lastMs_ { 0 };
+};
+
+#endif // TOKENBUCKET_H
@@ -0,0 +1,454 @@
+#include "transfercontext.h"
+#include "curlruntime.h"
+#include "publickeypin.h"
+#include "spanprofiler.h"
+#include <QDateTime>
+#include <cstdio>
+
+namespace {
+// 超过此大小的响应体转存到临时文件，由查看器内存映射访问
+constexpr qint64 kBodySpillThreshold = 4 * 1024 * 1024;
+// 瞬时速度按这个窗口计算，太短会随TCP突发剧烈跳动
+constexpr qint64 kRateWindowMs = 250;
+// 小于此大小的请求体不发Expect: 100-continue，省掉一次等待服务器的往返
+constexpr qint64 kExpectContinueThreshold = 1024 * 1024;
+// 服务器不支持100-continue时最多等这么久就直接发送请求体
+constexpr long kExpectContinueTimeoutMs = 1000;
+// 建立连接的上限：TCP、代理CONNECT隧道和TLS握手都算在内
+constexpr long kConnectTimeoutMs = 30'000;
+// 连接建立后不限总时长，只有连续这么多秒平均速度低于1字节/秒（上传和下载都停住）才判为停滞
+constexpr long kStallSeconds = 30;
+}
+
+TransferContext::TransferContext(const TransferRequest &request)
+    : request_(request)
+{
+    result_.body.setSpillThreshold(kBodySpillThreshold);
+}
+
+void TransferContext::debug(const QString &message)
+{
+    if (debugSink_) {
+        debugSink_(message);
+    }
+}
+
+size_t TransferContext::headerCallback(char *buffer, size_t size, size_t nitems, void *userdata)
+{
+    ScopedSpan span("TransferContext::headerCallback");
+    TransferContext *self = static_cast<TransferContext *>(userdata);
+    const qsizetype length = static_cast<qsizetype>(size * nitems);
+    self->result_.headers.append(buffer, length);
+
+    // 批量请求等不转发调试输出的传输，不必为每行头部构造QString
+    if (self->debugSink_) {
+        self->debug(QString::fromUtf8(buffer, length).trimmed());
+    }
+    return size * nitems;
+}
+
+size_t TransferContext::writeCallback(char *ptr, size_t size, size_t nmemb, void *userdata)
+{
+    ScopedSpan span("TransferContext::writeCallback");
+    TransferContext *self = static_cast<TransferContext *>(userdata);
+    // 收到第一块body时已经是最终响应：CONNECT响应和1xx临时响应的头部结束时，
+    // CONTENT_LENGTH_DOWNLOAD_T说的是另一个响应，不能按它预留。没有长度时保持分段模式
+    if (!self->bodyReserved_) {
+        self->bodyReserved_ = true;
+        curl_off_t contentLength = -1;
+        if (curl_easy_getinfo(self->curl_, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &contentLength) == CURLE_OK
+            && contentLength > 0) {
+            self->result_.body.reserve(contentLength);
+        }
+    }
+    // 转存文件写入失败时返回0，让libcurl以CURLE_WRITE_ERROR结束传输
+    if (!self->result_.body.append(ptr, static_cast<qsizetype>(size * nmemb))) {
+        return 0;
+    }
+    return size * nmemb;
+}
+
+size_t TransferContext::readCallback(char *buffer, size_t size, size_t nitems, void *userdata)
+{
+    TransferContext *self = static_cast<TransferContext *>(userdata);
+    if (self->aborted_) {
+        return CURL_READFUNC_ABORT;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    const qint64 read = self->upload_.read(buffer, static_cast<qint64>(size * nitems));
+    self->uploadReadNs_ += timer.nsecsElapsed();
+    if (read < 0) {
+        self->debug("读取请求体失败: " + self->upload_.errorString());
+        return CURL_READFUNC_ABORT;
+    }
+    // 返回0表示请求体结束；分块上传时libcurl据此发送结束块
+    return static_cast<size_t>(read);
+}
+
+int TransferContext::xferInfoCallback(void *clientp, curl_off_t dltotal, curl_off_t dlnow,
+                                      curl_off_t ultotal, curl_off_t ulnow)
+{
+    TransferContext *self = static_cast<TransferContext *>(clientp);
+    self->downloaded_.store(dlnow, std::memory_order_relaxed);
+    self->downloadTotal_.store(dltotal, std::memory_order_relaxed);
+    self->uploaded_.store(ulnow, std::memory_order_relaxed);
+    self->uploadTotal_.store(ultotal, std::memory_order_relaxed);
+
+    const qint64 nowMs = self->rateTimer_.elapsed();
+    const qint64 elapsedMs = nowMs - self->rateWindowStartMs_;
+    if (elapsedMs >= kRateWindowMs) {
+        self->downloadBytesPerSecond_.store((dlnow - self->rateWindowStartDownloaded_) * 1000 / elapsedMs,
+                                            std::memory_order_relaxed);
+        self->uploadBytesPerSecond_.store((ulnow - self->rateWindowStartUploaded_) * 1000 / elapsedMs,
+                                          std::memory_order_relaxed);
+        self->rateWindowStartMs_ = nowMs;
+        self->rateWindowStartDownloaded_ = dlnow;
+        self->rateWindowStartUploaded_ = ulnow;
+    }
+    return self->aborted_ ? 1 : 0;
+}
+
+int TransferContext::debugCallback(CURL *, curl_infotype type, char *data, size_t size, void *userptr)
+{
+    static_cast<TransferContext *>(userptr)->trace_.onCurlDebug(type, data, size);
+    return 0;
+}
+
+TransferProgress TransferContext::progress() const
+{
+    TransferProgress progress;
+    progress.downloaded = downloaded_.load(std::memory_order_relaxed);
+    progress.downloadTotal = downloadTotal_.load(std::memory_order_relaxed);
+    progress.uploaded = uploaded_.load(std::memory_order_relaxed);
+    progress.uploadTotal = uploadTotal_.load(std::memory_order_relaxed);
+    progress.downloadBytesPerSecond = downloadBytesPerSecond_.load(std::memory_order_relaxed);
+    progress.uploadBytesPerSecond = uploadBytesPerSecond_.load(std::memory_order_relaxed);
+    return progress;
+}
+
+bool TransferContext::setupUpload(CURL *curl, struct curl_slist **headers)
+{
+    const bool isStdin = request_.uploadPath == "-";
+    const bool opened = isStdin ? upload_.open(stdin, QIODevice::ReadOnly)
+                                : (upload_.setFileName(request_.uploadPath), upload_.open(QIODevice::ReadOnly));
+    if (!opened) {
+        debug(QString("无法打开请求体 %1: %2").arg(request_.uploadPath, upload_.errorString()));
+        result_.curlCode = CURLE_READ_ERROR;
+        return false;
+    }
+
+    // 标准输入和管道长度未知，使用分块传输编码
+    const qint64 size = upload_.isSequential() ? -1 : upload_.size();
+    curl_easy_setopt(curl, CURLOPT_READFUNCTION, &TransferContext::readCallback);
+    curl_easy_setopt(curl, CURLOPT_READDATA, this);
+    curl_easy_setopt(curl, CURLOPT_UPLOAD_BUFFERSIZE, request_.uploadBufferSize);
+    if (request_.method == "PUT") {
+        curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
+        curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, static_cast<curl_off_t>(size));
+    } else {
+        curl_easy_setopt(curl, CURLOPT_POST, 1L);
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(size));
+        // 否则libcurl默认声明为表单数据
+        *headers = curl_slist_append(*headers, "Content-Type: application/octet-stream");
+    }
+    if (size < 0) {
+        *headers = curl_slist_append(*headers, "Transfer-Encoding: chunked");
+    }
+
+    // 大请求体先等服务器确认（例如认证失败时不必把整个文件发出去）；小请求体等待的往返比发送本身还贵
+    if (size >= 0 && size < kExpectContinueThreshold) {
+        *headers = curl_slist_append(*headers, "Expect:");
+    } else {
+        curl_easy_setopt(curl, CURLOPT_EXPECT_100_TIMEOUT_MS, kExpectContinueTimeoutMs);
+    }
+
+    debug(QString("%1 请求体: %2，%3，上传缓冲区 %4 KiB，%5")
+              .arg(QString::fromLatin1(request_.method),
+                   isStdin ? QString("标准输入") : request_.uploadPath,
+                   size < 0 ? QString("长度未知（分块传输）") : QString("%1 字节").arg(size))
+              .arg(request_.uploadBufferSize / 1024)
+              .arg(size >= 0 && size < kExpectContinueThreshold ? QString("不使用100-continue")
+                                                                : QString("使用100-continue")));
+    return true;
+}
+
+void TransferContext::useCachedBody(const ResponseCache::Entry &entry, ResponseCache::Outcome outcome)
+{
+    result_.httpStatus = entry.status;
+    result_.cachedBody = entry.bodyFile;
+    result_.cacheOutcome = outcome;
+    request_.cache->count(outcome);
+}
+
+ResponseCache::ResponseInfo TransferContext::cacheInfo(CURL *curl, long status)
+{
+    // 同名头部可能出现多次（例如多行Cache-Control），按RFC 9110用逗号连接
+    const auto header = [curl](const char *name) {
+        QStringList values;
+        struct curl_header *h = nullptr;
+        size_t index = 0;
+        while (curl_easy_header(curl, name, index, CURLH_HEADER, -1, &h) == CURLHE_OK) {
+            values << QString::fromLatin1(h->value).trimmed();
+            if (++index >= h->amount) {
+                break;
+            }
+        }
+        return values.join(", ");
+    };
+
+    ResponseCache::ResponseInfo info;
+    info.status = int(status);
+    info.cacheControl = header("Cache-Control");
+    info.expires = header("Expires");
+    info.date = header("Date");
+    info.age = header("Age");
+    info.etag = header("ETag");
+    info.lastModified = header("Last-Modified");
+    info.contentType = header("Content-Type");
+    info.vary = header("Vary");
+    info.pragma = header("Pragma");
+    return info;
+}
+
+void TransferContext::useMemoryEntry(const MemoryCache::Entry &entry, MemoryCache::Outcome outcome)
+{
+    result_.httpStatus = entry.status;
+    result_.headers = entry.headers;
+    result_.contentEncoding = entry.contentEncoding;
+    // 与缓存条目共享同一块数据，不复制响应体
+    result_.body.adopt(entry.body);
+    result_.memoryOutcome = outcome;
+    result_.curlCode = CURLE_OK;
+}
+
+bool TransferContext::memoryEntry(MemoryCache::Entry *entry) const
+{
+    // 只缓存留在内存中的完整2xx响应；304沿用的磁盘缓存文件和转存到临时文件的大响应都不放进来
+    if (result_.curlCode != CURLE_OK || result_.httpStatus < 200 || result_.httpStatus >= 300
+        || result_.httpStatus == 206 || result_.cachedBody || result_.body.isSpilled()) {
+        return false;
+    }
+    if (memoryLifetimeMs_ <= 0) {
+        return false;
+    }
+    // 头部块包含代理CONNECT的响应，只保留最后一个响应的头部
+    const qsizetype last = result_.headers.lastIndexOf("\r\n\r\nHTTP/");
+    entry->status = result_.httpStatus;
+    entry->headers = last >= 0 ? result_.headers.mid(last + 4) : result_.headers;
+    entry->contentEncoding = result_.contentEncoding;
+    entry->body = result_.body.toByteArray();
+    entry->expiresAtMs = QDateTime::currentMSecsSinceEpoch() + memoryLifetimeMs_;
+    return true;
+}
+
+void TransferContext::perform()
+{
+    ScopedSpan span("TransferContext::perform");
+    if (request_.capturePublicKey) {
+        // 隧道复用时拿不到代理证书，单独对代理端口做一次TLS握手
+        result_.proxyPublicKey = fetchProxyPublicKeyPin(request_.proxy, true, &result_.proxyPublicKeyError);
+        result_.curlCode = result_.proxyPublicKey.isEmpty() ? CURLE_SSL_CERTPROBLEM : CURLE_OK;
+        return;
+    }
+    MemoryCache *memory = request_.memoryCache.data();
+    if (!memory || request_.headOnly || request_.method != "GET") {
+        performTransfer();
+        return;
+    }
+
+    const QByteArray key = MemoryCache::keyFor(request_.method, request_.url);
+    MemoryCache::Entry entry;
+    bool waited = false;
+    const MemoryCache::Claim claim = memory->claim(key, &entry, [this, &waited]() {
+        if (!waited) {
+            waited = true;
+            debug("内存缓存: 相同URL的请求正在进行，等待其结果");
+        }
+        return aborted_.load();
+    });
+    if (claim == MemoryCache::ClaimHit) {
+        debug(QString("内存缓存%1: %2 字节")
+                  .arg(waited ? QString("合并请求") : QString("命中"))
+                  .arg(entry.body.size()));
+        useMemoryEntry(entry, waited ? MemoryCache::Coalesced : MemoryCache::Hit);
+        return;
+    }
+    if (claim == MemoryCache::ClaimBypass && aborted_) {
+        result_.curlCode = CURLE_ABORTED_BY_CALLBACK;
+        return;
+    }
+
+    result_.memoryOutcome = MemoryCache::Miss;
+    performTransfer();
+    if (claim == MemoryCache::ClaimLeader) {
+        // 无论成功与否都要发布，否则等待同一URL的请求要到各自超时才会放弃
+        const bool cacheable = memoryEntry(&entry);
+        memory->publish(key, cacheable ? &entry : nullptr);
+    }
+}
+
+void TransferContext::performTransfer()
+{
+    ResponseCache *cache = request_.cache.data();
+    if (request_.headOnly || request_.method != "GET") {
+        cache = nullptr;
+    }
+    ResponseCache::Entry cached;
+    if (cache) {
+        cached = cache->lookup(request_.url);
+        if (cached.valid && cached.fresh) {
+            // 新鲜的缓存条目不需要连接服务器，也就不占用连接池中的句柄
+            debug(QString("缓存命中：已缓存 %1 秒，有效期 %2 秒")
+                      .arg(cached.ageSeconds)
+                      .arg(cached.lifetimeSeconds));
+            useCachedBody(cached, ResponseCache::Hit);
+            result_.curlCode = CURLE_OK;
+            return;
+        }
+    }
+
+    CurlRuntime::ensureInitialized();
+    ConnectionPool *pool = request_.pool.data();
+    CURL *curl = pool ? pool->acquire() : curl_easy_init();
+    if (!curl) {
+        result_.curlCode = CURLE_FAILED_INIT;
+        return;
+    }
+    curl_ = curl;
+
+    curl_easy_setopt(curl, CURLOPT_URL, request_.url.toUtf8().constData());
+    if (request_.headOnly) {
+        curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+    }
+    struct curl_slist *headers = nullptr;
+    const bool uploading = request_.method == "POST" || request_.method == "PUT";
+    if (uploading && !setupUpload(curl, &headers)) {
+        if (pool) {
+            pool->release(curl);
+        } else {
+            curl_easy_cleanup(curl);
+        }
+        curl_ = nullptr;
+        return;
+    }
+
+    if (cached.valid) {
+        // 过期条目带验证器发条件请求，服务器返回304时沿用缓存的响应体
+        if (!cached.etag.isEmpty()) {
+            headers = curl_slist_append(headers, ("If-None-Match: " + cached.etag).toLatin1().constData());
+        }
+        if (!cached.lastModified.isEmpty()) {
+            headers = curl_slist_append(headers,
+                                        ("If-Modified-Since: " + cached.lastModified).toLatin1().constData());
+        }
+    }
+
+    QStringList setupLog;
+    applyProxyOptions(curl, request_.proxy, &setupLog);
+    for (const QString &line : setupLog) {
+        debug(line);
+    }
+
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, &TransferContext::headerCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, this);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &TransferContext::writeCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, this);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, &TransferContext::xferInfoCallback);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, this);
+    // 大文件上传下载可能持续很久，不设总超时
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, kConnectTimeoutMs);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, kStallSeconds);
+    tracing_ = TransferTracer::isEnabled();
+    if (tracing_) {
+        // 连接池取句柄时会curl_easy_reset，这几个选项不会带到下一个传输
+        trace_ = TransferTrace(TransferTracer::nextTransferId(), QString::fromLatin1(request_.method) + " " + request_.url);
+        curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
+        curl_easy_setopt(curl, CURLOPT_DEBUGFUNCTION, &TransferContext::debugCallback);
+        curl_easy_setopt(curl, CURLOPT_DEBUGDATA, this);
+    }
+
+    if (headers) {
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    }
+
+    rateTimer_.start();
+    const qint64 requestTimeMs = QDateTime::currentMSecsSinceEpoch();
+    result_.curlCode = curl_easy_perform(curl);
+    const qint64 responseTimeMs = QDateTime::currentMSecsSinceEpoch();
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &result_.httpStatus);
+    curl_slist_free_all(headers);
+    if (result_.curlCode == CURLE_OPERATION_TIMEDOUT) {
+        // PRETRANSFER为0说明连接（含隧道和TLS）还没建立
+        curl_off_t preTransferUs = 0;
+        curl_easy_getinfo(curl, CURLINFO_PRETRANSFER_TIME_T, &preTransferUs);
+        debug(preTransferUs == 0 ? QString("连接超时：%1 秒内未能建立到目标的隧道").arg(kConnectTimeoutMs / 1000)
+                                 : QString("传输停滞：连续 %1 秒没有数据收发").arg(kStallSeconds));
+    }
+    if (tracing_) {
+        trace_.finish(result_.curlCode, result_.httpStatus);
+        TransferTracer::record(std::move(trace_));
+        tracing_ = false;
+    }
+
+    if (request_.memoryCache && result_.curlCode == CURLE_OK) {
+        memoryLifetimeMs_ = request_.memoryCache->lifetimeFor(cacheInfo(curl, result_.httpStatus),
+                                                              requestTimeMs, responseTimeMs);
+    }
+    if (cache && result_.curlCode == CURLE_OK) {
+        const ResponseCache::ResponseInfo info = cacheInfo(curl, result_.httpStatus);
+        ResponseCache::Entry refreshed;
+        if (result_.httpStatus == 304 && cached.valid) {
+            refreshed = cache->refresh(request_.url, info, requestTimeMs, responseTimeMs);
+        }
+        if (refreshed.valid) {
+            debug(QString("缓存重新验证：服务器返回304，沿用已缓存的 %1 字节").arg(refreshed.bodySize));
+            useCachedBody(refreshed, ResponseCache::Revalidated);
+        } else {
+            cache->store(request_.url, info, result_.body, requestTimeMs, responseTimeMs);
+            result_.cacheOutcome = ResponseCache::Miss;
+            cache->count(ResponseCache::Miss);
+        }
+    }
+
+    curl_off_t downloadSpeed = 0;
+    curl_easy_getinfo(curl, CURLINFO_SPEED_DOWNLOAD_T, &downloadSpeed);
+    result_.downloadBytesPerSecond = downloadSpeed;
+    if (uploading) {
+        curl_off_t uploaded = 0;
+        curl_off_t preTransferUs = 0;
+        curl_off_t postTransferUs = 0;
+        curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD_T, &uploaded);
+        curl_easy_getinfo(curl, CURLINFO_PRETRANSFER_TIME_T, &preTransferUs);
+        curl_easy_getinfo(curl, CURLINFO_POSTTRANSFER_TIME_T, &postTransferUs);
+        result_.uploadedBytes = uploaded;
+        const qint64 uploadUs = postTransferUs - preTransferUs;
+        result_.uploadMs = uploadUs / 1000;
+        result_.uploadBytesPerSecond = uploadUs > 0 ? uploaded * 1'000'000 / uploadUs : 0;
+        result_.uploadReadMs = uploadReadNs_ / 1'000'000;
+        upload_.close();
+    }
+
+    // SIZE_DOWNLOAD统计的是解码前的body字节数（线路字节），writeCallback收到的是解码后的字节
+    curl_off_t wireBytes = 0;
+    curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &wireBytes);
+    result_.wireBytes = wireBytes;
+    struct curl_header *encodingHeader = nullptr;
+    if (curl_easy_header(curl, "Content-Encoding", 0, CURLH_HEADER, -1, &encodingHeader) == CURLHE_OK) {
+        result_.contentEncoding = QString::fromLatin1(encodingHeader->value).trimmed();
+    }
+
+    if (pool) {
+        pool->release(curl, result_.curlCode == CURLE_OK);
+    } else {
+        curl_easy_cleanup(curl);
+    }
+    curl_ = nullptr;
+
+    // 公钥不一致时读取代理实际出示的公钥，随错误一起报告
+    if (result_.curlCode == CURLE_SSL_PINNEDPUBKEYNOTMATCH) {
+        result_.proxyPublicKey = fetchProxyPublicKeyPin(request_.proxy, false, &result_.proxyPublicKeyError);
+    }
+}
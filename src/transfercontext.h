@@ -0,0 +1,157 @@
+#ifndef TRANSFERCONTEXT_H
+#define TRANSFERCONTEXT_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <functional>
+#include <curl/curl.h>
+#include "bufferpool.h"
+#include "connectionpool.h"
+#include "memorycache.h"
+#include "proxyoptions.h"
+#include "responsecache.h"
+#include "transfertracer.h"
+
+// 发起请求时拍下的设置快照，创建后不再修改
+struct TransferRequest
+{
+    ProxyOptions proxy;
+    QString url;
+    bool headOnly { false };
+    // GET、POST或PUT；POST/PUT的请求体从uploadPath流式读取，"-"表示标准输入
+    QByteArray method { "GET" };
+    QString uploadPath;
+    // 上传缓冲区大小，libcurl接受16 KiB到2 MiB
+    long uploadBufferSize { 64 * 1024 };
+    // 所属档案的连接池，为空时使用独立的easy句柄
+    QSharedPointer<ConnectionPool> pool;
+    // 为空表示不使用响应缓存；只对普通GET请求生效
+    QSharedPointer<ResponseCache> cache;
+    // 内存缓存在磁盘缓存之前查询，同样只对普通GET请求生效
+    QSharedPointer<MemoryCache> memoryCache;
+    // 为true时不请求url，只对代理端口做一次经CA验证的TLS握手，捕获代理公钥；
+    // 由ProxyClient在请求成功后作为后台任务提交，不拖慢请求本身
+    bool capturePublicKey { false };
+};
+
+// 请求结果，只能移动，交给接收线程时不复制body
+struct TransferResult
+{
+    CURLcode   curlCode { CURLE_OK };
+    long       httpStatus { 0 };
+    qint64     wireBytes { 0 };
+    qint64     uploadedBytes { 0 };
+    // 上传速度按首字节发出到最后一字节发出的区间计算，不含等待响应的时间
+    qint64     uploadBytesPerSecond { 0 };
+    qint64     uploadMs { 0 };
+    // 读取请求体源文件的累计耗时，与uploadMs对比可以判断瓶颈是否在本地磁盘/管道
+    qint64     uploadReadMs { 0 };
+    qint64     downloadBytesPerSecond { 0 };
+    QString    contentEncoding;
+    QByteArray headers;
+    BodyBuffer body;
+    // 命中缓存或304重新验证时，响应体是这个缓存文件，body为空
+    ResponseCache::Outcome cacheOutcome { ResponseCache::NotCached };
+    std::shared_ptr<QFile> cachedBody;
+    MemoryCache::Outcome memoryOutcome { MemoryCache::NotUsed };
+    // 捕获到的代理公钥（CA验证通过），或公钥不一致时代理实际出示的公钥
+    QString    proxyPublicKey;
+    QString    proxyPublicKeyError;
+
+    TransferResult() = default;
+    TransferResult(TransferResult &&) = default;
+    TransferResult &operator=(TransferResult &&) = default;
+};
+
+// 传输进度快照。工作线程在XFERINFO回调中写入，界面线程按固定频率读取，
+// 各字段分别原子更新，读到的快照可能跨两次回调，用于显示已足够
+struct TransferProgress
+{
+    qint64 downloaded { 0 };
+    qint64 downloadTotal { 0 };
+    qint64 uploaded { 0 };
+    qint64 uploadTotal { 0 };
+    qint64 downloadBytesPerSecond { 0 };
+    qint64 uploadBytesPerSecond { 0 };
+};
+
+// 单次传输的上下文：持有设置快照和自己的缓冲区，执行期间只被工作线程访问
+class TransferContext
+{
+public:
+    using DebugSink = std::function<void(const QString &)>;
+
+    explicit TransferContext(const TransferRequest &request);
+    TransferContext(const TransferContext &) = delete;
+    TransferContext &operator=(const TransferContext &) = delete;
+
+    const TransferRequest &request() const { return request_; }
+
+    // 调试信息回调，在工作线程上调用，由调用方负责转发到自己的线程
+    void setDebugSink(DebugSink sink) { debugSink_ = std::move(sink); }
+
+    // 在工作线程上同步执行请求
+    void perform();
+    // 可从任意线程调用，正在进行的传输会在下一次进度回调时中止
+    void abort() { aborted_ = true; }
+    bool isAborted() const { return aborted_; }
+
+    // 可从任意线程调用，读取最近一次进度回调写入的数据
+    TransferProgress progress() const;
+
+    // 执行完成后把结果移出上下文
+    TransferResult takeResult() { return std::move(result_); }
+
+private:
+    void debug(const QString &message);
+    // 不经过内存缓存的完整请求流程（磁盘缓存、网络传输）
+    void performTransfer();
+    void useMemoryEntry(const MemoryCache::Entry &entry, MemoryCache::Outcome outcome);
+    // 成功的完整响应转成内存缓存条目；不可缓存时返回false
+    bool memoryEntry(MemoryCache::Entry *entry) const;
+    // 打开请求体并设置POST/PUT相关选项，失败时返回false并写入result_
+    bool setupUpload(CURL *curl, struct curl_slist **headers);
+    void useCachedBody(const ResponseCache::Entry &entry, ResponseCache::Outcome outcome);
+    static ResponseCache::ResponseInfo cacheInfo(CURL *curl, long status);
+
+    static size_t headerCallback(char *buffer, size_t size, size_t nitems, void *userdata);
+    static size_t writeCallback(char *ptr, size_t size, size_t nmemb, void *userdata);
+    static size_t readCallback(char *buffer, size_t size, size_t nitems, void *userdata);
+    static int xferInfoCallback(void *clientp, curl_off_t dltotal, curl_off_t dlnow,
+                                curl_off_t ultotal, curl_off_t ulnow);
+    static int debugCallback(CURL *handle, curl_infotype type, char *data, size_t size, void *userptr);
+
+    const TransferRequest request_;
+    CURL *curl_ { nullptr };
+    TransferResult result_;
+    DebugSink debugSink_;
+    QFile upload_;
+    qint64 uploadReadNs_ { 0 };
+    bool bodyReserved_ { false };
+    // 句柄在传输结束后就还给连接池，内存缓存的有效期要在归还前按响应头算好
+    qint64 memoryLifetimeMs_ { 0 };
+    std::atomic<bool> aborted_ { false };
+    // 开启传输时间线时才填充，传输结束后交给TransferTracer
+    bool tracing_ { false };
+    TransferTrace trace_;
+
+    // 进度槽，回调只写这里，不向界面发信号
+    std::atomic<qint64> downloaded_ { 0 };
+    std::atomic<qint64> downloadTotal_ { 0 };
+    std::atomic<qint64> uploaded_ { 0 };
+    std::atomic<qint64> uploadTotal_ { 0 };
+    std::atomic<qint64> downloadBytesPerSecond_ { 0 };
+    std::atomic<qint64> uploadBytesPerSecond_ { 0 };
+    // 瞬时速度的采样窗口，只在工作线程访问
+    QElapsedTimer rateTimer_;
+    qint64 rateWindowStartMs_ { 0 };
+    qint64 rateWindowStartDownloaded_ { 0 };
+    qint64 rateWindowStartUploaded_ { 0 };
+};
+
+#endif // TRANSFERCONTEXT_H
@@ -0,0 +1,64 @@
+#include "transfereventqueue.h"
+#include <cstring>
+
+bool TransferEventQueue::pushDebug(const QString &line)
+{
+    const QByteArray utf8 = line.toUtf8();
+    const quint32 needed = qMax<quint32>(1, static_cast<quint32>((utf8.size() + kTextBytes - 1) / kTextBytes));
+    const quint32 tail = tail_.load(std::memory_order_relaxed);
+    const quint32 head = head_.load(std::memory_order_acquire);
+    if (kCapacity - (tail - head) < needed) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // 按字节切分，多字节字符可能跨记录，消费者拼完整行后再解码
+    qsizetype offset = 0;
+    for (quint32 i = 0; i < needed; ++i) {
+        Record &record = records_[(tail + i) % kCapacity];
+        const qsizetype length = qMin<qsizetype>(kTextBytes, utf8.size() - offset);
+        std::memcpy(record.text, utf8.constData() + offset, static_cast<size_t>(length));
+        record.length = static_cast<quint16>(length);
+        record.continued = i + 1 < needed;
+        offset += length;
+    }
+    tail_.store(tail + needed, std::memory_order_release);
+    return true;
+}
+
+void TransferEventQueue::markFinished()
+{
+    finished_.store(true, std::memory_order_release);
+}
+
+bool TransferEventQueue::drain(QStringList *lines)
+{
+    // 先读结束标志：看到结束时，结束前写入的记录一定已经能从tail_读到
+    const bool finished = finished_.load(std::memory_order_acquire);
+    const quint32 tail = tail_.load(std::memory_order_acquire);
+    quint32 head = head_.load(std::memory_order_relaxed);
+    for (; head != tail; ++head) {
+        const Record &record = records_[head % kCapacity];
+        partial_.append(record.text, record.length);
+        if (!record.continued) {
+            lines->append(QString::fromUtf8(partial_));
+            partial_.clear();
+        }
+    }
+    head_.store(head, std::memory_order_release);
+
+    const quint32 dropped = dropped_.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        lines->append(QString("（调试输出过快，省略 %1 行）").arg(dropped));
+    }
+    return finished;
+}
+
+void TransferEventQueue::reset()
+{
+    tail_.store(0, std::memory_order_relaxed);
+    head_.store(0, std::memory_order_relaxed);
+    dropped_.store(0, std::memory_order_relaxed);
+    finished_.store(false, std::memory_order_relaxed);
+    partial_.clear();
+}
@@ -0,0 +1,56 @@
+#ifndef TRANSFEREVENTQUEUE_H
+#define TRANSFEREVENTQUEUE_H
+
+#include <QByteArray>
+#include <QStringList>
+#include <atomic>
+
+// 工作线程到界面线程的单生产者单消费者无锁事件环，每个进行中的传输占用一个。
+// 调试行按UTF-8拆成定长记录写入，长行占用多条连续记录；传输结束只置一个标志，不占记录。
+// 生产者不加锁也不向Qt事件队列投递，由调度器合并成一次唤醒后界面线程统一取出；
+// 环本身预先分配，生产者唯一的堆分配是把调试行转成UTF-8（调用方构造QString的开销另算）
+class TransferEventQueue
+{
+public:
+    // 512条记录共128 KB，放得下libcurl允许的最长单个头部（CURL_MAX_HTTP_HEADER，100 KB），
+    // 界面线程稍有延迟时一个完整的头部块也不会丢行。超出时有意丢弃而不是阻塞传输，
+    // 丢弃的行数会在下一次取出时报告
+    static constexpr quint32 kCapacity = 512;
+    static constexpr int kTextBytes = 250;
+    // 下标是不断递增的quint32，按kCapacity取模；容量是2的幂时，下标回绕到0后取模结果仍然连续
+    static_assert((kCapacity & (kCapacity - 1)) == 0, "kCapacity必须是2的幂");
+
+    TransferEventQueue() = default;
+    TransferEventQueue(const TransferEventQueue &) = delete;
+    TransferEventQueue &operator=(const TransferEventQueue &) = delete;
+
+    // 生产者（执行传输的工作线程）。环满时丢弃这一行并计数，不阻塞传输
+    bool pushDebug(const QString &line);
+    void markFinished();
+
+    // 消费者（界面线程）：取出已完整写入的调试行，返回传输是否已结束；
+    // 返回true时结束前写入的调试行都已取出
+    bool drain(QStringList *lines);
+    // 传输结束并取完后由消费者调用，之后可交给下一个传输
+    void reset();
+
+private:
+    struct Record
+    {
+        quint16 length;
+        // 这一行还没写完，下一条记录接在后面
+        bool    continued;
+        char    text[kTextBytes];
+    };
+
+    Record records_[kCapacity];
+    // 生产者只写tail_，消费者只写head_，分开放在不同缓存行上
+    alignas(64) std::atomic<quint32> tail_ { 0 };
+    alignas(64) std::atomic<quint32> head_ { 0 };
+    std::atomic<quint32> dropped_ { 0 };
+    std::atomic<bool> finished_ { false };
+    // 消费者拼接跨记录的长行
+    QByteArray partial_;
+};
+
+#endif // TRANSFEREVENTQUEUE_H
@@ -0,0 +1,369 @@
+#include "transferscheduler.h"
+#include "spanprofiler.h"
+#include <QUrl>
+#include <QtConcurrent>
+
+namespace {
+// 线程池上限只是兜底，实际并发由主机和代理两级上限控制
+constexpr int kMaxWorkers = 64;
+
+// 一次唤醒中从某个传输取出的调试行
+struct DebugBatch
+{
+    quint64 id;
+    QStringList lines;
+};
+}
+
+TransferScheduler::TransferScheduler(QObject *parent)
+    : QObject(parent)
+    , retryTimer_(new QTimer(this))
+{
+    workers_.setMaxThreadCount(kMaxWorkers);
+    clock_.start();
+    retryTimer_->setSingleShot(true);
+    connect(retryTimer_, &QTimer::timeout, this, &TransferScheduler::dispatch);
+}
+
+TransferScheduler::~TransferScheduler()
+{
+    cancelAll();
+    // 工作线程投递回来的唤醒随本对象一起丢弃，未取出的事件也不再报告
+    workers_.waitForDone();
+    for (const Running &running : active_) {
+        running.context->setDebugSink(nullptr);
+        delete running.queue;
+    }
+    qDeleteAll(idleQueues_);
+}
+
+void TransferScheduler::setLimits(const Limits &limits)
+{
+    limits_ = limits;
+    limits_.maxPerHost = qMax(1, limits_.maxPerHost);
+    limits_.maxPerProxy = qMax(1, limits_.maxPerProxy);
+    const qint64 now = clock_.elapsed();
+    for (HostState &host : hosts_) {
+        host.bucket.configure(limits_.hostRate, now);
+    }
+    for (ProxyState &proxy : proxies_) {
+        proxy.bucket.configure(limits_.proxyRate, now);
+    }
+    dispatch();
+}
+
+QString TransferScheduler::hostKey(const QString &url)
+{
+    const QUrl parsed(url);
+    const int defaultPort = parsed.scheme() == "http" ? 80 : 443;
+    return QString("%1:%2").arg(parsed.host().toLower()).arg(parsed.port(defaultPort));
+}
+
+QString TransferScheduler::proxyKey(const ProxyOptions &proxy)
+{
+    return QString("%1:%2").arg(proxy.host.toLower()).arg(proxy.port);
+}
+
+TransferScheduler::ProxyState &TransferScheduler::proxyState(const QString &key)
+{
+    auto it = proxies_.find(key);
+    if (it == proxies_.end()) {
+        ProxyState state;
+        state.bucket.configure(limits_.proxyRate, clock_.elapsed());
+        it = proxies_.insert(key, state);
+    }
+    return it.value();
+}
+
+bool TransferScheduler::HostState::isIdle() const
+{
+    if (running > 0) {
+        return false;
+    }
+    for (const QQueue<Job> &queue : queues) {
+        if (!queue.isEmpty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const char *TransferScheduler::priorityName(Priority priority)
+{
+    switch (priority) {
+    case Interactive:
+        return "交互";
+    case Normal:
+        return "普通";
+    case Background:
+        return "后台";
+    }
+    return "";
+}
+
+quint64 TransferScheduler::submit(const TransferRequest &request, Priority priority)
+{
+    return enqueue(QSharedPointer<TransferContext>(new TransferContext(request)), priority, false);
+}
+
+quint64 TransferScheduler::submit(const QSharedPointer<TransferContext> &context, Priority priority)
+{
+    return enqueue(context, priority, true);
+}
+
+quint64 TransferScheduler::enqueue(const QSharedPointer<TransferContext> &context, Priority priority,
+                                   bool forwardDebug)
+{
+    const quint64 id = ++nextId_;
+    const QString host = hostKey(context->request().url);
+    if (!hosts_.contains(host)) {
+        HostState state;
+        state.bucket.configure(limits_.hostRate, clock_.elapsed());
+        hosts_.insert(host, state);
+    }
+    if (!hostOrder_.contains(host)) {
+        hostOrder_ << host;
+    }
+    hosts_[host].queues[priority].enqueue(Job { id, context, clock_.elapsed(), forwardDebug });
+    dispatch();
+    return id;
+}
+
+void TransferScheduler::cancel(quint64 id)
+{
+    if (active_.contains(id)) {
+        active_.value(id).context->abort();
+        return;
+    }
+    for (HostState &host : hosts_) {
+        for (QQueue<Job> &queue : host.queues) {
+            for (int i = 0; i < queue.size(); ++i) {
+                if (queue.at(i).id == id) {
+                    queue.removeAt(i);
+                    return;
+                }
+            }
+        }
+    }
+}
+
+void TransferScheduler::cancel(const QSet<quint64> &ids)
+{
+    for (auto it = active_.cbegin(); it != active_.cend(); ++it) {
+        if (ids.contains(it.key())) {
+            it.value().context->abort();
+        }
+    }
+    for (HostState &host : hosts_) {
+        for (QQueue<Job> &queue : host.queues) {
+            queue.removeIf([&ids](const Job &job) { return ids.contains(job.id); });
+        }
+    }
+}
+
+void TransferScheduler::cancelAll()
+{
+    retryTimer_->stop();
+    for (HostState &host : hosts_) {
+        for (QQueue<Job> &queue : host.queues) {
+            queue.clear();
+        }
+    }
+    for (const Running &running : active_) {
+        running.context->abort();
+    }
+}
+
+int TransferScheduler::queuedCount() const
+{
+    int count = 0;
+    for (int priority = 0; priority < kPriorityCount; ++priority) {
+        count += queuedCount(static_cast<Priority>(priority));
+    }
+    return count;
+}
+
+int TransferScheduler::queuedCount(Priority priority) const
+{
+    int count = 0;
+    for (const HostState &host : hosts_) {
+        count += host.queues[priority].size();
+    }
+    return count;
+}
+
+QString TransferScheduler::describeStats() const
+{
+    QStringList parts;
+    for (int priority = 0; priority < kPriorityCount; ++priority) {
+        const QueueStats &s = stats_[priority];
+        if (s.dispatched == 0) {
+            continue;
+        }
+        parts << QString("%1 %2 次, 平均 %3 ms, 最长 %4 ms")
+                     .arg(priorityName(static_cast<Priority>(priority)))
+                     .arg(s.dispatched)
+                     .arg(s.totalWaitMs / s.dispatched)
+                     .arg(s.maxWaitMs);
+    }
+    return parts.isEmpty() ? QString() : QString("队列等待: %1").arg(parts.join("; "));
+}
+
+int TransferScheduler::hostCap(Priority priority) const
+{
+    // 交互请求可以在主机上限之外再多用预留的连接数
+    return priority == Interactive ? limits_.maxPerHost + limits_.reservedInteractive : limits_.maxPerHost;
+}
+
+int TransferScheduler::proxyCap(Priority priority) const
+{
+    if (priority == Interactive) {
+        return limits_.maxPerProxy;
+    }
+    return qMax(1, limits_.maxPerProxy - limits_.reservedInteractive);
+}
+
+void TransferScheduler::dispatch()
+{
+    ScopedSpan span("TransferScheduler::dispatch");
+    // 清理已经没有任务的主机，保持轮询列表短小
+    for (int i = hostOrder_.size() - 1; i >= 0; --i) {
+        if (hosts_[hostOrder_.at(i)].isIdle()) {
+            hosts_.remove(hostOrder_.at(i));
+            hostOrder_.removeAt(i);
+            for (int &cursor : cursors_) {
+                if (cursor > i) {
+                    --cursor;
+                }
+            }
+        }
+    }
+
+    const qint64 now = clock_.elapsed();
+    qint64 retryMs = -1;
+    for (int p = 0; p < kPriorityCount; ++p) {
+        const Priority priority = static_cast<Priority>(p);
+        int &cursor = cursors_[p];
+        bool launched = true;
+        while (launched && !hostOrder_.isEmpty()) {
+            launched = false;
+            // 每次只从一个主机发出一个任务，然后从下一个主机继续，实现公平轮询
+            for (int n = 0; n < hostOrder_.size(); ++n) {
+                const int index = (cursor + n) % hostOrder_.size();
+                const QString &key = hostOrder_.at(index);
+                HostState &host = hosts_[key];
+                QQueue<Job> &queue = host.queues[p];
+                if (queue.isEmpty() || host.running >= hostCap(priority)) {
+                    continue;
+                }
+                ProxyState &proxy = proxyState(proxyKey(queue.head().context->request().proxy));
+                if (proxy.running >= proxyCap(priority)) {
+                    continue;
+                }
+                // 交互请求不受速率限制，也不消耗令牌
+                if (priority != Interactive) {
+                    if (!host.bucket.available(now) || !proxy.bucket.available(now)) {
+                        const qint64 wait = qMax(host.bucket.msUntilAvailable(), proxy.bucket.msUntilAvailable());
+                        retryMs = retryMs < 0 ? wait : qMin(retryMs, wait);
+                        continue;
+                    }
+                    host.bucket.take();
+                    proxy.bucket.take();
+                }
+                launch(key, queue.dequeue(), priority, now);
+                cursor = (index + 1) % hostOrder_.size();
+                launched = true;
+                break;
+            }
+        }
+    }
+
+    // 只被令牌桶挡住时，等到最早有令牌的时刻再调度；并发上限由传输完成时重新调度
+    if (retryMs >= 0 && !retryTimer_->isActive()) {
+        retryTimer_->start(static_cast<int>(qMax<qint64>(1, retryMs)));
+    }
+}
+
+void TransferScheduler::launch(const QString &host, const Job &job, Priority priority, qint64 nowMs)
+{
+    QueueStats &stats = stats_[priority];
+    const qint64 waitMs = nowMs - job.enqueuedMs;
+    ++stats.dispatched;
+    stats.totalWaitMs += waitMs;
+    stats.maxWaitMs = qMax(stats.maxWaitMs, waitMs);
+
+    TransferEventQueue *queue = idleQueues_.isEmpty() ? new TransferEventQueue : idleQueues_.takeLast();
+    const QSharedPointer<TransferContext> context = job.context;
+    if (job.forwardDebug) {
+        context->setDebugSink([this, queue](const QString &line) {
+            if (queue->pushDebug(line)) {
+                wake();
+            }
+        });
+    }
+    const Running running { context, queue, host, proxyKey(context->request().proxy) };
+    active_.insert(job.id, running);
+    ++hosts_[host].running;
+    ++proxies_[running.proxy].running;
+    ++running_;
+
+    QtConcurrent::run(&workers_, [this, context, queue]() {
+        context->perform();
+        queue->markFinished();
+        wake();
+    });
+}
+
+void TransferScheduler::wake()
+{
+    if (!wakeupPending_.exchange(true, std::memory_order_acq_rel)) {
+        QMetaObject::invokeMethod(this, &TransferScheduler::drainEvents, Qt::QueuedConnection);
+    }
+}
+
+void TransferScheduler::drainEvents()
+{
+    ScopedSpan span("TransferScheduler::drainEvents");
+    // 先清除标志再取：取的过程中新写入的事件会再投递一次唤醒，不会漏掉
+    wakeupPending_.exchange(false, std::memory_order_acq_rel);
+
+    // 先全部取出再发信号，槽函数里提交新任务不会影响这里对active_的遍历
+    QList<DebugBatch> batches;
+    QList<quint64> finished;
+    for (auto it = active_.cbegin(); it != active_.cend(); ++it) {
+        QStringList lines;
+        if (it.value().queue->drain(&lines)) {
+            finished.append(it.key());
+        }
+        if (!lines.isEmpty()) {
+            batches.append({ it.key(), lines });
+        }
+    }
+    for (const DebugBatch &batch : batches) {
+        for (const QString &line : batch.lines) {
+            emit transferDebug(batch.id, line);
+        }
+    }
+    for (quint64 id : finished) {
+        onJobFinished(id, active_.take(id));
+    }
+}
+
+void TransferScheduler::onJobFinished(quint64 id, const Running &running)
+{
+    ScopedSpan span("TransferScheduler::onJobFinished");
+    // 工作线程已经结束，结果在界面线程上移出，不需要为每个传输投递一次结果
+    running.context->setDebugSink(nullptr);
+    QSharedPointer<TransferResult> result(new TransferResult(running.context->takeResult()));
+    running.queue->reset();
+    idleQueues_.append(running.queue);
+    --hosts_[running.host].running;
+    --proxies_[running.proxy].running;
+    --running_;
+
+    emit transferFinished(id, running.host, result);
+    dispatch();
+    if (running_ == 0 && queuedCount() == 0) {
+        emit idle();
+    }
+}
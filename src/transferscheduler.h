@@ -0,0 +1,148 @@
+#ifndef TRANSFERSCHEDULER_H
+#define TRANSFERSCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QQueue>
+#include <QSet>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+#include <atomic>
+#include "transfercontext.h"
+#include "tokenbucket.h"
+#include "transfereventqueue.h"
+
+// 传输调度器，位于传输引擎之前：
+// 每个目标主机按优先级各一个队列，高优先级先出队，同一优先级内按主机轮询，单个大主机不会饿死其他主机；
+// 发出前检查主机和代理两级的并发上限与令牌桶，不超过代理的连接限制。
+// 交互请求不受令牌桶限制，并在每个代理上预留连接，不会排在成千上万个批量请求之后。
+// 只在界面线程使用，传输本身在内部线程池上执行
+class TransferScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum Priority { Interactive, Normal, Background };
+    static constexpr int kPriorityCount = 3;
+
+    struct Limits
+    {
+        int maxPerHost { 4 };
+        int maxPerProxy { 16 };
+        // 每秒请求数，0表示不限速
+        double hostRate { 0 };
+        double proxyRate { 0 };
+        // 每个代理为交互请求保留的连接数，其他优先级不能占用
+        int reservedInteractive { 2 };
+    };
+
+    // 每个优先级的排队统计
+    struct QueueStats
+    {
+        qint64 dispatched { 0 };
+        qint64 totalWaitMs { 0 };
+        qint64 maxWaitMs { 0 };
+    };
+
+    explicit TransferScheduler(QObject *parent = nullptr);
+    ~TransferScheduler() override;
+
+    void setLimits(const Limits &limits);
+    const Limits &limits() const { return limits_; }
+
+    // 加入队列，返回任务ID
+    quint64 submit(const TransferRequest &request, Priority priority = Normal);
+    // 调用方需要在传输过程中访问上下文（进度、调试输出）时，自己创建后交给调度器；
+    // 这样提交的传输，调试输出经transferDebug信号在界面线程送出
+    quint64 submit(const QSharedPointer<TransferContext> &context, Priority priority = Normal);
+    // 排队中的任务直接移除（不再报告结果），进行中的传输中止
+    void cancel(quint64 id);
+    // 同上，一次取消一批任务，只遍历一遍队列；其他任务不受影响
+    void cancel(const QSet<quint64> &ids);
+    // 丢弃排队中的任务并中止进行中的传输，被中止的传输仍会报告结果
+    void cancelAll();
+
+    int queuedCount() const;
+    int queuedCount(Priority priority) const;
+    int runningCount() const { return running_; }
+    QueueStats stats(Priority priority) const { return stats_[priority]; }
+    // 各优先级的排队等待统计，用于调试输出
+    QString describeStats() const;
+
+    static const char *priorityName(Priority priority);
+    // 目标主机键（host:port），用于统计
+    static QString hostKey(const QString &url);
+
+signals:
+    void transferDebug(quint64 id, const QString &line);
+    void transferFinished(quint64 id, const QString &host, const QSharedPointer<TransferResult> &result);
+    // 队列清空且没有进行中的传输
+    void idle();
+
+private:
+    struct Job
+    {
+        quint64 id;
+        QSharedPointer<TransferContext> context;
+        qint64 enqueuedMs;
+        bool forwardDebug;
+    };
+
+    // 进行中的传输；queue由执行它的工作线程写入、界面线程取出
+    struct Running
+    {
+        QSharedPointer<TransferContext> context;
+        TransferEventQueue *queue;
+        QString host;
+        QString proxy;
+    };
+
+    struct HostState
+    {
+        QQueue<Job> queues[kPriorityCount];
+        int running { 0 };
+        TokenBucket bucket;
+
+        bool isIdle() const;
+    };
+
+    struct ProxyState
+    {
+        int running { 0 };
+        TokenBucket bucket;
+    };
+
+    static QString proxyKey(const ProxyOptions &proxy);
+    ProxyState &proxyState(const QString &key);
+    int hostCap(Priority priority) const;
+    int proxyCap(Priority priority) const;
+    quint64 enqueue(const QSharedPointer<TransferContext> &context, Priority priority, bool forwardDebug);
+    void dispatch();
+    void launch(const QString &host, const Job &job, Priority priority, qint64 nowMs);
+    // 工作线程调用：已有唤醒在途时不再投递，多个事件合并成一次处理
+    void wake();
+    // 界面线程：取出所有进行中传输的事件，处理已结束的传输
+    void drainEvents();
+    void onJobFinished(quint64 id, const Running &running);
+
+    Limits limits_;
+    QThreadPool workers_;
+    QElapsedTimer clock_;
+    QTimer *retryTimer_;
+    QHash<QString, HostState> hosts_;
+    // 有排队或进行中任务的主机，按加入顺序轮询；每个优先级有自己的轮询位置
+    QStringList hostOrder_;
+    int cursors_[kPriorityCount] {};
+    QHash<QString, ProxyState> proxies_;
+    QHash<quint64, Running> active_;
+    // 空闲的事件环，传输结束后回收，数量不超过同时进行的传输数
+    QList<TransferEventQueue *> idleQueues_;
+    std::atomic<bool> wakeupPending_ { false };
+    QueueStats stats_[kPriorityCount];
+    quint64 nextId_ { 0 };
+    int running_ { 0 };
+};
+
+#endif // TRANSFERSCHEDULER_H
@@ -0,0 +1,310 @@
+#include "transfertracer.h"
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <atomic>
+
+namespace {
+// 最多保留的传输数，批量请求跑很久时只保留最近的
+constexpr int kMaxTransfers = 10'000;
+// 所有保留传输的事件总数上限，大传输多时按这个淘汰，内存不随传输数×事件数增长（每个事件约50字节）
+constexpr qint64 kMaxTotalEvents = 500'000;
+// 每个传输最多记录的数据块事件数，之后的数据块只累加到计数里
+constexpr int kMaxChunkEvents = 256;
+// trace event JSON中传输轨道所在的进程号
+constexpr int kTransferPid = 1;
+
+std::atomic<bool> g_enabled { false };
+std::atomic<quint64> g_nextId { 0 };
+QMutex g_mutex;
+QList<TransferTrace> g_traces;
+qint64 g_eventCount = 0;
+
+// 耗时剖析在热路径上读时钟，只靠局部静态变量的线程安全初始化，读取时不加锁
+const QElapsedTimer &traceClock()
+{
+    static const QElapsedTimer clock = [] {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    }();
+    return clock;
+}
+
+QJsonObject traceEvent(const QString &name, const char *phase, qint64 nsecs, quint64 tid)
+{
+    QJsonObject event;
+    event.insert("name", name);
+    event.insert("cat", "transfer");
+    event.insert("ph", phase);
+    event.insert("ts", nsecs / 1000.0);
+    event.insert("pid", kTransferPid);
+    event.insert("tid", static_cast<qint64>(tid));
+    return event;
+}
+
+QJsonObject spanEvent(const QString &name, qint64 beginNs, qint64 endNs, quint64 tid, const QString &detail)
+{
+    QJsonObject event = traceEvent(name, "X", beginNs, tid);
+    event.insert("dur", qMax<qint64>(0, endNs - beginNs) / 1000.0);
+    if (!detail.isEmpty()) {
+        QJsonObject args;
+        args.insert("detail", detail);
+        event.insert("args", args);
+    }
+    return event;
+}
+}
+
+TransferTrace::TransferTrace(quint64 id, const QString &label)
+    : id_(id)
+    , label_(label)
+    , startNs_(TransferTracer::nowNs())
+{
+}
+
+void TransferTrace::add(EventType type, qint64 bytes, const QString &detail)
+{
+    events_.append({ type, TransferTracer::nowNs(), bytes, detail });
+}
+
+void TransferTrace::onCurlDebug(curl_infotype type, const char *data, size_t size)
+{
+    switch (type) {
+    case CURLINFO_TEXT: {
+        const QString text = QString::fromUtf8(data, static_cast<qsizetype>(size)).trimmed();
+        if (text.startsWith("Trying ")) {
+            add(ConnectStart, 0, text.mid(7));
+        } else if (text.startsWith("Connected to ")) {
+            add(Connected, 0, text.mid(13));
+        } else if (text.startsWith("Re-using existing") || text.startsWith("Reusing existing")) {
+            add(Reused, 0, text);
+        } else if (text.contains("SSL connection using")) {
+            add(TlsDone, 0, text.mid(text.indexOf("SSL connection using") + 21));
+        }
+        break;
+    }
+    case CURLINFO_HEADER_OUT:
+        // 请求头整块交给回调，第一行就是请求行
+        if (size >= 8 && qstrncmp(data, "CONNECT ", 8) == 0) {
+            connectSent_ = true;
+            add(ConnectSent);
+        } else if (!requestSent_) {
+            requestSent_ = true;
+            const QByteArray block(data, static_cast<qsizetype>(size));
+            add(RequestSent, static_cast<qint64>(size), QString::fromLatin1(block.left(block.indexOf('\r'))));
+        }
+        break;
+    case CURLINFO_HEADER_IN:
+        // 响应头逐行到达，只关心状态行
+        if (size >= 5 && qstrncmp(data, "HTTP/", 5) == 0) {
+            const QString statusLine = QString::fromLatin1(data, static_cast<qsizetype>(size)).trimmed();
+            if (connectSent_ && !connectReceived_ && !requestSent_) {
+                connectReceived_ = true;
+                add(ConnectReceived, 0, statusLine);
+            } else if (requestSent_ && !firstByte_) {
+                firstByte_ = true;
+                add(FirstByte, 0, statusLine);
+            }
+        }
+        break;
+    case CURLINFO_DATA_IN:
+    case CURLINFO_DATA_OUT:
+        (type == CURLINFO_DATA_IN ? bytesIn_ : bytesOut_) += static_cast<qint64>(size);
+        if (chunks_ < kMaxChunkEvents) {
+            ++chunks_;
+            add(type == CURLINFO_DATA_IN ? DataIn : DataOut, static_cast<qint64>(size));
+        } else {
+            ++droppedChunks_;
+        }
+        break;
+    default:
+        // TLS记录（SSL_DATA_*）数量多且与阶段划分无关
+        break;
+    }
+}
+
+void TransferTrace::finish(CURLcode code, long status)
+{
+    add(Done, 0, code == CURLE_OK ? QString("HTTP %1").arg(status) : QString::fromUtf8(curl_easy_strerror(code)));
+}
+
+void TransferTracer::setEnabled(bool enabled)
+{
+    g_enabled = enabled;
+}
+
+bool TransferTracer::isEnabled()
+{
+    return g_enabled;
+}
+
+qint64 TransferTracer::nowNs()
+{
+    return traceClock().nsecsElapsed();
+}
+
+quint64 TransferTracer::nextTransferId()
+{
+    return ++g_nextId;
+}
+
+void TransferTracer::record(TransferTrace &&trace)
+{
+    QMutexLocker locker(&g_mutex);
+    g_eventCount += trace.events().size();
+    g_traces.append(std::move(trace));
+    // 至少保留刚记录的这一个
+    while (g_traces.size() > 1 && (g_traces.size() > kMaxTransfers || g_eventCount > kMaxTotalEvents)) {
+        g_eventCount -= g_traces.constFirst().events().size();
+        g_traces.removeFirst();
+    }
+}
+
+int TransferTracer::transferCount()
+{
+    QMutexLocker locker(&g_mutex);
+    return static_cast<int>(g_traces.size());
+}
+
+void TransferTracer::clear()
+{
+    QMutexLocker locker(&g_mutex);
+    g_traces.clear();
+    g_eventCount = 0;
+}
+
+QJsonArray TransferTracer::chromeTraceEvents()
+{
+    QList<TransferTrace> traces;
+    {
+        QMutexLocker locker(&g_mutex);
+        traces = g_traces;
+    }
+
+    QJsonArray events;
+    QJsonObject processName = traceEvent("process_name", "M", 0, 0);
+    processName.insert("args", QJsonObject { { "name", "传输" } });
+    events.append(processName);
+
+    for (const TransferTrace &trace : traces) {
+        const quint64 tid = trace.id();
+        QJsonObject threadName = traceEvent("thread_name", "M", 0, tid);
+        threadName.insert("args", QJsonObject { { "name", QString("#%1 %2").arg(tid).arg(trace.label()) } });
+        events.append(threadName);
+
+        // 相邻的边界事件两两组成阶段；TLS阶段从TCP连接建立或隧道建立的时刻算起。
+        // 代理总是HTTPS，隧道建立之前的握手属于代理，之后的属于目标
+        qint64 connectStart = -1;
+        qint64 tlsStart = -1;
+        qint64 connectSent = -1;
+        qint64 requestSent = -1;
+        qint64 firstByte = -1;
+        bool tunnelled = false;
+        QString result;
+        qint64 endNs = trace.startNs();
+        for (const TransferTrace::Event &e : trace.events()) {
+            endNs = e.nsecs;
+            switch (e.type) {
+            case TransferTrace::ConnectStart:
+                connectStart = e.nsecs;
+                break;
+            case TransferTrace::Connected:
+                if (connectStart >= 0) {
+                    events.append(spanEvent("TCP连接", connectStart, e.nsecs, tid, e.detail));
+                }
+                tlsStart = e.nsecs;
+                break;
+            case TransferTrace::Reused:
+                events.append(traceEvent("复用连接", "i", e.nsecs, tid));
+                break;
+            case TransferTrace::TlsDone:
+                if (tlsStart >= 0) {
+                    events.append(spanEvent(tunnelled ? "TLS握手（目标）" : "TLS握手（代理）", tlsStart, e.nsecs,
+                                            tid, e.detail));
+                    tlsStart = -1;
+                }
+                break;
+            case TransferTrace::ConnectSent:
+                connectSent = e.nsecs;
+                break;
+            case TransferTrace::ConnectReceived:
+                if (connectSent >= 0) {
+                    events.append(spanEvent("CONNECT隧道", connectSent, e.nsecs, tid, e.detail));
+                }
+                tunnelled = true;
+                tlsStart = e.nsecs;
+                break;
+            case TransferTrace::RequestSent:
+                requestSent = e.nsecs;
+                events.append(spanEvent("发送请求头", e.nsecs, e.nsecs, tid, e.detail));
+                break;
+            case TransferTrace::FirstByte:
+                firstByte = e.nsecs;
+                if (requestSent >= 0) {
+                    events.append(spanEvent("等待首字节", requestSent, e.nsecs, tid, e.detail));
+                }
+                break;
+            case TransferTrace::DataIn:
+            case TransferTrace::DataOut: {
+                const bool in = e.type == TransferTrace::DataIn;
+                QJsonObject chunk = traceEvent(in ? "收到数据" : "发送数据", "i", e.nsecs, tid);
+                chunk.insert("s", "t");
+                chunk.insert("args", QJsonObject { { "bytes", e.bytes } });
+                events.append(chunk);
+                break;
+            }
+            case TransferTrace::Done:
+                if (firstByte >= 0) {
+                    events.append(spanEvent("接收响应", firstByte, e.nsecs, tid, QString()));
+                }
+                result = e.detail;
+                break;
+            }
+        }
+
+        QJsonObject whole = spanEvent(trace.label(), trace.startNs(), endNs, tid, result);
+        QJsonObject args;
+        args.insert("result", result);
+        args.insert("bytes_in", trace.bytesIn());
+        args.insert("bytes_out", trace.bytesOut());
+        if (trace.droppedChunks() > 0) {
+            args.insert("dropped_chunk_events", trace.droppedChunks());
+        }
+        whole.insert("args", args);
+        events.append(whole);
+    }
+    return events;
+}
+
+bool TransferTracer::exportChromeTrace(const QString &path, QString *error)
+{
+    return writeChromeTrace(path, chromeTraceEvents(), error);
+}
+
+bool TransferTracer::writeChromeTrace(const QString &path, const QJsonArray &events, QString *error)
+{
+    QJsonObject root;
+    root.insert("traceEvents", events);
+    root.insert("displayTimeUnit", "ms");
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,90 @@
+#ifndef TRANSFERTRACER_H
+#define TRANSFERTRACER_H
+
+#include <QJsonArray>
+#include <QList>
+#include <QString>
+#include <curl/curl.h>
+
+// 单个传输的时间线，由CURLOPT_DEBUGFUNCTION的回调填充，只在执行传输的工作线程上访问
+class TransferTrace
+{
+public:
+    enum EventType {
+        ConnectStart,     // 开始TCP连接（"Trying ..."）
+        Connected,        // TCP连接建立
+        Reused,           // 复用已有连接，没有连接和握手阶段
+        TlsDone,          // TLS握手完成；CONNECT之前的是与代理的握手，隧道建立之后的是与https目标的握手
+        ConnectSent,      // 发出CONNECT请求
+        ConnectReceived,  // 收到代理对CONNECT的响应
+        RequestSent,      // 发出请求头
+        FirstByte,        // 收到响应状态行
+        DataIn,
+        DataOut,
+        Done
+    };
+
+    struct Event
+    {
+        EventType type;
+        qint64    nsecs;
+        qint64    bytes;
+        QString   detail;
+    };
+
+    TransferTrace() = default;
+    TransferTrace(quint64 id, const QString &label);
+
+    quint64 id() const { return id_; }
+    const QString &label() const { return label_; }
+    qint64 startNs() const { return startNs_; }
+    const QList<Event> &events() const { return events_; }
+    // 数据块太多时只保留前面的事件，后面的只计入块数和字节数
+    qint64 droppedChunks() const { return droppedChunks_; }
+    // 收发的总字节数，包括没有保留事件的数据块
+    qint64 bytesIn() const { return bytesIn_; }
+    qint64 bytesOut() const { return bytesOut_; }
+
+    void onCurlDebug(curl_infotype type, const char *data, size_t size);
+    void finish(CURLcode code, long status);
+
+private:
+    void add(EventType type, qint64 bytes = 0, const QString &detail = QString());
+
+    quint64 id_ { 0 };
+    QString label_;
+    qint64 startNs_ { 0 };
+    QList<Event> events_;
+    int chunks_ { 0 };
+    qint64 droppedChunks_ { 0 };
+    qint64 bytesIn_ { 0 };
+    qint64 bytesOut_ { 0 };
+    bool connectSent_ { false };
+    bool connectReceived_ { false };
+    bool requestSent_ { false };
+    bool firstByte_ { false };
+};
+
+// 全局的传输时间线记录器。开启后每个TransferContext打开CURLOPT_VERBOSE并把时间线交到这里，
+// 可导出为Chrome/Perfetto的trace event JSON，每个传输一条轨道，便于在同一时间轴上比较大量并发传输
+class TransferTracer
+{
+public:
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+    // 所有时间线共用的单调时钟（纳秒，从进程内第一次调用起算）
+    static qint64 nowNs();
+    static quint64 nextTransferId();
+
+    // 可在任意线程调用；传输数或所有传输的事件总数超过上限时丢弃最早的传输
+    static void record(TransferTrace &&trace);
+    static int transferCount();
+    static void clear();
+
+    static bool exportChromeTrace(const QString &path, QString *error = nullptr);
+    // 已记录传输的trace event数组，供其他记录器合并到同一个文件
+    static QJsonArray chromeTraceEvents();
+    static bool writeChromeTrace(const QString &path, const QJsonArray &events, QString *error = nullptr);
+};
+
+#endif // TRANSFERTRACER_H
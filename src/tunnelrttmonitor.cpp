@@ -0,0 +1,119 @@
+#include "tunnelrttmonitor.h"
+#include "websocketconnection.h"
+#include <QElapsedTimer>
+#include <QMetaObject>
+#include <QtEndian>
+
+namespace {
+// 等待下一次ping时的最长睡眠，保证stop()能及时生效
+constexpr qint64 kStopPollMs = 50;
+}
+
+TunnelRttMonitor::TunnelRttMonitor(QObject *parent)
+    : QObject(parent)
+{
+}
+
+TunnelRttMonitor::~TunnelRttMonitor()
+{
+    // 工作线程访问本对象，必须等它结束；连接设置了中止标志，最多再阻塞一个轮询间隔
+    stop_ = true;
+    if (worker_) {
+        worker_->wait();
+    }
+}
+
+void TunnelRttMonitor::start(const Config &config)
+{
+    if (running_) {
+        return;
+    }
+
+    running_ = true;
+    stop_ = false;
+    stopReason_.clear();
+    QThread *thread = QThread::create([this, config]() { run(config); });
+    // 线程真正退出后才允许重新开始，不会有两个监视线程同时运行
+    connect(thread, &QThread::finished, this, [this]() {
+        running_ = false;
+        emit stopped(stopReason_);
+    });
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    worker_ = thread;
+    thread->start();
+}
+
+void TunnelRttMonitor::stop()
+{
+    stop_ = true;
+}
+
+void TunnelRttMonitor::run(const Config &config)
+{
+    WebSocketConnection connection;
+    connection.setAbortFlag(&stop_);
+    if (!connection.open(config.proxy, config.url)) {
+        stopReason_ = stop_ ? QString() : connection.errorString();
+        return;
+    }
+    const qint64 handshakeMs = connection.handshakeMs();
+    QMetaObject::invokeMethod(this, [this, handshakeMs]() { emit connected(handshakeMs); }, Qt::QueuedConnection);
+
+    QElapsedTimer clock;
+    clock.start();
+    qint64 nextPingMs = 0;
+    quint64 sequence = 0;
+    QString error;
+
+    while (!stop_) {
+        const qint64 waitMs = nextPingMs - clock.elapsed();
+        if (waitMs > 0) {
+            QThread::msleep(static_cast<unsigned long>(qMin(waitMs, kStopPollMs)));
+            continue;
+        }
+        // 落后时不补发，从当前时刻重新对齐间隔
+        nextPingMs = qMax(nextPingMs + config.intervalMs, clock.elapsed());
+
+        ++sequence;
+        char payload[sizeof(quint64)];
+        qToBigEndian(sequence, payload);
+        const qint64 sentNs = clock.nsecsElapsed();
+        if (!connection.send(QByteArray(payload, sizeof(payload)), CURLWS_PING)) {
+            error = connection.errorString();
+            break;
+        }
+
+        // 等待对应序号的pong，迟到的旧pong和其他数据帧忽略
+        double rttMs = -1;
+        WebSocketConnection::Frame frame;
+        for (;;) {
+            const qint64 remainingMs = config.timeoutMs - (clock.nsecsElapsed() - sentNs) / 1'000'000;
+            if (remainingMs <= 0) {
+                break;
+            }
+            if (!connection.receive(&frame, static_cast<int>(remainingMs))) {
+                error = connection.errorString();
+                break;
+            }
+            if (frame.flags & CURLWS_CLOSE) {
+                error = "服务器关闭了连接";
+                break;
+            }
+            if ((frame.flags & CURLWS_PONG) && frame.payload.size() == sizeof(quint64)
+                && qFromBigEndian<quint64>(frame.payload.constData()) == sequence) {
+                rttMs = (clock.nsecsElapsed() - sentNs) / 1e6;
+                break;
+            }
+        }
+        if (!error.isEmpty()) {
+            break;
+        }
+
+        QMetaObject::invokeMethod(this, [this, sequence, rttMs]() { emit sampled(sequence, rttMs); },
+                                  Qt::QueuedConnection);
+    }
+
+    connection.close();
+    // 被stop()中止的收发也会报错，这种情况按正常结束处理
+    stopReason_ = stop_ ? QString() : error;
+}
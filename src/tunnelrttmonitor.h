@@ -0,0 +1,50 @@
+#ifndef TUNNELRTTMONITOR_H
+#define TUNNELRTTMONITOR_H
+
+#include <QObject>
+#include <QPointer>
+#include <QThread>
+#include <atomic>
+#include "proxyoptions.h"
+
+// 保持一条经代理隧道的WebSocket长连接，按固定间隔发送ping并测量pong往返时间。
+// 握手只在开始时发生一次，之后的样本只包含代理转发和网络本身的延迟
+class TunnelRttMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    struct Config
+    {
+        ProxyOptions proxy;
+        QString url;
+        int intervalMs { 1000 };
+        int timeoutMs { 3000 };
+    };
+
+    explicit TunnelRttMonitor(QObject *parent = nullptr);
+    ~TunnelRttMonitor() override;
+
+    void start(const Config &config);
+    // 只请求停止，不等待：工作线程退出后发出stopped，此前isRunning()仍为true
+    void stop();
+    bool isRunning() const { return running_; }
+
+signals:
+    void connected(qint64 handshakeMs);
+    // rttMs小于0表示在超时时间内没有收到pong
+    void sampled(quint64 sequence, double rttMs);
+    // reason为空表示被stop()正常结束
+    void stopped(const QString &reason);
+
+private:
+    void run(const Config &config);
+
+    // 线程结束后自行deleteLater，QPointer随之清空
+    QPointer<QThread> worker_;
+    std::atomic<bool> stop_ { false };
+    bool running_ { false };
+    // 工作线程退出前写入，界面线程在QThread::finished之后读取
+    QString stopReason_;
+};
+
+#endif // TUNNELRTTMONITOR_H
@@ -0,0 +1,220 @@
+#include "websocketbenchmark.h"
+#include <QElapsedTimer>
+#include <QMetaObject>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// 负载前8字节是序号，用来确认收到的是哪一条消息的回显
+constexpr int kSequenceBytes = 8;
+constexpr int kWarmupMessages = 5;
+constexpr int kEchoTimeoutMs = 5'000;
+// 流水线阶段在途字节上限：发送时不读回显，在途过多会填满双方的套接字缓冲区而互相阻塞
+constexpr int kMaxInFlightBytes = 64 * 1024;
+}
+
+QList<int> WebSocketBenchmark::defaultPayloadSizes()
+{
+    return { 16, 256, 1024, 4 * 1024, 16 * 1024 };
+}
+
+WebSocketBenchmark::WebSocketBenchmark(QObject *parent)
+    : QObject(parent)
+{
+}
+
+WebSocketBenchmark::~WebSocketBenchmark()
+{
+    // 工作线程访问本对象，必须等它结束；设置了中止标志，收发最多再阻塞一个轮询间隔
+    cancel_ = true;
+    if (worker_) {
+        worker_->wait();
+    }
+}
+
+void WebSocketBenchmark::start(const Config &config)
+{
+    if (running_) {
+        return;
+    }
+
+    running_ = true;
+    cancel_ = false;
+
+    QThread *thread = QThread::create([this, config]() { runAll(config); });
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    worker_ = thread;
+    thread->start();
+}
+
+void WebSocketBenchmark::cancel()
+{
+    cancel_ = true;
+}
+
+void WebSocketBenchmark::post(const QString &message)
+{
+    QMetaObject::invokeMethod(this, [this, message]() { emit sample(message); }, Qt::QueuedConnection);
+}
+
+QByteArray WebSocketBenchmark::makePayload(int size, quint64 sequence)
+{
+    QByteArray payload(size, 'x');
+    qToBigEndian(sequence, payload.data());
+    return payload;
+}
+
+double WebSocketBenchmark::percentileMs(const QList<qint64> &sortedNs, double fraction)
+{
+    if (sortedNs.isEmpty()) {
+        return 0;
+    }
+    // 最近秩法：第ceil(p*n)个样本
+    const qsizetype rank = static_cast<qsizetype>(std::ceil(fraction * sortedNs.size()));
+    return sortedNs.at(qBound<qsizetype>(0, rank - 1, sortedNs.size() - 1)) / 1e6;
+}
+
+bool WebSocketBenchmark::awaitEcho(WebSocketConnection &connection, int payloadSize, quint64 sequence, QString *error)
+{
+    WebSocketConnection::Frame frame;
+    for (;;) {
+        if (!connection.receive(&frame, kEchoTimeoutMs)) {
+            *error = connection.errorString().isEmpty() ? QString("等待回显超时") : connection.errorString();
+            return false;
+        }
+        if (frame.flags & CURLWS_CLOSE) {
+            *error = "服务器关闭了连接";
+            return false;
+        }
+        if (frame.flags & (CURLWS_PING | CURLWS_PONG)) {
+            continue;
+        }
+        if (frame.payload.size() != payloadSize
+            || qFromBigEndian<quint64>(frame.payload.constData()) != sequence) {
+            *error = QString("回显内容不匹配（期望序号 %1，收到 %2 字节）").arg(sequence).arg(frame.payload.size());
+            return false;
+        }
+        return true;
+    }
+}
+
+WebSocketBenchmark::SizeResult WebSocketBenchmark::runSize(WebSocketConnection &connection, const Config &config,
+                                                           int payloadSize)
+{
+    SizeResult result;
+    result.payloadSize = payloadSize;
+    quint64 sequence = 0;
+
+    // 延迟阶段：一次只有一条消息在途
+    QList<qint64> rtts;
+    rtts.reserve(config.messagesPerSize);
+    QElapsedTimer timer;
+    for (int i = 0; i < kWarmupMessages + config.messagesPerSize && !cancel_; ++i) {
+        const QByteArray payload = makePayload(payloadSize, ++sequence);
+        timer.start();
+        if (!connection.send(payload, CURLWS_BINARY)) {
+            result.error = connection.errorString();
+            return result;
+        }
+        if (!awaitEcho(connection, payloadSize, sequence, &result.error)) {
+            return result;
+        }
+        if (i >= kWarmupMessages) {
+            rtts << timer.nsecsElapsed();
+        }
+    }
+    if (rtts.isEmpty()) {
+        return result;
+    }
+    std::sort(rtts.begin(), rtts.end());
+    result.messages = rtts.size();
+    result.minMs = rtts.first() / 1e6;
+    result.p50Ms = percentileMs(rtts, 0.50);
+    result.p90Ms = percentileMs(rtts, 0.90);
+    result.p99Ms = percentileMs(rtts, 0.99);
+    result.maxMs = rtts.last() / 1e6;
+    post(QString("  %1 B: p50 %2 ms, p99 %3 ms")
+             .arg(payloadSize)
+             .arg(result.p50Ms, 0, 'f', 2)
+             .arg(result.p99Ms, 0, 'f', 2));
+
+    // 吞吐阶段：保持pipelineDepth条消息在途，回显按发送顺序到达
+    const quint64 first = sequence + 1;
+    const int total = config.messagesPerSize;
+    const int depth = qBound(1, kMaxInFlightBytes / payloadSize, config.pipelineDepth);
+    result.pipelineDepth = depth;
+    int sent = 0;
+    int received = 0;
+    timer.start();
+    while (received < total && !cancel_) {
+        while (sent < total && sent - received < depth) {
+            if (!connection.send(makePayload(payloadSize, first + sent), CURLWS_BINARY)) {
+                result.error = connection.errorString();
+                return result;
+            }
+            ++sent;
+        }
+        if (!awaitEcho(connection, payloadSize, first + received, &result.error)) {
+            return result;
+        }
+        ++received;
+    }
+    const double seconds = timer.nsecsElapsed() / 1e9;
+    if (received > 0 && seconds > 0) {
+        result.messagesPerSecond = received / seconds;
+        result.mbps = result.messagesPerSecond * payloadSize / (1024.0 * 1024.0);
+    }
+    return result;
+}
+
+void WebSocketBenchmark::runAll(const Config &config)
+{
+    QString summary = "=== WebSocket回显测试结果 ===\n";
+    WebSocketConnection connection;
+    connection.setAbortFlag(&cancel_);
+    if (!connection.open(config.proxy, config.url)) {
+        if (!cancel_) {
+            summary += "连接失败: " + connection.errorString() + "\n";
+        }
+    } else {
+        post(QString("WebSocket已连接 %1，握手耗时 %2 ms").arg(config.url).arg(connection.handshakeMs()));
+        summary += QString("握手（隧道+TLS+升级）: %1 ms\n").arg(connection.handshakeMs());
+
+        for (int size : config.payloadSizes) {
+            if (cancel_) {
+                break;
+            }
+            const int payloadSize = qMax(kSequenceBytes, size);
+            const SizeResult r = runSize(connection, config, payloadSize);
+            if (cancel_) {
+                break;
+            }
+            summary += QString("%1 B: ").arg(payloadSize, 6);
+            if (!r.error.isEmpty()) {
+                summary += "失败: " + r.error + "\n";
+                // 回显流已错位，后续结果没有意义
+                break;
+            }
+            summary += QString("RTT min %1 / p50 %2 / p90 %3 / p99 %4 / max %5 ms; 流水线(%6) %7 msg/s, %8 MB/s\n")
+                           .arg(r.minMs, 0, 'f', 2)
+                           .arg(r.p50Ms, 0, 'f', 2)
+                           .arg(r.p90Ms, 0, 'f', 2)
+                           .arg(r.p99Ms, 0, 'f', 2)
+                           .arg(r.maxMs, 0, 'f', 2)
+                           .arg(r.pipelineDepth)
+                           .arg(r.messagesPerSecond, 0, 'f', 0)
+                           .arg(r.mbps, 0, 'f', 2);
+        }
+        connection.close();
+    }
+    if (cancel_) {
+        summary += "测试已取消\n";
+    }
+
+    QMetaObject::invokeMethod(this, [this, summary]() {
+        running_ = false;
+        worker_ = nullptr;
+        emit testFinished(summary);
+    }, Qt::QueuedConnection);
+}
@@ -0,0 +1,72 @@
+#ifndef WEBSOCKETBENCHMARK_H
+#define WEBSOCKETBENCHMARK_H
+
+#include <QObject>
+#include <QList>
+#include <QPointer>
+#include <QThread>
+#include <atomic>
+#include "proxyoptions.h"
+#include "websocketconnection.h"
+
+// 经代理隧道连接WebSocket回显服务，按不同负载大小测量消息往返延迟分位数和每秒消息数
+class WebSocketBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    struct Config
+    {
+        ProxyOptions proxy;
+        QString url;
+        QList<int> payloadSizes;
+        int messagesPerSize { 200 };
+        // 吞吐阶段同时在途的消息数
+        int pipelineDepth { 16 };
+    };
+
+    static QList<int> defaultPayloadSizes();
+
+    explicit WebSocketBenchmark(QObject *parent = nullptr);
+    ~WebSocketBenchmark() override;
+
+    void start(const Config &config);
+    // 只请求停止，不等待：工作线程在当前收发返回后结束，结果仍经testFinished送出
+    void cancel();
+    bool isRunning() const { return running_; }
+
+signals:
+    void sample(const QString &message);
+    void testFinished(const QString &summary);
+
+private:
+    struct SizeResult
+    {
+        int    payloadSize { 0 };
+        int    messages { 0 };
+        double minMs { 0 };
+        double p50Ms { 0 };
+        double p90Ms { 0 };
+        double p99Ms { 0 };
+        double maxMs { 0 };
+        int    pipelineDepth { 0 };
+        double messagesPerSecond { 0 };
+        double mbps { 0 };
+        QString error;
+    };
+
+    void runAll(const Config &config);
+    SizeResult runSize(WebSocketConnection &connection, const Config &config, int payloadSize);
+    // 等待序号为sequence的回显，期间收到的ping/pong等控制帧跳过
+    bool awaitEcho(WebSocketConnection &connection, int payloadSize, quint64 sequence, QString *error);
+    void post(const QString &message);
+
+    static QByteArray makePayload(int size, quint64 sequence);
+    static double percentileMs(const QList<qint64> &sortedNs, double fraction);
+
+    // 线程结束后自行deleteLater，QPointer随之清空
+    QPointer<QThread> worker_;
+    std::atomic<bool> cancel_ { false };
+    bool running_ { false };
+};
+
+#endif // WEBSOCKETBENCHMARK_H
@@ -0,0 +1,220 @@
+#include "websocketconnection.h"
+#include "curlruntime.h"
+#include <QElapsedTimer>
+#include <cstring>
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <poll.h>
+#endif
+
+namespace {
+// 设置了中止标志时，等待套接字的最长一段，保证中止能及时生效
+constexpr int kAbortPollMs = 50;
+const char kAbortedError[] = "已取消";
+}
+
+WebSocketConnection::~WebSocketConnection()
+{
+    close();
+}
+
+bool WebSocketConnection::isSupported()
+{
+    const curl_version_info_data *info = curl_version_info(CURLVERSION_NOW);
+    for (const char *const *protocol = info->protocols; *protocol; ++protocol) {
+        if (std::strcmp(*protocol, "ws") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WebSocketConnection::open(const ProxyOptions &proxy, const QString &url, int timeoutMs)
+{
+    close();
+    error_.clear();
+    if (!isSupported()) {
+        error_ = "当前libcurl未启用WebSocket支持";
+        return false;
+    }
+
+    CurlRuntime::ensureInitialized();
+    curl_ = curl_easy_init();
+    if (!curl_) {
+        error_ = "初始化curl失败";
+        return false;
+    }
+
+    // 升级请求不需要内容编码协商
+    ProxyOptions options = proxy;
+    options.compression = false;
+    applyProxyOptions(curl_, options);
+    curl_easy_setopt(curl_, CURLOPT_URL, url.toUtf8().constData());
+    // 2表示完成HTTP升级握手后把连接交给调用方，之后用curl_ws_send/curl_ws_recv收发帧
+    curl_easy_setopt(curl_, CURLOPT_CONNECT_ONLY, 2L);
+    curl_easy_setopt(curl_, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(timeoutMs));
+    char errorBuffer[CURL_ERROR_SIZE] = {};
+    curl_easy_setopt(curl_, CURLOPT_ERRORBUFFER, errorBuffer);
+    if (abort_) {
+        curl_easy_setopt(curl_, CURLOPT_NOPROGRESS, 0L);
+        curl_easy_setopt(curl_, CURLOPT_XFERINFOFUNCTION, &WebSocketConnection::abortCallback);
+        curl_easy_setopt(curl_, CURLOPT_XFERINFODATA, this);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const CURLcode rc = curl_easy_perform(curl_);
+    handshakeMs_ = timer.elapsed();
+    curl_easy_setopt(curl_, CURLOPT_ERRORBUFFER, nullptr);
+
+    if (rc != CURLE_OK) {
+        error_ = aborted() ? QString(kAbortedError)
+                 : errorBuffer[0] ? QString::fromUtf8(errorBuffer) : QString::fromUtf8(curl_easy_strerror(rc));
+        long status = 0;
+        curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &status);
+        if (status > 0 && status != 101) {
+            error_ += QString(" (HTTP %1，服务器未接受WebSocket升级)").arg(status);
+        }
+        curl_easy_cleanup(curl_);
+        curl_ = nullptr;
+        return false;
+    }
+
+    curl_easy_getinfo(curl_, CURLINFO_ACTIVESOCKET, &socket_);
+    return true;
+}
+
+void WebSocketConnection::close()
+{
+    if (!curl_) {
+        return;
+    }
+    // 尽力发送关闭帧（状态码1000，正常关闭），不等待对方回应
+    const char normalClosure[] = { '\x03', '\xE8' };
+    size_t sent = 0;
+    curl_ws_send(curl_, normalClosure, sizeof(normalClosure), &sent, 0, CURLWS_CLOSE);
+    curl_easy_cleanup(curl_);
+    curl_ = nullptr;
+    socket_ = CURL_SOCKET_BAD;
+}
+
+bool WebSocketConnection::send(const QByteArray &payload, int flags, int timeoutMs)
+{
+    error_.clear();
+    if (!curl_) {
+        error_ = "连接未打开";
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    qsizetype offset = 0;
+    // 空负载（例如ping）也要发送一次
+    do {
+        size_t sent = 0;
+        const CURLcode rc = curl_ws_send(curl_, payload.constData() + offset,
+                                         static_cast<size_t>(payload.size() - offset), &sent, 0,
+                                         static_cast<unsigned int>(flags));
+        if (rc == CURLE_AGAIN) {
+            const qint64 remaining = timeoutMs - timer.elapsed();
+            if (remaining <= 0 || !waitSocket(false, static_cast<int>(remaining))) {
+                error_ = aborted() ? kAbortedError : "发送超时";
+                return false;
+            }
+            continue;
+        }
+        if (rc != CURLE_OK) {
+            error_ = QString::fromUtf8(curl_easy_strerror(rc));
+            return false;
+        }
+        offset += static_cast<qsizetype>(sent);
+    } while (offset < payload.size());
+    return true;
+}
+
+bool WebSocketConnection::receive(Frame *frame, int timeoutMs)
+{
+    error_.clear();
+    frame->payload.clear();
+    frame->flags = 0;
+    if (!curl_) {
+        error_ = "连接未打开";
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    char buffer[16 * 1024];
+    for (;;) {
+        size_t received = 0;
+        const struct curl_ws_frame *meta = nullptr;
+        // TLS层可能已缓存了数据，先读再等待套接字
+        const CURLcode rc = curl_ws_recv(curl_, buffer, sizeof(buffer), &received, &meta);
+        if (rc == CURLE_AGAIN) {
+            const qint64 remaining = timeoutMs - timer.elapsed();
+            if (remaining <= 0 || !waitSocket(true, static_cast<int>(remaining))) {
+                if (aborted()) {
+                    error_ = kAbortedError;
+                } else if (!frame->payload.isEmpty()) {
+                    error_ = "接收帧超时";
+                }
+                return false;
+            }
+            continue;
+        }
+        if (rc != CURLE_OK) {
+            error_ = QString::fromUtf8(curl_easy_strerror(rc));
+            return false;
+        }
+
+        frame->payload.append(buffer, static_cast<qsizetype>(received));
+        frame->flags |= meta->flags;
+        if (meta->bytesleft == 0 && !(meta->flags & CURLWS_CONT)) {
+            frame->flags &= ~CURLWS_CONT;
+            return true;
+        }
+    }
+}
+
+int WebSocketConnection::abortCallback(void *clientp, curl_off_t, curl_off_t, curl_off_t, curl_off_t)
+{
+    return static_cast<WebSocketConnection *>(clientp)->aborted() ? 1 : 0;
+}
+
+bool WebSocketConnection::waitSocket(bool forRead, int timeoutMs) const
+{
+    if (socket_ == CURL_SOCKET_BAD) {
+        return false;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    for (;;) {
+        if (aborted()) {
+            return false;
+        }
+        const qint64 remaining = timeoutMs - timer.elapsed();
+        if (remaining <= 0) {
+            return false;
+        }
+        const int sliceMs = static_cast<int>(abort_ ? qMin<qint64>(remaining, kAbortPollMs) : remaining);
+#ifdef _WIN32
+        fd_set set;
+        FD_ZERO(&set);
+        FD_SET(socket_, &set);
+        timeval timeout;
+        timeout.tv_sec = sliceMs / 1000;
+        timeout.tv_usec = (sliceMs % 1000) * 1000;
+        const int ready = select(0, forRead ? &set : nullptr, forRead ? nullptr : &set, nullptr, &timeout);
+#else
+        pollfd descriptor;
+        descriptor.fd = socket_;
+        descriptor.events = forRead ? POLLIN : POLLOUT;
+        descriptor.revents = 0;
+        const int ready = poll(&descriptor, 1, sliceMs);
+#endif
+        if (ready != 0) {
+            return ready > 0;
+        }
+    }
+}
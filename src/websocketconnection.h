@@ -0,0 +1,59 @@
+#ifndef WEBSOCKETCONNECTION_H
+#define WEBSOCKETCONNECTION_H
+
+#include <QByteArray>
+#include <QString>
+#include <curl/curl.h>
+#include <atomic>
+#include "proxyoptions.h"
+
+// 经EasyProxy的CONNECT隧道建立的WebSocket连接（CONNECT_ONLY=2，由调用方自己收发帧）。
+// 收发都是阻塞的，只在测试工具的工作线程上使用
+class WebSocketConnection
+{
+public:
+    struct Frame
+    {
+        QByteArray payload;
+        int flags { 0 };    // CURLWS_TEXT/BINARY/PING/PONG/CLOSE
+    };
+
+    WebSocketConnection() = default;
+    ~WebSocketConnection();
+    WebSocketConnection(const WebSocketConnection &) = delete;
+    WebSocketConnection &operator=(const WebSocketConnection &) = delete;
+
+    // 当前libcurl是否编译了ws/wss支持
+    static bool isSupported();
+
+    // 由其他线程置位以中止阻塞中的握手和收发：等待时分小段检查，置位后失败返回，errorString为"已取消"。
+    // 标志的生命周期须覆盖本对象
+    void setAbortFlag(const std::atomic<bool> *flag) { abort_ = flag; }
+
+    // 完成CONNECT隧道、TLS和HTTP升级握手
+    bool open(const ProxyOptions &proxy, const QString &url, int timeoutMs = 15'000);
+    void close();
+    bool isOpen() const { return curl_ != nullptr; }
+
+    // 发送一个完整的帧，flags为CURLWS_BINARY、CURLWS_TEXT或CURLWS_PING等
+    bool send(const QByteArray &payload, int flags, int timeoutMs = 5'000);
+    // 接收一个完整的帧（分片会被合并）；timeoutMs内没有数据返回false且errorString为空
+    bool receive(Frame *frame, int timeoutMs);
+
+    QString errorString() const { return error_; }
+    // 握手耗时，包括隧道和TLS
+    qint64 handshakeMs() const { return handshakeMs_; }
+
+private:
+    static int abortCallback(void *clientp, curl_off_t, curl_off_t, curl_off_t, curl_off_t);
+    bool aborted() const { return abort_ && abort_->load(); }
+    bool waitSocket(bool forRead, int timeoutMs) const;
+
+    CURL *curl_ { nullptr };
+    curl_socket_t socket_ { CURL_SOCKET_BAD };
+    QString error_;
+    qint64 handshakeMs_ { 0 };
+    const std::atomic<bool> *abort_ { nullptr };
+};
+
+#endif // WEBSOCKETCONNECTION_H
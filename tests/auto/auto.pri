@@ -0,0 +1,12 @@
+# 各测试共用的配置，被测源文件直接从src/编译进测试程序
+QT += testlib
+QT -= gui
+
+CONFIG += testcase console c++11
+CONFIG -= app_bundle
+
+SRC_DIR = $$PWD/../../src
+INCLUDEPATH += $$SRC_DIR $$PWD/../../depend/libcurl/include
+
+# 部分被测代码调用libcurl的工具函数（例如curl_getdate）
+LIBS += -L$$PWD/../../depend/libcurl/lib -llibcurl
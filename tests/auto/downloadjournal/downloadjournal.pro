@@ -0,0 +1,10 @@
+include(../auto.pri)
+
+TARGET = tst_downloadjournal
+
+SOURCES += \
+    tst_downloadjournal.cpp \
+    $$SRC_DIR/downloadjournal.cpp
+
+HEADERS += \
+    $$SRC_DIR/downloadjournal.h
@@ -0,0 +1,206 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include "downloadjournal.h"
+
+class TestDownloadJournal : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void roundTrip();
+    void validatorWithSpaces();
+    void crlfAndUnknownKeys();
+    void missingFile();
+    void wrongMagic();
+    void malformedRange();
+    void invalidRangeValues();
+    void missingRequiredFields();
+    void loadResetsPreviousState();
+    void matchesRequiresValidator();
+    void completedBytes();
+
+private:
+    // 直接写日志文件内容，模拟旧版本或损坏的日志
+    void writeRaw(const QByteArray &content);
+
+    QTemporaryDir dir_;
+    QString output_;
+};
+
+void TestDownloadJournal::init()
+{
+    QVERIFY(dir_.isValid());
+    output_ = dir_.filePath("file.bin");
+    DownloadJournal::remove(output_);
+}
+
+void TestDownloadJournal::writeRaw(const QByteArray &content)
+{
+    QFile file(DownloadJournal::pathFor(output_));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(content);
+}
+
+void TestDownloadJournal::roundTrip()
+{
+    DownloadJournal journal;
+    journal.url = "https://example.com/大文件.iso";
+    journal.validator = "\"abc123\"";
+    journal.size = 5'000'000'000;
+    journal.ranges << DownloadJournal::Range { 0, 2'500'000'000, 1'000 }
+                   << DownloadJournal::Range { 2'500'000'000, 2'500'000'000, 2'500'000'000 };
+    QVERIFY(journal.save(output_));
+
+    DownloadJournal loaded;
+    QVERIFY(loaded.load(output_));
+    QCOMPARE(loaded.url, journal.url);
+    QCOMPARE(loaded.validator, journal.validator);
+    QCOMPARE(loaded.size, journal.size);
+    QCOMPARE(loaded.ranges.size(), qsizetype(2));
+    QCOMPARE(loaded.ranges.at(1).offset, qint64(2'500'000'000));
+    QCOMPARE(loaded.ranges.at(1).length, qint64(2'500'000'000));
+    QCOMPARE(loaded.ranges.at(0).written, qint64(1'000));
+
+    DownloadJournal::remove(output_);
+    QVERIFY(!QFile::exists(DownloadJournal::pathFor(output_)));
+}
+
+void TestDownloadJournal::validatorWithSpaces()
+{
+    // Last-Modified作验证器时含空格，只按第一个空格切分键和值
+    DownloadJournal journal;
+    journal.url = "https://example.com/a";
+    journal.validator = "Wed, 21 Oct 2015 07:28:00 GMT";
+    journal.size = 10;
+    journal.ranges << DownloadJournal::Range { 0, 10, 4 };
+    QVERIFY(journal.save(output_));
+
+    DownloadJournal loaded;
+    QVERIFY(loaded.load(output_));
+    QCOMPARE(loaded.validator, journal.validator);
+}
+
+void TestDownloadJournal::crlfAndUnknownKeys()
+{
+    writeRaw("EPJOURNAL 1\r\n"
+             "url https://example.com/a\r\n"
+             "future-key something\r\n"
+             "validator \"v\"\r\n"
+             "size 100\r\n"
+             "\r\n"
+             "range 0 100 50\r\n");
+    DownloadJournal journal;
+    QVERIFY(journal.load(output_));
+    QCOMPARE(journal.url, QString("https://example.com/a"));
+    QCOMPARE(journal.validator, QString("\"v\""));
+    QCOMPARE(journal.ranges.size(), qsizetype(1));
+    QCOMPARE(journal.ranges.first().written, qint64(50));
+}
+
+void TestDownloadJournal::missingFile()
+{
+    DownloadJournal journal;
+    QVERIFY(!journal.load(output_));
+}
+
+void TestDownloadJournal::wrongMagic()
+{
+    writeRaw("EPJOURNAL 2\nurl https://example.com/a\nsize 10\nrange 0 10 0\n");
+    DownloadJournal journal;
+    QVERIFY(!journal.load(output_));
+
+    writeRaw(QByteArray());
+    QVERIFY(!journal.load(output_));
+}
+
+void TestDownloadJournal::malformedRange()
+{
+    writeRaw("EPJOURNAL 1\nurl https://example.com/a\nsize 10\nrange 0 10\n");
+    DownloadJournal journal;
+    QVERIFY(!journal.load(output_));
+
+    writeRaw("EPJOURNAL 1\nurl https://example.com/a\nsize 10\nrange 0 10 0 0\n");
+    QVERIFY(!journal.load(output_));
+}
+
+void TestDownloadJournal::invalidRangeValues()
+{
+    const QByteArray header = "EPJOURNAL 1\nurl https://example.com/a\nsize 10\n";
+    DownloadJournal journal;
+
+    // 已写入的字节不能超过段长
+    writeRaw(header + "range 0 10 11\n");
+    QVERIFY(!journal.load(output_));
+
+    writeRaw(header + "range -1 10 0\n");
+    QVERIFY(!journal.load(output_));
+
+    writeRaw(header + "range 0 0 0\n");
+    QVERIFY(!journal.load(output_));
+
+    writeRaw(header + "range 0 10 -1\n");
+    QVERIFY(!journal.load(output_));
+
+    writeRaw(header + "range 0 10 10\n");
+    QVERIFY(journal.load(output_));
+}
+
+void TestDownloadJournal::missingRequiredFields()
+{
+    DownloadJournal journal;
+
+    writeRaw("EPJOURNAL 1\nsize 10\nrange 0 10 0\n");
+    QVERIFY(!journal.load(output_));
+
+    writeRaw("EPJOURNAL 1\nurl https://example.com/a\nrange 0 10 0\n");
+    QVERIFY(!journal.load(output_));
+
+    writeRaw("EPJOURNAL 1\nurl https://example.com/a\nsize 10\n");
+    QVERIFY(!journal.load(output_));
+
+    // 验证器可以为空，save()写出的是"validator "，读回时整行被跳过
+    writeRaw("EPJOURNAL 1\nurl https://example.com/a\nvalidator \nsize 10\nrange 0 10 0\n");
+    QVERIFY(journal.load(output_));
+    QVERIFY(journal.validator.isEmpty());
+}
+
+void TestDownloadJournal::loadResetsPreviousState()
+{
+    writeRaw("EPJOURNAL 1\nurl https://example.com/a\nsize 10\nrange 0 10 3\n");
+    DownloadJournal journal;
+    journal.validator = "stale";
+    journal.ranges << DownloadJournal::Range { 0, 5, 5 };
+    QVERIFY(journal.load(output_));
+    QVERIFY(journal.validator.isEmpty());
+    QCOMPARE(journal.ranges.size(), qsizetype(1));
+    QCOMPARE(journal.completedBytes(), qint64(3));
+}
+
+void TestDownloadJournal::matchesRequiresValidator()
+{
+    DownloadJournal journal;
+    journal.url = "https://example.com/a";
+    journal.validator = "\"v\"";
+    journal.size = 10;
+    QVERIFY(journal.matches("https://example.com/a", 10, "\"v\""));
+    QVERIFY(!journal.matches("https://example.com/b", 10, "\"v\""));
+    QVERIFY(!journal.matches("https://example.com/a", 11, "\"v\""));
+    QVERIFY(!journal.matches("https://example.com/a", 10, "\"w\""));
+
+    // 没有验证器无法确认文件未变，不续传
+    journal.validator.clear();
+    QVERIFY(!journal.matches("https://example.com/a", 10, QString()));
+}
+
+void TestDownloadJournal::completedBytes()
+{
+    DownloadJournal journal;
+    QCOMPARE(journal.completedBytes(), qint64(0));
+    journal.ranges << DownloadJournal::Range { 0, 100, 100 } << DownloadJournal::Range { 100, 100, 40 };
+    QCOMPARE(journal.completedBytes(), qint64(140));
+}
+
+QTEST_APPLESS_MAIN(TestDownloadJournal)
+
+#include "tst_downloadjournal.moc"
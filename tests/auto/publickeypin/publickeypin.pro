@@ -0,0 +1,16 @@
+include(../auto.pri)
+
+QT += concurrent
+
+TARGET = tst_publickeypin
+
+SOURCES += \
+    tst_publickeypin.cpp \
+    $$SRC_DIR/curlruntime.cpp \
+    $$SRC_DIR/publickeypin.cpp \
+    $$SRC_DIR/startupprofiler.cpp
+
+HEADERS += \
+    $$SRC_DIR/curlruntime.h \
+    $$SRC_DIR/publickeypin.h \
+    $$SRC_DIR/startupprofiler.h
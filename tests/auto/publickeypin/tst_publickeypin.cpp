@@ -0,0 +1,112 @@
+#include <QtTest>
+#include "publickeypin.h"
+
+namespace {
+// 同一把P-256密钥的两张自签名证书：v3带扩展，v1没有[0] version字段
+const QByteArray kCertificateV3 =
+    "-----BEGIN CERTIFICATE-----\n"
+    "MIIBgTCCASegAwIBAgIUGBhmbGz2gSGrzHxyvI71p31GYkIwCgYIKoZIzj0EAwIw\n"
+    "FTETMBEGA1UEAwwKcHJveHkudGVzdDAgFw0yNjEwMTgxMTM5MjRaGA8yMTI2MDky\n"
+    "NDExMzkyNFowFTETMBEGA1UEAwwKcHJveHkudGVzdDBZMBMGByqGSM49AgEGCCqG\n"
+    "SM49AwEHA0IABGcAh1FgVEfCp+XYkP38kp2Yuk9Wi0LHUtzi0Xsp0ktdtSkoBU6t\n"
+    "Pbu65W93zw0wWvjqtvh6csau4MDSPek4A46jUzBRMB0GA1UdDgQWBBSAXEkdxRUg\n"
+    "TmdOiUveFTDWzV21xzAfBgNVHSMEGDAWgBSAXEkdxRUgTmdOiUveFTDWzV21xzAP\n"
+    "BgNVHRMBAf8EBTADAQH/MAoGCCqGSM49BAMCA0gAMEUCIFO2kF+TM9uxUsXfoB3i\n"
+    "Jr5mwVe0Fa4atiECuUA5FyQaAiEAlLdMOTJQefjtGcbwi48bX1uonD9BgiAAKtd7\n"
+    "IQJLA9Q=\n"
+    "-----END CERTIFICATE-----\n";
+
+const QByteArray kCertificateV1 =
+    "-----BEGIN CERTIFICATE-----\n"
+    "MIIBJTCBzQIUblzjccouoh7FVwaCPlEic291YMswCgYIKoZIzj0EAwIwFTETMBEG\n"
+    "A1UEAwwKcHJveHkudGVzdDAgFw0yNjEwMTgxMTM5MjRaGA8yMTI2MDkyNDExMzky\n"
+    "NFowFTETMBEGA1UEAwwKcHJveHkudGVzdDBZMBMGByqGSM49AgEGCCqGSM49AwEH\n"
+    "A0IABGcAh1FgVEfCp+XYkP38kp2Yuk9Wi0LHUtzi0Xsp0ktdtSkoBU6tPbu65W93\n"
+    "zw0wWvjqtvh6csau4MDSPek4A44wCgYIKoZIzj0EAwIDRwAwRAIgQYSRiu3jBYVw\n"
+    "DGDn457vKEEleE7iAOPwiVOUlACoE50CIAUeqqRCtwh7jRWbfaYN2B/vhqSEILsB\n"
+    "hw8cgLsXy/+T\n"
+    "-----END CERTIFICATE-----\n";
+
+// openssl x509 -pubkey -noout | openssl pkey -pubin -outform der | openssl dgst -sha256 -binary | base64
+const QString kExpectedPin = "sha256//Y50NHpZcG4zEK7Jp0FGLbhZYDRWPqPqw8wjLNPFtArE=";
+
+QByteArray derOf(const QByteArray &pem)
+{
+    const QByteArray begin = "-----BEGIN CERTIFICATE-----";
+    const qsizetype from = pem.indexOf(begin) + begin.size();
+    return QByteArray::fromBase64(pem.mid(from, pem.indexOf("-----END") - from));
+}
+}
+
+class TestPublicKeyPin : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void pemV3();
+    void pemV1WithoutVersion();
+    void der();
+    void pemWithSurroundingText();
+    void notACertificate();
+    void truncatedDer();
+    void missingEndMarker();
+};
+
+void TestPublicKeyPin::pemV3()
+{
+    QString error;
+    QCOMPARE(publicKeyPinFromCertificate(kCertificateV3, &error), kExpectedPin);
+    QVERIFY(error.isEmpty());
+}
+
+void TestPublicKeyPin::pemV1WithoutVersion()
+{
+    // 固定的是公钥而不是证书，同一密钥重新签发的证书得到相同的值
+    QCOMPARE(publicKeyPinFromCertificate(kCertificateV1), kExpectedPin);
+}
+
+void TestPublicKeyPin::der()
+{
+    QCOMPARE(publicKeyPinFromCertificate(derOf(kCertificateV3)), kExpectedPin);
+    QCOMPARE(publicKeyPinFromCertificate(derOf(kCertificateV1)), kExpectedPin);
+}
+
+void TestPublicKeyPin::pemWithSurroundingText()
+{
+    // CERTINFO的Cert:字段和openssl输出的文件都可能在PEM前后带其他文本
+    const QByteArray text = "subject=CN = proxy.test\r\n" + kCertificateV3 + "trailing\n";
+    QCOMPARE(publicKeyPinFromCertificate(text), kExpectedPin);
+}
+
+void TestPublicKeyPin::notACertificate()
+{
+    QString error;
+    QVERIFY(publicKeyPinFromCertificate("not a certificate", &error).isEmpty());
+    QVERIFY(!error.isEmpty());
+
+    error.clear();
+    QVERIFY(publicKeyPinFromCertificate(QByteArray(), &error).isEmpty());
+    QVERIFY(!error.isEmpty());
+}
+
+void TestPublicKeyPin::truncatedDer()
+{
+    const QByteArray der = derOf(kCertificateV3);
+    for (qsizetype size : { qsizetype(1), qsizetype(16), der.size() / 2, der.size() - 1 }) {
+        QString error;
+        QVERIFY2(publicKeyPinFromCertificate(der.left(size), &error).isEmpty(), qPrintable(QString::number(size)));
+        QVERIFY(!error.isEmpty());
+    }
+}
+
+void TestPublicKeyPin::missingEndMarker()
+{
+    const QByteArray pem = kCertificateV3.left(kCertificateV3.indexOf("-----END"));
+    QString error;
+    QVERIFY(publicKeyPinFromCertificate(pem, &error).isEmpty());
+    QVERIFY(!error.isEmpty());
+}
+
+QTEST_APPLESS_MAIN(TestPublicKeyPin)
+
+#include "tst_publickeypin.moc"
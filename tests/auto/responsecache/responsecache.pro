@@ -0,0 +1,12 @@
+include(../auto.pri)
+
+TARGET = tst_responsecache
+
+SOURCES += \
+    tst_responsecache.cpp \
+    $$SRC_DIR/bufferpool.cpp \
+    $$SRC_DIR/responsecache.cpp
+
+HEADERS += \
+    $$SRC_DIR/bufferpool.h \
+    $$SRC_DIR/responsecache.h
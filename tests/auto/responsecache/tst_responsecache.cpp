@@ -0,0 +1,225 @@
+#include <QtTest>
+#include <QDateTime>
+#include <QLocale>
+#include <QTemporaryDir>
+#include "responsecache.h"
+
+namespace {
+// 固定的响应时间，避免测试结果依赖当前时钟
+constexpr qint64 T = 1'700'000'000;
+
+QString httpDate(qint64 seconds)
+{
+    return QLocale::c().toString(QDateTime::fromSecsSinceEpoch(seconds, Qt::UTC),
+                                 "ddd, dd MMM yyyy hh:mm:ss 'GMT'");
+}
+
+ResponseCache::ResponseInfo info200()
+{
+    ResponseCache::ResponseInfo info;
+    info.status = 200;
+    info.date = httpDate(T);
+    return info;
+}
+
+ResponseCache::Freshness freshness(const ResponseCache::ResponseInfo &info)
+{
+    return ResponseCache::computeFreshness(info, T * 1000, T * 1000);
+}
+}
+
+class TestResponseCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void noStore();
+    void maxAge();
+    void quotedMaxAge();
+    void maxAgeBeatsExpires();
+    void expiresRelativeToDate();
+    void invalidExpires();
+    void heuristicFromLastModified();
+    void heuristicCapped();
+    void revalidationFlags();
+    void vary();
+    void initialAge();
+    void evictedBodyStaysReadable();
+    void sharedBodyCountedOnce();
+};
+
+void TestResponseCache::noStore()
+{
+    ResponseCache::ResponseInfo info = info200();
+    info.cacheControl = "max-age=60, no-store";
+    QVERIFY(!freshness(info).storable);
+}
+
+void TestResponseCache::maxAge()
+{
+    ResponseCache::ResponseInfo info = info200();
+    info.cacheControl = "public, Max-Age=60";
+    const ResponseCache::Freshness f = freshness(info);
+    QVERIFY(f.storable);
+    QCOMPARE(f.lifetimeSeconds, qint64(60));
+    QCOMPARE(f.flags, quint8(0));
+}
+
+void TestResponseCache::quotedMaxAge()
+{
+    ResponseCache::ResponseInfo info = info200();
+    info.cacheControl = "max-age=\"30\"";
+    QCOMPARE(freshness(info).lifetimeSeconds, qint64(30));
+}
+
+void TestResponseCache::maxAgeBeatsExpires()
+{
+    ResponseCache::ResponseInfo info = info200();
+    info.cacheControl = "max-age=10";
+    info.expires = httpDate(T + 3600);
+    QCOMPARE(freshness(info).lifetimeSeconds, qint64(10));
+}
+
+void TestResponseCache::expiresRelativeToDate()
+{
+    // 按Date而不是本机时间计算，服务器时钟偏差不影响有效期
+    ResponseCache::ResponseInfo info = info200();
+    info.date = httpDate(T - 500);
+    info.expires = httpDate(T - 500 + 120);
+    QCOMPARE(freshness(info).lifetimeSeconds, qint64(120));
+
+    info.expires = httpDate(T - 1000);
+    QCOMPARE(freshness(info).lifetimeSeconds, qint64(0));
+}
+
+void TestResponseCache::invalidExpires()
+{
+    ResponseCache::ResponseInfo info = info200();
+    info.expires = "0";
+    info.lastModified = httpDate(T - 10000);
+    const ResponseCache::Freshness f = freshness(info);
+    QVERIFY(f.storable);
+    QCOMPARE(f.lifetimeSeconds, qint64(0));
+}
+
+void TestResponseCache::heuristicFromLastModified()
+{
+    ResponseCache::ResponseInfo info = info200();
+    info.lastModified = httpDate(T - 10000);
+    QCOMPARE(freshness(info).lifetimeSeconds, qint64(1000));
+
+    // Last-Modified不早于Date时没有启发式有效期
+    info.lastModified = httpDate(T + 10);
+    QCOMPARE(freshness(info).lifetimeSeconds, qint64(0));
+}
+
+void TestResponseCache::heuristicCapped()
+{
+    ResponseCache::ResponseInfo info = info200();
+    info.lastModified = httpDate(T - 365LL * 24 * 3600);
+    QCOMPARE(freshness(info).lifetimeSeconds, qint64(24 * 3600));
+}
+
+void TestResponseCache::revalidationFlags()
+{
+    ResponseCache::ResponseInfo info = info200();
+    info.cacheControl = "no-cache, must-revalidate, max-age=60";
+    const ResponseCache::Freshness f = freshness(info);
+    QVERIFY(f.storable);
+    QCOMPARE(f.flags, quint8(ResponseCache::NoCache | ResponseCache::MustRevalidate));
+}
+
+void TestResponseCache::vary()
+{
+    ResponseCache::ResponseInfo info = info200();
+    info.cacheControl = "max-age=60";
+    info.vary = " accept-encoding ";
+    QVERIFY(freshness(info).storable);
+
+    info.vary = "Accept-Encoding, Cookie";
+    QVERIFY(!freshness(info).storable);
+
+    info.vary = "*";
+    QVERIFY(!freshness(info).storable);
+}
+
+void TestResponseCache::initialAge()
+{
+    ResponseCache::ResponseInfo info = info200();
+    info.cacheControl = "max-age=600";
+
+    // 表观年龄：响应到达时间减去Date
+    info.date = httpDate(T - 30);
+    QCOMPARE(freshness(info).initialAgeSeconds, qint64(30));
+
+    // Age加上请求往返时间更大时取后者
+    info.date = httpDate(T);
+    info.age = "100";
+    const ResponseCache::Freshness f = ResponseCache::computeFreshness(info, (T - 5) * 1000, T * 1000);
+    QCOMPARE(f.initialAgeSeconds, qint64(105));
+}
+
+void TestResponseCache::evictedBodyStaysReadable()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    ResponseCache cache(dir.path(), 1024 * 1024);
+    QVERIFY(cache.isOpen());
+
+    const QString url = "http://example.com/a";
+    const QByteArray content = "cached body";
+    ResponseCache::ResponseInfo info = info200();
+    info.cacheControl = "max-age=600";
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    info.date = httpDate(nowMs / 1000);
+    BodyBuffer body;
+    QVERIFY(body.append(content.constData(), content.size()));
+    cache.store(url, info, body, nowMs, nowMs);
+
+    const ResponseCache::Entry entry = cache.lookup(url);
+    QVERIFY(entry.valid);
+    QVERIFY(entry.fresh);
+    QVERIFY(entry.bodyFile);
+
+    // 淘汰全部条目：已经交出去的响应体仍然可以读取，之后的查询不再命中
+    cache.setMaxBytes(0);
+    QCOMPARE(entry.bodyFile->readAll(), content);
+    QVERIFY(!cache.lookup(url).valid);
+}
+
+void TestResponseCache::sharedBodyCountedOnce()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    ResponseCache cache(dir.path(), 1024 * 1024);
+    QVERIFY(cache.isOpen());
+
+    const QByteArray content = "shared body";
+    ResponseCache::ResponseInfo info = info200();
+    info.cacheControl = "max-age=600";
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    info.date = httpDate(nowMs / 1000);
+    BodyBuffer body;
+    QVERIFY(body.append(content.constData(), content.size()));
+
+    // 两个URL共用一份响应体，同一URL重复存入只保留一条记录
+    cache.store("http://example.com/a", info, body, nowMs, nowMs);
+    cache.store("http://example.com/b", info, body, nowMs, nowMs);
+    cache.store("http://example.com/a", info, body, nowMs, nowMs);
+    QCOMPARE(cache.stats().entries, 2);
+    QCOMPARE(cache.stats().bytes, qint64(content.size()));
+
+    // 删掉其中一条后文件仍被另一条引用
+    ResponseCache::ResponseInfo noStore = info;
+    noStore.cacheControl = "no-store";
+    cache.store("http://example.com/a", noStore, body, nowMs, nowMs);
+    QCOMPARE(cache.stats().entries, 1);
+    QCOMPARE(cache.stats().bytes, qint64(content.size()));
+    const ResponseCache::Entry entry = cache.lookup("http://example.com/b");
+    QVERIFY(entry.valid);
+    QCOMPARE(entry.bodyFile->readAll(), content);
+}
+
+QTEST_APPLESS_MAIN(TestResponseCache)
+
+#include "tst_responsecache.moc"
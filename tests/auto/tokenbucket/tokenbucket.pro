@@ -0,0 +1,10 @@
+include(../auto.pri)
+
+TARGET = tst_tokenbucket
+
+SOURCES += \
+    tst_tokenbucket.cpp \
+    $$SRC_DIR/tokenbucket.cpp
+
+HEADERS += \
+    $$SRC_DIR/tokenbucket.h
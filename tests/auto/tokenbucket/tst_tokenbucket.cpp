@@ -0,0 +1,92 @@
+#include <QtTest>
+#include "tokenbucket.h"
+
+class TestTokenBucket : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void unlimited();
+    void startsWithOneToken();
+    void refillsAtRate();
+    void burstCappedAtOneSecond();
+    void fractionalRate();
+    void reconfigureClampsTokens();
+};
+
+void TestTokenBucket::unlimited()
+{
+    TokenBucket bucket;
+    bucket.configure(0, 0);
+    for (int i = 0; i < 1000; ++i) {
+        QVERIFY(bucket.available(0));
+        bucket.take();
+    }
+    QCOMPARE(bucket.msUntilAvailable(), qint64(0));
+}
+
+void TestTokenBucket::startsWithOneToken()
+{
+    // 新配置的桶只有一个令牌，不会在启动瞬间放出整秒的突发
+    TokenBucket bucket;
+    bucket.configure(5, 0);
+    QVERIFY(bucket.available(0));
+    bucket.take();
+    QVERIFY(!bucket.available(0));
+    QCOMPARE(bucket.msUntilAvailable(), qint64(200));
+}
+
+void TestTokenBucket::refillsAtRate()
+{
+    TokenBucket bucket;
+    bucket.configure(5, 1000);
+    QVERIFY(bucket.available(1000));
+    bucket.take();
+
+    QVERIFY(!bucket.available(1100));
+    QCOMPARE(bucket.msUntilAvailable(), qint64(100));
+    QVERIFY(bucket.available(1200));
+}
+
+void TestTokenBucket::burstCappedAtOneSecond()
+{
+    // 空闲再久也只攒一秒的令牌
+    TokenBucket bucket;
+    bucket.configure(5, 0);
+    for (int i = 0; i < 5; ++i) {
+        QVERIFY(bucket.available(10000));
+        bucket.take();
+    }
+    QVERIFY(!bucket.available(10000));
+}
+
+void TestTokenBucket::fractionalRate()
+{
+    // 低于每秒1个时容量仍为1个令牌
+    TokenBucket bucket;
+    bucket.configure(0.5, 0);
+    QVERIFY(bucket.available(60000));
+    bucket.take();
+    QVERIFY(!bucket.available(60000));
+    QCOMPARE(bucket.msUntilAvailable(), qint64(2000));
+    QVERIFY(!bucket.available(61000));
+}
+
+void TestTokenBucket::reconfigureClampsTokens()
+{
+    TokenBucket bucket;
+    bucket.configure(10, 0);
+    QVERIFY(bucket.available(5000));
+
+    // 降低速率时多余的令牌作废
+    bucket.configure(2, 5000);
+    for (int i = 0; i < 2; ++i) {
+        QVERIFY(bucket.available(5000));
+        bucket.take();
+    }
+    QVERIFY(!bucket.available(5000));
+}
+
+QTEST_APPLESS_MAIN(TestTokenBucket)
+
+#include "tst_tokenbucket.moc"
@@ -0,0 +1,10 @@
+include(../auto.pri)
+
+TARGET = tst_transfereventqueue
+
+SOURCES += \
+    tst_transfereventqueue.cpp \
+    $$SRC_DIR/transfereventqueue.cpp
+
+HEADERS += \
+    $$SRC_DIR/transfereventqueue.h
@@ -0,0 +1,162 @@
+#include <QtTest>
+#include <memory>
+#include "transfereventqueue.h"
+
+namespace {
+// 占满n条记录的一行
+QString lineOfRecords(int records, QChar fill = QLatin1Char('x'))
+{
+    return QString(records * TransferEventQueue::kTextBytes, fill);
+}
+}
+
+class TestTransferEventQueue : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void singleLines();
+    void emptyLine();
+    void longLineSpansRecords();
+    void multiByteSplitAcrossRecords();
+    void wrapAround();
+    void longLineWrapsAroundEnd();
+    void fullRingDropsAndReports();
+    void finishedAfterLines();
+    void resetForReuse();
+
+private:
+    // 环有128 KB，放在堆上
+    std::unique_ptr<TransferEventQueue> queue_;
+};
+
+void TestTransferEventQueue::init()
+{
+    queue_.reset(new TransferEventQueue);
+}
+
+void TestTransferEventQueue::singleLines()
+{
+    QVERIFY(queue_->pushDebug("first"));
+    QVERIFY(queue_->pushDebug("second"));
+    QStringList lines;
+    QVERIFY(!queue_->drain(&lines));
+    QCOMPARE(lines, QStringList({ "first", "second" }));
+
+    lines.clear();
+    QVERIFY(!queue_->drain(&lines));
+    QVERIFY(lines.isEmpty());
+}
+
+void TestTransferEventQueue::emptyLine()
+{
+    QVERIFY(queue_->pushDebug(QString()));
+    QStringList lines;
+    queue_->drain(&lines);
+    QCOMPARE(lines, QStringList({ QString() }));
+}
+
+void TestTransferEventQueue::longLineSpansRecords()
+{
+    const QString line = lineOfRecords(3) + "tail";
+    QVERIFY(queue_->pushDebug(line));
+    QVERIFY(queue_->pushDebug("next"));
+    QStringList lines;
+    queue_->drain(&lines);
+    QCOMPARE(lines, QStringList({ line, "next" }));
+}
+
+void TestTransferEventQueue::multiByteSplitAcrossRecords()
+{
+    // 250不是3的倍数，三字节的汉字必然跨记录，消费者要拼完整后再解码
+    const QString line(200, QChar(0x4e2d));
+    QVERIFY(queue_->pushDebug(line));
+    QStringList lines;
+    queue_->drain(&lines);
+    QCOMPARE(lines, QStringList({ line }));
+}
+
+void TestTransferEventQueue::wrapAround()
+{
+    // 每轮写入后取出，下标绕环多圈
+    const quint32 rounds = TransferEventQueue::kCapacity * 3 + 7;
+    for (quint32 i = 0; i < rounds; ++i) {
+        const QString a = QString("line %1a").arg(i);
+        const QString b = QString("line %1b").arg(i);
+        QVERIFY(queue_->pushDebug(a));
+        QVERIFY(queue_->pushDebug(b));
+        QStringList lines;
+        queue_->drain(&lines);
+        QCOMPARE(lines, QStringList({ a, b }));
+    }
+}
+
+void TestTransferEventQueue::longLineWrapsAroundEnd()
+{
+    // 先把下标推到数组末尾前一条，再写一行占三条记录的长行，跨过数组末尾接回开头
+    QStringList lines;
+    for (quint32 i = 0; i + 1 < TransferEventQueue::kCapacity; ++i) {
+        QVERIFY(queue_->pushDebug("filler"));
+    }
+    queue_->drain(&lines);
+    QCOMPARE(lines.size(), qsizetype(TransferEventQueue::kCapacity - 1));
+
+    const QString line = lineOfRecords(2, QLatin1Char('a')) + lineOfRecords(1, QLatin1Char('b')).left(10);
+    QVERIFY(queue_->pushDebug(line));
+    lines.clear();
+    queue_->drain(&lines);
+    QCOMPARE(lines, QStringList({ line }));
+}
+
+void TestTransferEventQueue::fullRingDropsAndReports()
+{
+    for (quint32 i = 0; i < TransferEventQueue::kCapacity; ++i) {
+        QVERIFY(queue_->pushDebug(QString::number(i)));
+    }
+    // 环满时丢弃整行，不会只写入一部分
+    QVERIFY(!queue_->pushDebug("dropped"));
+    QVERIFY(!queue_->pushDebug(lineOfRecords(2)));
+
+    QStringList lines;
+    queue_->drain(&lines);
+    QCOMPARE(lines.size(), qsizetype(TransferEventQueue::kCapacity) + 1);
+    QCOMPARE(lines.first(), QString("0"));
+    QCOMPARE(lines.at(int(TransferEventQueue::kCapacity) - 1), QString::number(TransferEventQueue::kCapacity - 1));
+    QVERIFY(lines.last().contains("2"));
+
+    // 取出后又有空间
+    QVERIFY(queue_->pushDebug("again"));
+    lines.clear();
+    queue_->drain(&lines);
+    QCOMPARE(lines, QStringList({ "again" }));
+}
+
+void TestTransferEventQueue::finishedAfterLines()
+{
+    QVERIFY(queue_->pushDebug("last words"));
+    queue_->markFinished();
+    QStringList lines;
+    QVERIFY(queue_->drain(&lines));
+    QCOMPARE(lines, QStringList({ "last words" }));
+}
+
+void TestTransferEventQueue::resetForReuse()
+{
+    for (int i = 0; i < 10; ++i) {
+        QVERIFY(queue_->pushDebug("old"));
+    }
+    queue_->markFinished();
+    QStringList lines;
+    QVERIFY(queue_->drain(&lines));
+
+    queue_->reset();
+    QVERIFY(queue_->pushDebug("new"));
+    lines.clear();
+    QVERIFY(!queue_->drain(&lines));
+    QCOMPARE(lines, QStringList({ "new" }));
+}
+
+QTEST_APPLESS_MAIN(TestTransferEventQueue)
+
+#include "tst_transfereventqueue.moc"
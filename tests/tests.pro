@@ -0,0 +1,9 @@
+# 单元测试：qmake tests/tests.pro && make && make check
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    auto/tokenbucket \
+    auto/downloadjournal \
+    auto/responsecache \
+    auto/publickeypin \
+    auto/transfereventqueue